@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseMath.h"
+
+/** A named unit of work timed by the regression gate */
+struct BenchKernel
+{
+	/** Stable identifier stored in baseline files, e.g. "FBMNoise2D@2048" */
+	std::string name;
+
+	/** Pixels or samples produced by one call of run, used for throughput */
+	int64_t items = 0;
+
+	std::function<void()> run;
+};
+
+namespace BenchKernels
+{
+	/** Properties shared by the gate kernels and the Google Benchmark suite */
+	inline NoiseProperties MakeProps(bool bTurbulence)
+	{
+		NoiseProperties props{};
+		props.seed = 42;
+		props.roughness = 0.5f;
+		props.turbulence_res = 2;
+		props.turbulence_roughness = 0.5f;
+		if(bTurbulence)
+		{
+			props.turbulence = 0.5f;
+			props.turbulence_expshift = 0.5f;
+		}
+		return props;
+	}
+
+	inline std::string Name(const char* kernel, int res)
+	{
+		return std::string(kernel) + "@" + std::to_string(res);
+	}
+
+	/** Last consumed value; a volatile store the optimizer has to keep, with the work behind it */
+	inline volatile float Sink = 0.0f;
+
+	/** Keeps results observable so the optimizer cannot drop the work */
+	inline void Consume(float value)
+	{
+		Sink = value;
+	}
+
+	inline void Consume(const NoiseImage& data)
+	{
+		if(data) Consume(data[0]);
+	}
+
+	/**
+	 * Kernels tracked by the gate. Generators run single threaded unless the name says
+	 * otherwise, so results compare across machines with different core counts.
+	 */
+	inline std::vector<BenchKernel> GetAll()
+	{
+		std::vector<BenchKernel> kernels;
+
+		constexpr int InterpolateSamples = 1 << 20;
+		kernels.push_back({ "Interpolate3D", InterpolateSamples, [] ()
+			{
+				float data[64];
+				for(int i = 0; i < 64; ++i) data[i] = static_cast<float>(i) / 64.0f;
+
+				float sum = 0.0f;
+				for(int i = 0; i < InterpolateSamples; ++i)
+				{
+					const float f = static_cast<float>(i & 1023) / 1024.0f;
+					sum += NG::Interpolate3D(data, f, 1.0f - f, f * 0.5f);
+				}
+				Consume(sum);
+			} });
+
+		for(int res : { 256, 1024 })
+		{
+			kernels.push_back({ Name("StupidNoise2D", res), (int64_t)res * res, [res] ()
+				{
+					Consume(NG::StupidNoise2D(res, res / 8, {}, 1.0f, 42u));
+				} });
+		}
+
+		kernels.push_back({ Name("StupidNoise3D", 64), 64 * 64 * 64, [] ()
+			{
+				Consume(NG::StupidNoise3D(64, 8, {}, 1.0f, 42u));
+			} });
+
+		for(int res : { 512, 1024, 2048 })
+		{
+			kernels.push_back({ Name("FBMNoise2D", res), (int64_t)res * res, [res] ()
+				{
+					const NoiseProperties props = MakeProps(false);
+					Consume(NG::FBMNoise2D(res, &props, nullptr));
+				} });
+		}
+
+		kernels.push_back({ Name("FBMNoise2D", 2048) + "/threads=all", 2048 * 2048, [] ()
+			{
+				const NoiseProperties props = MakeProps(false);
+				NoiseExecution exec;
+				exec.threadCount = 0;
+				Consume(NG::FBMNoise2D(2048, &props, nullptr, exec));
+			} });
+
+		kernels.push_back({ Name("FBMNoise2D_Turbulence", 1024), 1024 * 1024, [] ()
+			{
+				const NoiseProperties props = MakeProps(true);
+				Consume(NG::FBMNoise2D(1024, &props, nullptr));
+			} });
+
+		for(int res : { 512, 1024 })
+		{
+			kernels.push_back({ Name("WorleyNoise2D", res), (int64_t)res * res, [res] ()
+				{
+					const NoiseProperties props = MakeProps(false);
+					Consume(NG::WorleyNoise2D(res, &props));
+				} });
+		}
+
+		return kernels;
+	}
+}
@@ -0,0 +1,325 @@
+/*
+	NoiseBenchGate: times the noise kernels and compares them against a stored baseline.
+
+	  NoiseBenchGate --save baseline.txt                 record a baseline on this machine
+	  NoiseBenchGate --baseline baseline.txt [options]   compare, exit 1 on a regression
+
+	Options:
+	  --threshold F   allowed slowdown as a fraction, default 0.10 (10%)
+	  --samples N     timed samples per kernel, default 10
+	  --filter TEXT   only kernels whose name contains TEXT
+	  --list          print the kernel names and exit
+
+	A kernel regresses when its slowdown is above the threshold even after subtracting the 95%
+	confidence interval of the difference, so noisy kernels need a clear slowdown to fail.
+	Baseline kernels the run does not have (renamed or removed) fail the gate as missing.
+	With --filter, --save only replaces the filtered kernels of an existing baseline file.
+*/
+
+#include "BenchKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace
+{
+	constexpr int BaselineVersion = 1;
+
+	/** Samples shorter than this repeat the kernel to stay above timer noise */
+	constexpr double MinSampleSeconds = 0.02;
+
+	/** Timing summary of one kernel, all times in milliseconds per call */
+	struct KernelStats
+	{
+		double mean = 0.0;
+		double stddev = 0.0;
+		int samples = 0;
+
+		/** Half width of the 95% confidence interval of the mean */
+		double ConfidenceInterval() const;
+	};
+
+	/** Two-sided 95% Student t quantiles for 1 .. 30 degrees of freedom */
+	double StudentT95(int degreesOfFreedom)
+	{
+		static const double table[] =
+		{
+			12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+			2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+			2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+		};
+		if(degreesOfFreedom < 1) return 0.0;
+		if(degreesOfFreedom <= 30) return table[degreesOfFreedom - 1];
+		return 1.960;
+	}
+
+	double KernelStats::ConfidenceInterval() const
+	{
+		return samples > 1 ? StudentT95(samples - 1) * stddev / std::sqrt((double)samples) : 0.0;
+	}
+
+	KernelStats Measure(const BenchKernel& kernel, int samples)
+	{
+		using Clock = std::chrono::steady_clock;
+
+		// Warm up caches and lazily created pools, and pick how many calls make up one sample
+		const auto warmupStart = Clock::now();
+		kernel.run();
+		const double once = std::chrono::duration<double>(Clock::now() - warmupStart).count();
+		const int repeats = once >= MinSampleSeconds ? 1 : std::min(1000, (int)std::ceil(MinSampleSeconds / std::max(once, 1e-7)));
+
+		std::vector<double> times(samples);
+		for(double& time : times)
+		{
+			const auto start = Clock::now();
+			for(int i = 0; i < repeats; ++i) kernel.run();
+			time = std::chrono::duration<double, std::milli>(Clock::now() - start).count() / repeats;
+		}
+
+		KernelStats stats;
+		stats.samples = samples;
+		for(double time : times) stats.mean += time;
+		stats.mean /= samples;
+
+		double variance = 0.0;
+		for(double time : times) variance += (time - stats.mean) * (time - stats.mean);
+		stats.stddev = samples > 1 ? std::sqrt(variance / (samples - 1)) : 0.0;
+		return stats;
+	}
+
+	/** Baseline file: a version line, then "name mean_ms stddev_ms samples" per kernel */
+	bool LoadBaseline(const std::string& path, std::map<std::string, KernelStats>& out)
+	{
+		std::ifstream file(path);
+		if(!file.is_open())
+		{
+			fprintf(stderr, "Cannot open baseline %s\n", path.c_str());
+			return false;
+		}
+
+		std::string line;
+		int lineNumber = 0;
+		bool bHasVersion = false;
+		while(std::getline(file, line))
+		{
+			lineNumber++;
+			if(line.empty() || line[0] == '#')
+				continue;
+
+			std::istringstream fields(line);
+			if(!bHasVersion)
+			{
+				std::string tag;
+				int version = 0;
+				if(!(fields >> tag >> version) || tag != "NoiseBenchGate" || version != BaselineVersion)
+				{
+					fprintf(stderr, "%s:%d: not a version %d baseline\n", path.c_str(), lineNumber, BaselineVersion);
+					return false;
+				}
+				bHasVersion = true;
+				continue;
+			}
+
+			std::string name;
+			KernelStats stats;
+			if(!(fields >> name >> stats.mean >> stats.stddev >> stats.samples) || stats.samples < 1)
+			{
+				fprintf(stderr, "%s:%d: malformed entry\n", path.c_str(), lineNumber);
+				return false;
+			}
+			out[name] = stats;
+		}
+
+		if(!bHasVersion)
+		{
+			fprintf(stderr, "%s: empty baseline\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool SaveBaseline(const std::string& path, const std::vector<std::pair<std::string, KernelStats>>& results)
+	{
+		std::ofstream file(path, std::ios::trunc);
+		if(!file.is_open())
+		{
+			fprintf(stderr, "Cannot write baseline %s\n", path.c_str());
+			return false;
+		}
+
+		file << "NoiseBenchGate " << BaselineVersion << "\n";
+		file << "# name mean_ms stddev_ms samples\n";
+		char buffer[256];
+		for(const auto& [name, stats] : results)
+		{
+			snprintf(buffer, sizeof(buffer), "%s %.6f %.6f %d\n", name.c_str(), stats.mean, stats.stddev, stats.samples);
+			file << buffer;
+		}
+		return file.good();
+	}
+
+	/**
+	 * Results of a filtered run replace their kernels in the baseline at path, the other kernels
+	 * keep their entries. Kernels of the run come first, in run order, then the remaining ones.
+	 */
+	bool MergeBaseline(const std::string& path, std::vector<std::pair<std::string, KernelStats>>& results)
+	{
+		if(!std::ifstream(path).is_open())
+			return true;
+
+		std::map<std::string, KernelStats> saved;
+		if(!LoadBaseline(path, saved))
+			return false;
+
+		std::vector<std::pair<std::string, KernelStats>> merged;
+		for(const BenchKernel& kernel : BenchKernels::GetAll())
+		{
+			const auto measured = std::find_if(results.begin(), results.end(),
+				[&] (const auto& result) { return result.first == kernel.name; });
+			if(measured != results.end())
+				merged.push_back(*measured);
+			else if(saved.count(kernel.name))
+				merged.emplace_back(kernel.name, saved[kernel.name]);
+			saved.erase(kernel.name);
+		}
+		for(const auto& entry : saved)
+			merged.push_back(entry);
+
+		results = std::move(merged);
+		return true;
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: NoiseBenchGate (--baseline FILE | --save FILE) [--threshold F] [--samples N] [--filter TEXT] [--list]\n"
+			"Exit code: 0 no regression, 1 a kernel regressed or is missing, 2 invalid arguments or baseline\n");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string baselinePath, savePath, filter;
+	double threshold = 0.10;
+	int samples = 10;
+	bool bList = false;
+
+	for(int i = 1; i < argc; i++)
+	{
+		const bool bHasValue = i + 1 < argc;
+		if(!strcmp(argv[i], "--baseline") && bHasValue) baselinePath = argv[++i];
+		else if(!strcmp(argv[i], "--save") && bHasValue) savePath = argv[++i];
+		else if(!strcmp(argv[i], "--filter") && bHasValue) filter = argv[++i];
+		else if(!strcmp(argv[i], "--threshold") && bHasValue) threshold = atof(argv[++i]);
+		else if(!strcmp(argv[i], "--samples") && bHasValue) samples = atoi(argv[++i]);
+		else if(!strcmp(argv[i], "--list")) bList = true;
+		else
+		{
+			PrintUsage();
+			return !strcmp(argv[i], "--help") ? 0 : 2;
+		}
+	}
+
+	std::vector<BenchKernel> kernels = BenchKernels::GetAll();
+	if(!filter.empty())
+	{
+		kernels.erase(std::remove_if(kernels.begin(), kernels.end(),
+			[&] (const BenchKernel& kernel) { return kernel.name.find(filter) == std::string::npos; }), kernels.end());
+	}
+
+	if(bList)
+	{
+		for(const BenchKernel& kernel : kernels) printf("%s\n", kernel.name.c_str());
+		return 0;
+	}
+
+	if((baselinePath.empty() && savePath.empty()) || samples < 2 || threshold < 0.0 || kernels.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	std::map<std::string, KernelStats> baseline;
+	if(!baselinePath.empty() && !LoadBaseline(baselinePath, baseline))
+		return 2;
+
+	printf("%-36s %12s %12s %14s %9s  %s\n", "kernel", "base (ms)", "now (ms)", "change", "MP/s", "verdict");
+
+	std::vector<std::pair<std::string, KernelStats>> results;
+	int regressions = 0;
+	for(const BenchKernel& kernel : kernels)
+	{
+		const KernelStats current = Measure(kernel, samples);
+		results.emplace_back(kernel.name, current);
+
+		const double megapixels = current.mean > 0.0 ? kernel.items / 1.0e3 / current.mean : 0.0;
+		const auto found = baseline.find(kernel.name);
+		if(found == baseline.end())
+		{
+			printf("%-36s %12s %7.3f±%-5.3f %14s %9.2f  %s\n", kernel.name.c_str(), "-", current.mean,
+				current.ConfidenceInterval(), "-", megapixels, baselinePath.empty() ? "" : "new");
+			fflush(stdout);
+			continue;
+		}
+
+		// Relative change with the 95% interval of the difference of both means
+		const KernelStats& base = found->second;
+		const double change = (current.mean - base.mean) / base.mean;
+		const double interval = std::sqrt(current.ConfidenceInterval() * current.ConfidenceInterval()
+			+ base.ConfidenceInterval() * base.ConfidenceInterval()) / base.mean;
+
+		const char* verdict = "ok";
+		if(change - interval > threshold)
+		{
+			verdict = "REGRESSION";
+			regressions++;
+		}
+		else if(change + interval < 0.0)
+		{
+			verdict = "faster";
+		}
+
+		char changeText[32];
+		snprintf(changeText, sizeof(changeText), "%+.1f%%±%.1f%%", change * 100.0, interval * 100.0);
+		printf("%-36s %12.3f %12.3f %14s %9.2f  %s (%.2fx)\n", kernel.name.c_str(), base.mean, current.mean,
+			changeText, megapixels, verdict, current.mean > 0.0 ? base.mean / current.mean : 0.0);
+		fflush(stdout);
+	}
+
+	// Baseline kernels the run skipped although the filter selects them were renamed or removed
+	int missing = 0;
+	for(const auto& [name, stats] : baseline)
+	{
+		if(!filter.empty() && name.find(filter) == std::string::npos)
+			continue;
+		if(std::none_of(kernels.begin(), kernels.end(), [&] (const BenchKernel& kernel) { return kernel.name == name; }))
+		{
+			printf("%-36s %12.3f %12s %14s %9s  %s\n", name.c_str(), stats.mean, "-", "-", "-", "MISSING");
+			missing++;
+		}
+	}
+
+	const size_t measured = results.size();
+	if(!savePath.empty())
+	{
+		if(!filter.empty() && !MergeBaseline(savePath, results))
+			return 2;
+		if(!SaveBaseline(savePath, results))
+			return 2;
+		printf("\nSaved baseline for %zu kernels (%zu measured) to %s\n", results.size(), measured, savePath.c_str());
+	}
+
+	if(!baselinePath.empty())
+	{
+		printf("\n%d of %zu kernels regressed by more than %.1f%%\n", regressions, measured, threshold * 100.0);
+		if(missing > 0)
+			printf("%d baseline kernels are missing from this run\n", missing);
+	}
+
+	return regressions > 0 || missing > 0 ? 1 : 0;
+}
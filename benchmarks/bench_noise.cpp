@@ -0,0 +1,460 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Memory/BufferPool.h"
+#include "Noise/NoiseCache.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoisePipeline.h"
+#include "Noise/NoiseQuery.h"
+#include "Noise/NoiseRegion.h"
+#include "Profiling/Profiler.h"
+#include "BenchKernels.h"
+
+/**
+ * Noise kernel benchmarks.
+ *
+ * Generators sweep every size of NoiseResolutions (the GUI resolution table) and, where the
+ * generator is threaded, every power of two thread count up to the hardware threads.
+ * Throughput is reported as items_per_second = pixels (or samples) per second.
+ *
+ * Machine-readable results:
+ *   NoiseGeneratorBenchmarks --benchmark_out=results.json --benchmark_out_format=json
+ * or build the bench_json target, which writes benchmarks.json into the build folder.
+ */
+
+namespace
+{
+	constexpr int SampleCount = 4096;
+
+	/** Deterministic fractional coordinates so every run interpolates the same points */
+	std::vector<float> MakeFractions(int count)
+	{
+		std::vector<float> values(count);
+		for(int i = 0; i < count; ++i)
+			values[i] = static_cast<float>((i * 2654435761u) % 1000u) / 1000.0f;
+		return values;
+	}
+
+	/** Lattice frequency of a single generator octave at res */
+	int OctaveFrequency(int res)
+	{
+		return std::max(4, res / 8);
+	}
+
+	void ResolutionArgs(benchmark::internal::Benchmark* bench, int maxResolution = 1 << 30)
+	{
+		for(int res : NoiseResolutions)
+			if(res <= maxResolution) bench->Arg(res);
+	}
+
+	void ResolutionThreadArgs(benchmark::internal::Benchmark* bench)
+	{
+		const int hardwareThreads = std::max(1, (int)std::thread::hardware_concurrency());
+		std::vector<int> threadCounts;
+		for(int threads = 1; threads < hardwareThreads; threads *= 2) threadCounts.push_back(threads);
+		threadCounts.push_back(hardwareThreads);
+
+		for(int res : NoiseResolutions)
+			for(int threads : threadCounts) bench->Args({ res, threads });
+	}
+
+	void SetPixelCounters(benchmark::State& state, int64_t pixelsPerIteration)
+	{
+		state.SetItemsProcessed(state.iterations() * pixelsPerIteration);
+		state.SetBytesProcessed(state.iterations() * pixelsPerIteration * (int64_t)sizeof(float));
+	}
+}
+
+// -----------------------
+// Interpolation
+// -----------------------
+
+static void BM_Interpolate1D(benchmark::State& state)
+{
+	float data[4] = { 0.1f, 0.7f, 0.3f, 0.9f };
+	const std::vector<float> xf = MakeFractions(SampleCount);
+	for(auto _ : state)
+	{
+		float sum = 0.0f;
+		for(float x : xf) sum += NG::Interpolate1D(data, x);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK(BM_Interpolate1D);
+
+static void BM_Interpolate2D(benchmark::State& state)
+{
+	float data[16];
+	for(int i = 0; i < 16; ++i) data[i] = static_cast<float>(i) / 16.0f;
+	const std::vector<float> xf = MakeFractions(SampleCount);
+	for(auto _ : state)
+	{
+		float sum = 0.0f;
+		for(int i = 0; i < SampleCount; ++i) sum += NG::Interpolate2D(data, xf[i], xf[SampleCount - 1 - i]);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK(BM_Interpolate2D);
+
+static void BM_Interpolate3D(benchmark::State& state)
+{
+	float data[64];
+	for(int i = 0; i < 64; ++i) data[i] = static_cast<float>(i) / 64.0f;
+	const std::vector<float> xf = MakeFractions(SampleCount);
+	for(auto _ : state)
+	{
+		float sum = 0.0f;
+		for(int i = 0; i < SampleCount; ++i) sum += NG::Interpolate3D(data, xf[i], xf[SampleCount - 1 - i], xf[(i * 7) % SampleCount]);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK(BM_Interpolate3D);
+
+// -----------------------
+// Lattice indexing
+// -----------------------
+
+template<bool bPowerOfTwo>
+static void BM_CalcIndex2D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(int i = 0; i < SampleCount; ++i) sum += NG::CalcIndex2D<bPowerOfTwo>(i - 7, 3 * i + 1, res);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK_TEMPLATE(BM_CalcIndex2D, false)->Arg(64)->Arg(1024);
+BENCHMARK_TEMPLATE(BM_CalcIndex2D, true)->Arg(64)->Arg(1024);
+
+template<bool bPowerOfTwo>
+static void BM_CalcIndex3D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	for(auto _ : state)
+	{
+		int sum = 0;
+		for(int i = 0; i < SampleCount; ++i) sum += NG::CalcIndex3D<bPowerOfTwo>(i - 7, 3 * i + 1, 5 * i + 2, res);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK_TEMPLATE(BM_CalcIndex3D, false)->Arg(64);
+BENCHMARK_TEMPLATE(BM_CalcIndex3D, true)->Arg(64);
+
+// -----------------------
+// Sampling
+// -----------------------
+
+static void BM_Sample2D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	std::vector<float> image((size_t)res * res);
+	for(size_t i = 0; i < image.size(); ++i) image[i] = static_cast<float>(i % 251) / 251.0f;
+	const std::vector<float> xf = MakeFractions(SampleCount);
+
+	for(auto _ : state)
+	{
+		float sum = 0.0f;
+		for(int i = 0; i < SampleCount; ++i)
+			sum += NG::Sample2D(image.data(), (short)res, (short)res, xf[i] * res, xf[SampleCount - 1 - i] * res);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK(BM_Sample2D)->Arg(256)->Arg(4096);
+
+// -----------------------
+// Single octave generators
+// -----------------------
+
+static void BM_StupidNoise1D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::StupidNoise1D(res, OctaveFrequency(res), {}, 1.0f, 42u);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, res);
+}
+BENCHMARK(BM_StupidNoise1D)->Apply([] (benchmark::internal::Benchmark* bench) { ResolutionArgs(bench); });
+
+static void BM_StupidNoise2D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	NoiseExecution exec;
+	exec.threadCount = static_cast<int>(state.range(1));
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::StupidNoise2D(res, OctaveFrequency(res), {}, 1.0f, 42u, exec);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res);
+}
+BENCHMARK(BM_StupidNoise2D)->Apply(ResolutionThreadArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_StupidNoise3D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::StupidNoise3D(res, OctaveFrequency(res), {}, 1.0f, 42u);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res * res);
+}
+// A res^3 volume, larger sizes do not fit in memory
+BENCHMARK(BM_StupidNoise3D)->Apply([] (benchmark::internal::Benchmark* bench) { ResolutionArgs(bench, 256); })
+	->Unit(benchmark::kMillisecond);
+
+// -----------------------
+// Full generators
+// -----------------------
+
+static void RunFBMNoise2D(benchmark::State& state, bool bTurbulence)
+{
+	const int res = static_cast<int>(state.range(0));
+	const NoiseProperties props = BenchKernels::MakeProps(bTurbulence);
+	NoiseExecution exec;
+	exec.threadCount = static_cast<int>(state.range(1));
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::FBMNoise2D(res, &props, nullptr, exec);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res);
+}
+
+static void BM_FBMNoise2D(benchmark::State& state)
+{
+	RunFBMNoise2D(state, false);
+}
+BENCHMARK(BM_FBMNoise2D)->Apply(ResolutionThreadArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_FBMNoise2D_Turbulence(benchmark::State& state)
+{
+	RunFBMNoise2D(state, true);
+}
+BENCHMARK(BM_FBMNoise2D_Turbulence)->Apply(ResolutionThreadArgs)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+static void BM_WorleyNoise2D(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	const NoiseProperties props = BenchKernels::MakeProps(false);
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::WorleyNoise2D(res, &props);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res);
+}
+BENCHMARK(BM_WorleyNoise2D)->Apply([] (benchmark::internal::Benchmark* bench) { ResolutionArgs(bench); })
+	->Unit(benchmark::kMillisecond);
+
+// -----------------------
+// Regions
+// -----------------------
+
+/**
+ * Streaming terrain: every benchmark thread generates 256^2 chunks of an unbounded 4096-scale world,
+ * each with a serial GenerateRegion call at its own offset. The argument toggles turbulence.
+ */
+static void BM_GenerateRegion_Chunks(benchmark::State& state)
+{
+	constexpr int Res = 4096;
+	constexpr int ChunkSize = 256;
+	NoiseProperties props = BenchKernels::MakeProps(state.range(0) != 0);
+	props.domain = NoiseDomain::Unbounded;
+
+	std::vector<float> chunk((size_t)ChunkSize * ChunkSize);
+	int64_t index = state.thread_index() * 1000;
+	for(auto _ : state)
+	{
+		const int64_t x0 = (index % 97 - 48) * ChunkSize;
+		const int64_t y0 = (index / 97 - 48) * ChunkSize;
+		NG::GenerateRegion(Res, &props, x0, y0, ChunkSize, ChunkSize, chunk.data(), ChunkSize);
+		benchmark::DoNotOptimize(chunk.data());
+		index++;
+	}
+	SetPixelCounters(state, (int64_t)ChunkSize * ChunkSize);
+}
+BENCHMARK(BM_GenerateRegion_Chunks)->Arg(0)->Arg(1)->ThreadRange(1, std::max(1, (int)std::thread::hardware_concurrency()))
+	->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/**
+ * Point queries: SampleCount scattered points per call, 2D or 3D (first argument) with the
+ * scalar path or the best SimdLevel of the machine (second argument).
+ */
+static void BM_NoiseQuery_Points(benchmark::State& state)
+{
+	const bool b3D = state.range(0) != 0;
+	const bool bSimd = state.range(1) != 0;
+	NoiseProperties props = BenchKernels::MakeProps(false);
+	props.domain = NoiseDomain::Unbounded;
+	const NG::NoiseQuery query(4096, props);
+
+	std::vector<float> x = MakeFractions(SampleCount), y = MakeFractions(SampleCount), z = MakeFractions(SampleCount);
+	for(int i = 0; i < SampleCount; ++i)
+	{
+		x[i] = x[i] * 50000.0f - 25000.0f;
+		y[i] = y[(i * 7 + 3) % SampleCount] * 50000.0f;
+		z[i] = z[(i * 13 + 5) % SampleCount] * 1000.0f;
+	}
+
+	std::vector<float> out(SampleCount);
+	NG::SetSimdLevel(bSimd ? NG::GetSupportedSimdLevel() : NG::SimdLevel::Scalar);
+	for(auto _ : state)
+	{
+		if(b3D)
+			query.Sample3D(x.data(), y.data(), z.data(), SampleCount, out.data());
+		else
+			query.Sample2D(x.data(), y.data(), SampleCount, out.data());
+		benchmark::DoNotOptimize(out.data());
+	}
+	NG::SetSimdLevel(NG::GetSupportedSimdLevel());
+	state.SetItemsProcessed(state.iterations() * SampleCount);
+}
+BENCHMARK(BM_NoiseQuery_Points)->ArgsProduct({ { 0, 1 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+
+// -----------------------
+// Result cache
+// -----------------------
+
+/** Repeated 4096^2 turbulence request answered by the memory tier of a NoiseCache: key, lookup, no copy */
+static void BM_NoiseCache_Hit(benchmark::State& state)
+{
+	constexpr int Res = 4096;
+	const NoiseProperties props = BenchKernels::MakeProps(true);
+	NoiseCache cache;
+	cache.Insert(NoiseCache::MakeKey(NoiseAlgorithm::FBM, Res, props), NG::FBMNoise2D(Res, &props, nullptr));
+
+	for(auto _ : state)
+	{
+		auto image = cache.FindOrGenerate(NoiseCache::MakeKey(NoiseAlgorithm::FBM, Res, props),
+			[&] () { return NG::FBMNoise2D(Res, &props, nullptr); });
+		benchmark::DoNotOptimize(image.get());
+	}
+	state.counters["hits"] = (double)cache.GetHitCount();
+	state.counters["misses"] = (double)cache.GetMissCount();
+}
+BENCHMARK(BM_NoiseCache_Hit)->Unit(benchmark::kMicrosecond);
+
+// -----------------------
+// Incremental pipeline
+// -----------------------
+
+/**
+ * One parameter edit on a 4096^2 turbulence map through a NoisePipeline, every hardware thread.
+ * Argument: 0 edits marbling, 1 the turbulence offset, 2 resets the pipeline (full regeneration).
+ */
+static void BM_NoisePipeline_Edit(benchmark::State& state)
+{
+	constexpr int Res = 4096;
+	const int edit = static_cast<int>(state.range(0));
+	NoiseProperties props = BenchKernels::MakeProps(true);
+	NoiseExecution exec;
+	exec.threadCount = 0;
+
+	NG::NoisePipeline pipeline;
+	pipeline.Run(Res, props, nullptr, exec);
+	int step = 0;
+	for(auto _ : state)
+	{
+		step++;
+		if(edit == 0) props.marbling = 0.5f + 0.01f * (step % 64);
+		else if(edit == 1) props.turbulence_offset_x = 0.01f * (step % 64);
+		else pipeline.Reset();
+
+		NoiseImage data = pipeline.Run(Res, props, nullptr, exec);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)Res * Res);
+	state.SetLabel(edit == 0 ? "marbling" : edit == 1 ? "offset" : "full");
+}
+BENCHMARK(BM_NoisePipeline_Edit)->DenseRange(0, 2)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/**
+ * Roughness edits through a NoisePipeline, every hardware thread. The default capacity holds the
+ * whole stack at both sizes, 4096^2 being the largest GUI resolution.
+ * Arguments: resolution, 0 without a layer cache (the octaves are evaluated again), 1 Float32 layers, 2 Float16 layers.
+ */
+static void BM_OctaveLayers_RoughnessEdit(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	const int mode = static_cast<int>(state.range(1));
+	NoiseProperties props = BenchKernels::MakeProps(false);
+	NoiseExecution exec;
+	exec.threadCount = 0;
+
+	NG::NoisePipeline pipeline;
+	if(mode > 0)
+	{
+		pipeline.SetLayerCache(std::make_shared<NG::OctaveLayerCache>(NG::OctaveLayerCache::DefaultCapacity,
+			mode == 1 ? NG::OctaveLayerCache::Precision::Float32 : NG::OctaveLayerCache::Precision::Float16));
+	}
+	pipeline.Run(res, props, nullptr, exec);
+
+	int step = 0;
+	for(auto _ : state)
+	{
+		props.roughness = 0.3f + 0.01f * (++step % 64);
+		NoiseImage data = pipeline.Run(res, props, nullptr, exec);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res);
+	state.SetLabel(mode == 0 ? "resynthesize" : mode == 1 ? "float32 layers" : "float16 layers");
+	if(mode > 0)
+		state.counters["layer_misses"] = (double)pipeline.GetLayerCache()->GetMissCount();
+}
+BENCHMARK(BM_OctaveLayers_RoughnessEdit)->ArgsProduct({ { 2048, 4096 }, { 0, 1, 2 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// -----------------------
+// Huge pages
+// -----------------------
+
+/**
+ * FBM with a strong turbulence warp: the warp pass samples its source image at scattered
+ * positions and is bound by TLB misses at large sizes. The second argument is the HugePageMode
+ * of the buffer pool. warp_ms is the Warp stage alone, it needs NOISE_ENABLE_PROFILING.
+ */
+static void BM_TurbulenceWarp_HugePages(benchmark::State& state)
+{
+	const int res = static_cast<int>(state.range(0));
+	const HugePageMode mode = static_cast<HugePageMode>(state.range(1));
+	NoiseProperties props = BenchKernels::MakeProps(true);
+	props.turbulence = 32.0f;
+
+	BufferPool::Get().SetHugePageMode(mode);
+	Profiler::Get().Reset();
+	for(auto _ : state)
+	{
+		NoiseImage data = NG::FBMNoise2D(res, &props, nullptr);
+		benchmark::DoNotOptimize(data.Data());
+	}
+	SetPixelCounters(state, (int64_t)res * res);
+	state.SetLabel(BufferPool::GetHugePageModeName(mode));
+
+	for(const ProfileStageStats& stage : Profiler::Get().GetStages())
+	{
+		if(stage.name == "FBMNoise2D/Warp" && stage.calls > 0)
+			state.counters["warp_ms"] = stage.totalMilliseconds / stage.calls;
+	}
+	BufferPool::Get().SetHugePageMode(HugePageMode::Off);
+}
+BENCHMARK(BM_TurbulenceWarp_HugePages)->Apply([] (benchmark::internal::Benchmark* bench)
+	{
+		for(int res : { 2048, 4096 })
+			for(HugePageMode mode : { HugePageMode::Off, HugePageMode::Advise, HugePageMode::Explicit })
+				bench->Args({ res, static_cast<int>(mode) });
+	})->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
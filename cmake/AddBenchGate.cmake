@@ -0,0 +1,35 @@
+# -----------------------
+# NoiseBenchGate: benchmark regression gate
+# -----------------------
+# Self-contained timer (no Google Benchmark), so CI can always build it.
+#   cmake --build . --target bench_baseline   record the baseline on a reference machine
+#   cmake --build . --target bench_gate       compare, fails the build on a regression
+set(NOISE_BENCH_BASELINE "${CMAKE_SOURCE_DIR}/benchmarks/baseline.txt" CACHE FILEPATH "Baseline file used by the bench_gate target")
+set(NOISE_BENCH_THRESHOLD "0.10" CACHE STRING "Allowed slowdown per kernel before bench_gate fails (0.10 = 10%)")
+
+add_executable(NoiseBenchGate
+  ${CMAKE_SOURCE_DIR}/benchmarks/bench_gate.cpp
+  ${CMAKE_SOURCE_DIR}/benchmarks/BenchKernels.h
+)
+
+target_link_libraries(NoiseBenchGate PRIVATE NoiseCore)
+
+set_target_properties(NoiseBenchGate PROPERTIES
+  CXX_STANDARD 17
+  CXX_STANDARD_REQUIRED ON
+  CXX_EXTENSIONS OFF
+)
+
+add_custom_target(bench_gate
+  COMMAND NoiseBenchGate --baseline ${NOISE_BENCH_BASELINE} --threshold ${NOISE_BENCH_THRESHOLD}
+  DEPENDS NoiseBenchGate
+  COMMENT "Comparing noise kernels against ${NOISE_BENCH_BASELINE}"
+  USES_TERMINAL
+)
+
+add_custom_target(bench_baseline
+  COMMAND NoiseBenchGate --save ${NOISE_BENCH_BASELINE}
+  DEPENDS NoiseBenchGate
+  COMMENT "Recording noise kernel baseline to ${NOISE_BENCH_BASELINE}"
+  USES_TERMINAL
+)
@@ -0,0 +1,52 @@
+# -----------------------
+# Benchmarks (Google Benchmark)
+# -----------------------
+# Uses an installed Google Benchmark when available, otherwise fetches it.
+if(NOT TARGET benchmark::benchmark)
+  find_package(benchmark QUIET)
+endif()
+
+if(NOT TARGET benchmark::benchmark)
+  include(FetchContent)
+  set(BENCHMARK_ENABLE_TESTING OFF CACHE BOOL "" FORCE)
+  set(BENCHMARK_ENABLE_GTEST_TESTS OFF CACHE BOOL "" FORCE)
+  set(BENCHMARK_ENABLE_INSTALL OFF CACHE BOOL "" FORCE)
+  FetchContent_Declare(
+    googlebenchmark
+    GIT_REPOSITORY https://github.com/google/benchmark.git
+    GIT_TAG v1.8.3
+  )
+  message(STATUS "🔽 Downloading Google Benchmark from GitHub...")
+  FetchContent_MakeAvailable(googlebenchmark)
+endif()
+
+add_executable(NoiseGeneratorBenchmarks
+  ${CMAKE_SOURCE_DIR}/benchmarks/bench_noise.cpp
+  ${CMAKE_SOURCE_DIR}/benchmarks/BenchKernels.h
+)
+
+target_link_libraries(NoiseGeneratorBenchmarks PRIVATE
+  NoiseCore
+  benchmark::benchmark
+)
+
+set_target_properties(NoiseGeneratorBenchmarks PROPERTIES
+  CXX_STANDARD 17
+  CXX_STANDARD_REQUIRED ON
+  CXX_EXTENSIONS OFF
+)
+
+# Full sweep with JSON results, for tracking regressions across releases
+add_custom_target(bench_json
+  COMMAND NoiseGeneratorBenchmarks
+    --benchmark_out=${CMAKE_BINARY_DIR}/benchmarks.json
+    --benchmark_out_format=json
+    --benchmark_repetitions=3
+    --benchmark_report_aggregates_only=true
+  DEPENDS NoiseGeneratorBenchmarks
+  WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+  COMMENT "Running noise benchmarks, results in ${CMAKE_BINARY_DIR}/benchmarks.json"
+  USES_TERMINAL
+)
+
+message(STATUS "⏱️ NoiseGeneratorBenchmarks configured")
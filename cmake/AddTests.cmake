@@ -24,28 +24,23 @@ enable_testing()
 add_executable(NoiseGeneratorTests
   ${CMAKE_SOURCE_DIR}/tests/test_noise_math.cpp
   ${CMAKE_SOURCE_DIR}/tests/test_noise_generator.cpp
-)
-
-target_include_directories(NoiseGeneratorTests PRIVATE
-  ${CMAKE_SOURCE_DIR}/src
+  ${CMAKE_SOURCE_DIR}/tests/test_heightmap_file.cpp
+  ${CMAKE_SOURCE_DIR}/tests/test_job_manifest.cpp
+  ${CMAKE_SOURCE_DIR}/tests/test_profiler.cpp
+  ${CMAKE_SOURCE_DIR}/tests/test_memory_tracker.cpp
+  ${CMAKE_SOURCE_DIR}/tests/test_noise_image.cpp
+  ${CMAKE_SOURCE_DIR}/tests/test_noise_cache.cpp
+
+  ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.cpp
+  ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.h
 )
 
 target_link_libraries(NoiseGeneratorTests PRIVATE
+  NoiseCore
   gtest
   gtest_main
 )
 
-target_sources(NoiseGeneratorTests PRIVATE
-  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseMath.cpp
-  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.cpp
-  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.h
-  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseTypes.h
-
-  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.cpp
-  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.h
-  
-)
-
 set_target_properties(NoiseGeneratorTests PROPERTIES
   CXX_STANDARD 17
   CXX_STANDARD_REQUIRED ON
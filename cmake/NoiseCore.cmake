@@ -0,0 +1,170 @@
+# -----------------------
+# NoiseCore: headless noise engine
+# -----------------------
+# Everything needed to generate and export noise without a display:
+# no GLFW / GLAD / ImGui / NFD. The GUI, the tests and the command line
+# tools all link against this library.
+if(TARGET NoiseCore)
+  return()
+endif()
+
+option(NOISE_CORE_OPTIMIZE "Always build NoiseCore with full optimizations, also in Debug/Testing" ON)
+option(NOISE_CORE_NATIVE "Tune NoiseCore for the build machine (-march=native); binaries may not run elsewhere" OFF)
+option(NOISE_ENABLE_PROFILING "Record per-stage timings, allocations and trace timelines (Performance panel)" ON)
+
+add_library(NoiseCore STATIC
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseCache.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseCache.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseImage.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseImage.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseMath.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseMath.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseParallel.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseParallel.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoisePipeline.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoisePipeline.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseQuery.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseQuery.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseRegion.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseRegion.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseSimd.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStages.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStages.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveKernel.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveKernel.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveLayerCache.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveLayerCache.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/WorleyGrid.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/WorleyGrid.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStream.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStream.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseTypes.h
+
+  ${CMAKE_SOURCE_DIR}/src/Export/HeightmapFile.cpp
+  ${CMAKE_SOURCE_DIR}/src/Export/HeightmapFile.h
+  ${CMAKE_SOURCE_DIR}/src/Export/MappedFile.cpp
+  ${CMAKE_SOURCE_DIR}/src/Export/MappedFile.h
+
+  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.cpp
+  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.h
+  ${CMAKE_SOURCE_DIR}/src/Logger/LoggerMacro.h
+
+  ${CMAKE_SOURCE_DIR}/src/Memory/BufferPool.cpp
+  ${CMAKE_SOURCE_DIR}/src/Memory/BufferPool.h
+  ${CMAKE_SOURCE_DIR}/src/Memory/MemoryTracker.cpp
+  ${CMAKE_SOURCE_DIR}/src/Memory/MemoryTracker.h
+
+  ${CMAKE_SOURCE_DIR}/src/Profiling/Profiler.cpp
+  ${CMAKE_SOURCE_DIR}/src/Profiling/Profiler.h
+  ${CMAKE_SOURCE_DIR}/src/Profiling/TraceRecorder.cpp
+  ${CMAKE_SOURCE_DIR}/src/Profiling/TraceRecorder.h
+
+  ${CMAKE_SOURCE_DIR}/src/Utils/HashRandom.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/HalfFloat.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/RandomGenerator.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/ThreadPool.h
+)
+
+source_group(TREE ${CMAKE_SOURCE_DIR}/src PREFIX "Source" FILES
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseCache.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseCache.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseGenerator.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseImage.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseImage.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseMath.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseMath.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseParallel.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseParallel.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoisePipeline.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoisePipeline.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseQuery.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseQuery.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseRegion.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseRegion.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseSimd.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStages.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStages.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveKernel.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveKernel.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveLayerCache.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/OctaveLayerCache.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/WorleyGrid.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/WorleyGrid.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStream.cpp
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseStream.h
+  ${CMAKE_SOURCE_DIR}/src/Noise/NoiseTypes.h
+
+  ${CMAKE_SOURCE_DIR}/src/Export/HeightmapFile.cpp
+  ${CMAKE_SOURCE_DIR}/src/Export/HeightmapFile.h
+  ${CMAKE_SOURCE_DIR}/src/Export/MappedFile.cpp
+  ${CMAKE_SOURCE_DIR}/src/Export/MappedFile.h
+
+  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.cpp
+  ${CMAKE_SOURCE_DIR}/src/Logger/Logger.h
+  ${CMAKE_SOURCE_DIR}/src/Logger/LoggerMacro.h
+
+  ${CMAKE_SOURCE_DIR}/src/Memory/BufferPool.cpp
+  ${CMAKE_SOURCE_DIR}/src/Memory/BufferPool.h
+  ${CMAKE_SOURCE_DIR}/src/Memory/MemoryTracker.cpp
+  ${CMAKE_SOURCE_DIR}/src/Memory/MemoryTracker.h
+
+  ${CMAKE_SOURCE_DIR}/src/Profiling/Profiler.cpp
+  ${CMAKE_SOURCE_DIR}/src/Profiling/Profiler.h
+  ${CMAKE_SOURCE_DIR}/src/Profiling/TraceRecorder.cpp
+  ${CMAKE_SOURCE_DIR}/src/Profiling/TraceRecorder.h
+
+  ${CMAKE_SOURCE_DIR}/src/Utils/HashRandom.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/HalfFloat.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/RandomGenerator.h
+  ${CMAKE_SOURCE_DIR}/src/Utils/ThreadPool.h
+)
+
+target_include_directories(NoiseCore PUBLIC
+  ${CMAKE_SOURCE_DIR}/src
+)
+
+set_target_properties(NoiseCore PROPERTIES
+  CXX_STANDARD 17
+  CXX_STANDARD_REQUIRED ON
+  CXX_EXTENSIONS OFF
+)
+
+find_package(Threads REQUIRED)
+target_link_libraries(NoiseCore PUBLIC Threads::Threads)
+
+# Public so every consumer sees the same Profiler::bEnabled
+if(NOISE_ENABLE_PROFILING)
+  target_compile_definitions(NoiseCore PUBLIC NG_ENABLE_PROFILING=1)
+else()
+  target_compile_definitions(NoiseCore PUBLIC NG_ENABLE_PROFILING=0)
+endif()
+
+# -----------------------
+# Optimization and ISA
+# -----------------------
+# SSE2 / AVX2 kernels are selected at runtime (NoiseMath.cpp), so the default
+# build runs on any x86-64 machine. FP contraction stays off: fused multiply-adds
+# would round differently from the scalar reference kernels.
+if(CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+  if(NOISE_CORE_OPTIMIZE)
+    target_compile_options(NoiseCore PRIVATE -O3)
+  endif()
+  target_compile_options(NoiseCore PRIVATE -ffp-contract=off)
+  if(NOISE_CORE_NATIVE)
+    target_compile_options(NoiseCore PRIVATE -march=native)
+  endif()
+elseif(MSVC)
+  # /O2 conflicts with the /RTC1 runtime checks of Debug builds
+  if(NOISE_CORE_OPTIMIZE)
+    target_compile_options(NoiseCore PRIVATE $<$<NOT:$<CONFIG:Debug>>:/O2 /Ob2>)
+  endif()
+  target_compile_options(NoiseCore PRIVATE /fp:precise)
+  if(NOISE_CORE_NATIVE)
+    target_compile_options(NoiseCore PRIVATE /arch:AVX2)
+  endif()
+endif()
+
+message(STATUS "🧩 NoiseCore configured (optimize=${NOISE_CORE_OPTIMIZE}, native=${NOISE_CORE_NATIVE}, profiling=${NOISE_ENABLE_PROFILING})")
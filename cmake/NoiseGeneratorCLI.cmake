@@ -0,0 +1,35 @@
+# -----------------------
+# NoiseGeneratorCLI: headless batch renderer
+# -----------------------
+# Renders job manifests on a thread pool. Links only NoiseCore, so it builds
+# and runs on machines without a display or GL driver.
+option(BUILD_CLI "Build the NoiseGeneratorCLI batch renderer" ON)
+
+if(BUILD_CLI)
+  add_executable(NoiseGeneratorCLI
+    ${CMAKE_SOURCE_DIR}/src/CLI/main.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/BatchRunner.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/BatchRunner.h
+    ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.h
+  )
+
+  source_group(TREE ${CMAKE_SOURCE_DIR}/src PREFIX "Source" FILES
+    ${CMAKE_SOURCE_DIR}/src/CLI/main.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/BatchRunner.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/BatchRunner.h
+    ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.cpp
+    ${CMAKE_SOURCE_DIR}/src/CLI/JobManifest.h
+  )
+
+  target_link_libraries(NoiseGeneratorCLI PRIVATE NoiseCore)
+  target_compile_definitions(NoiseGeneratorCLI PRIVATE _CRT_SECURE_NO_WARNINGS)
+
+  set_target_properties(NoiseGeneratorCLI PROPERTIES
+    CXX_STANDARD 17
+    CXX_STANDARD_REQUIRED ON
+    CXX_EXTENSIONS OFF
+  )
+
+  message(STATUS "🧮 NoiseGeneratorCLI configured")
+endif()
@@ -1,5 +1,8 @@
 #include "NGApplication.h"
 #include "Config/SettingsManager.h"
+#include "Memory/BufferPool.h"
+#include "Noise/NoiseCache.h"
+#include <algorithm>
 
 
 
@@ -70,6 +73,15 @@ InitStatus NGApplication::InitializeApplication()
 	}
 
 	SettingsManager::Get().Load();
+
+	HugePageMode hugePages = HugePageMode::Off;
+	if(BufferPool::ParseHugePageMode(SettingsManager::Get().GetHugePages(), hugePages))
+		BufferPool::Get().SetHugePageMode(hugePages);
+	else
+		NGLOG(LogApp, Warning, "Unknown [engine] huge_pages value '" + SettingsManager::Get().GetHugePages() + "', expected off, advise or explicit");
+
+	NoiseCache::Get().SetCapacity((uint64_t)std::max(0, SettingsManager::Get().GetCacheMegabytes()) << 20);
+	NoiseCache::Get().SetDirectory(SettingsManager::Get().GetCacheDirectory());
 	
 	WindowWidth = SettingsManager::Get().GetWindowWidth();
 	WindowHeight = SettingsManager::Get().GetWindowHeight();
@@ -0,0 +1,178 @@
+#include "BatchRunner.h"
+#include "Export/HeightmapFile.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/MemoryTracker.h"
+#include "Noise/NoiseCache.h"
+#include "Noise/NoiseGenerator.h"
+#include "Profiling/TraceRecorder.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <ThirdParty/stb_image_write.h>
+
+DEFINE_LOG_CATEGORY(LogBatch);
+
+namespace
+{
+	std::string LowerExtension(const std::string& path)
+	{
+		std::string extension = std::filesystem::path(path).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(),
+			[] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension;
+	}
+
+	bool WritePNG(const std::string& path, const float* data, int res)
+	{
+		TrackedVector<unsigned char> gray((size_t)res * res);
+		for(size_t i = 0; i < gray.size(); i++)
+			gray[i] = static_cast<unsigned char>(std::clamp(data[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+
+		return stbi_write_png(path.c_str(), res, res, 1, gray.data(), res) != 0;
+	}
+
+	bool WriteRaw(const std::string& path, const float* data, int res)
+	{
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(data), (std::streamsize)((size_t)res * res * sizeof(float)));
+		return file.good();
+	}
+}
+
+BatchRunner::BatchRunner(const BatchOptions& inOptions)
+	: options(inOptions)
+{
+}
+
+std::vector<JobResult> BatchRunner::Run(const std::vector<NoiseJob>& jobs, const std::function<void(const JobResult&)>& onJobFinished) const
+{
+	std::vector<JobResult> results(jobs.size());
+	if(jobs.empty())
+		return results;
+
+	const unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	const unsigned int poolSize = std::min<unsigned int>(
+		options.concurrentJobs > 0 ? options.concurrentJobs : hardwareThreads, (unsigned int)jobs.size());
+
+	NoiseExecution exec;
+	exec.threadCount = options.threadsPerJob > 0 ? options.threadsPerJob : (int)std::max(1u, hardwareThreads / poolSize);
+
+	std::mutex mutex;
+	{
+		// The pool drains its queue before joining, so leaving the scope waits for every job
+		ThreadPool pool(poolSize);
+		for(size_t i = 0; i < jobs.size(); i++)
+		{
+			pool.Enqueue([&, i] ()
+				{
+					NG_TRACE_THREAD_NAME("Job worker");
+					JobResult result = RunJob(jobs[i], exec);
+
+					std::lock_guard<std::mutex> lock(mutex);
+					results[i] = std::move(result);
+					if(onJobFinished) onJobFinished(results[i]);
+				});
+		}
+	}
+
+	return results;
+}
+
+JobResult BatchRunner::RunJob(const NoiseJob& job, const NoiseExecution& exec)
+{
+	JobResult result;
+	result.name = job.name;
+	NG_TRACE_SCOPE(job.name.c_str());
+
+	const auto start = std::chrono::steady_clock::now();
+
+	try
+	{
+		NoiseCache& cache = NoiseCache::Get();
+		const NoiseCacheKey key = NoiseCache::MakeKey(job.algorithm, job.resolution, job.props, job.worleyFeature);
+		std::shared_ptr<const NoiseImage> data = cache.Find(key);
+		result.bFromCache = data != nullptr;
+
+		// One memory job for generation and encoding, so the budget covers the whole peak
+		MemoryJobScope memoryJob(job.name, EstimateJobBytes(job, result.bFromCache));
+
+		if(!data)
+		{
+			if(job.algorithm == NoiseAlgorithm::Worley)
+				data = cache.Insert(key, NG::WorleyNoise2D(job.resolution, &job.props, nullptr, job.worleyFeature));
+			else
+				data = cache.Insert(key, NG::FBMNoise2D(job.resolution, &job.props, nullptr, exec));
+		}
+
+		if(data)
+		{
+			result.bSucceeded = WriteOutput(job, data->Data(), result.error);
+		}
+		else
+		{
+			result.error = "generation failed";
+		}
+
+		result.peakBytes = memoryJob.GetPeakBytes();
+	}
+	catch(const std::exception& e)
+	{
+		result.error = e.what();
+	}
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if(result.bSucceeded && result.seconds > 0.0)
+		result.megapixelsPerSecond = (double)job.resolution * job.resolution / 1.0e6 / result.seconds;
+
+	if(!result.bSucceeded)
+		NGLOG(LogBatch, Error, "Job '" + job.name + "' failed: " + result.error);
+
+	return result;
+}
+
+uint64_t BatchRunner::EstimateJobBytes(const NoiseJob& job, bool bCached)
+{
+	const uint64_t generation = bCached ? 0
+		: job.algorithm == NoiseAlgorithm::Worley ? NG::EstimateWorleyNoise2DBytes(job.resolution, &job.props)
+		: NG::EstimateFBMNoise2DBytes(job.resolution, &job.props);
+
+	// PNG output is encoded from an 8-bit copy of the image
+	const uint64_t encoding = LowerExtension(job.output) == ".png" ? (uint64_t)job.resolution * job.resolution : 0;
+	return generation + encoding;
+}
+
+bool BatchRunner::WriteOutput(const NoiseJob& job, const float* data, std::string& outError)
+{
+	NG_PROFILE_STAGE("WriteOutput", (int64_t)job.resolution * job.resolution);
+
+	const std::filesystem::path folder = std::filesystem::path(job.output).parent_path();
+	std::error_code ec;
+	if(!folder.empty())
+		std::filesystem::create_directories(folder, ec);
+
+	const std::string extension = LowerExtension(job.output);
+	bool bWritten = false;
+	if(extension == ".png")
+		bWritten = WritePNG(job.output, data, job.resolution);
+	else if(extension == HeightmapFile::Extension)
+		bWritten = HeightmapFile::Save(job.output, data, job.resolution, job.resolution, job.heightmapFormat, &job.props);
+	else if(extension == ".raw")
+		bWritten = WriteRaw(job.output, data, job.resolution);
+	else
+	{
+		outError = "unsupported output extension '" + extension + "' (expected .png, .ngh or .raw)";
+		return false;
+	}
+
+	if(!bWritten)
+		outError = "failed to write " + job.output;
+	return bWritten;
+}
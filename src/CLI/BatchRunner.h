@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CLI/JobManifest.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Outcome of one batch job */
+struct JobResult
+{
+	std::string name;
+	bool bSucceeded = false;
+	std::string error;
+
+	/** Wall time of generation plus writing the output */
+	double seconds = 0.0;
+	double megapixelsPerSecond = 0.0;
+
+	/** Highest memory the job held at once, from the MemoryTracker */
+	int64_t peakBytes = 0;
+
+	/** Whether the image came from the NoiseCache instead of being generated */
+	bool bFromCache = false;
+};
+
+struct BatchOptions
+{
+	/** Jobs rendered at the same time, 0 uses every hardware thread */
+	unsigned int concurrentJobs = 0;
+
+	/** Threads working inside one job, 0 splits the hardware threads between the running jobs */
+	int threadsPerJob = 0;
+};
+
+/**
+ * Renders noise jobs on a thread pool and writes each result to its output file.
+ * Never touches GL: images are encoded from the float buffers directly.
+ * Images are looked up in and added to NoiseCache::Get(), jobs repeating an earlier map only write it.
+ */
+class BatchRunner
+{
+public:
+	explicit BatchRunner(const BatchOptions& options = {});
+
+	/**
+	 * Runs every job and returns the results in job order.
+	 * onJobFinished is called as soon as a job completes, from a pool thread, one call at a time.
+	 */
+	std::vector<JobResult> Run(const std::vector<NoiseJob>& jobs, const std::function<void(const JobResult&)>& onJobFinished = nullptr) const;
+
+	/** Generates and writes a single job on the calling thread */
+	static JobResult RunJob(const NoiseJob& job, const NoiseExecution& exec = {});
+
+	/** Memory a job reserves from the budget: its generator's estimate (unless cached) plus output encoding */
+	static uint64_t EstimateJobBytes(const NoiseJob& job, bool bCached = false);
+
+	/** Writes a width x width map to job.output in the format picked by its extension */
+	static bool WriteOutput(const NoiseJob& job, const float* data, std::string& outError);
+
+private:
+	BatchOptions options;
+};
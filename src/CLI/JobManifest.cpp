@@ -0,0 +1,258 @@
+#include "JobManifest.h"
+#include "Noise/NoiseMath.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+	std::string Trim(const std::string& text)
+	{
+		const size_t begin = text.find_first_not_of(" \t\r\n");
+		if(begin == std::string::npos)
+			return {};
+		const size_t end = text.find_last_not_of(" \t\r\n");
+		return text.substr(begin, end - begin + 1);
+	}
+
+	std::string ToLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(),
+			[] (unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	}
+
+	/** Whole-string numeric conversion, trailing garbage is an error */
+	template<typename T, typename Convert>
+	bool ParseNumber(const std::string& text, T& out, Convert convert)
+	{
+		try
+		{
+			size_t used = 0;
+			const T value = convert(text, &used);
+			if(used != text.size())
+				return false;
+			out = value;
+			return true;
+		}
+		catch(const std::exception&)
+		{
+			return false;
+		}
+	}
+
+	bool ParseInt(const std::string& text, int& out)
+	{
+		return ParseNumber(text, out, [] (const std::string& s, size_t* used) { return std::stoi(s, used); });
+	}
+
+	bool ParseLong(const std::string& text, long& out)
+	{
+		return ParseNumber(text, out, [] (const std::string& s, size_t* used) { return std::stol(s, used); });
+	}
+
+	bool ParseFloat(const std::string& text, float& out)
+	{
+		return ParseNumber(text, out, [] (const std::string& s, size_t* used) { return std::stof(s, used); });
+	}
+
+	/** Resolution index the GUI stores in NoiseProperties::res (8 << index pixels) */
+	int ResolutionIndex(int resolution)
+	{
+		int index = 0;
+		while((8 << index) < resolution) index++;
+		return index;
+	}
+}
+
+bool JobManifest::Load(const std::string& path)
+{
+	std::ifstream file(path);
+	if(!file.is_open())
+	{
+		jobs.clear();
+		source = path;
+		line = 0;
+		return Fail("cannot open file");
+	}
+
+	if(!Parse(file, path))
+		return false;
+
+	const std::filesystem::path folder = std::filesystem::path(path).parent_path();
+	for(NoiseJob& job : jobs)
+	{
+		if(std::filesystem::path(job.output).is_relative())
+			job.output = (folder / job.output).string();
+	}
+	return true;
+}
+
+bool JobManifest::Parse(std::istream& input, const std::string& inSource)
+{
+	jobs.clear();
+	error.clear();
+	source = inSource;
+	line = 0;
+
+	NoiseJob defaults;
+	NoiseJob* current = nullptr;
+	bool bInDefaults = false;
+
+	std::string text;
+	while(std::getline(input, text))
+	{
+		line++;
+
+		const size_t comment = text.find_first_of(";#");
+		text = Trim(comment == std::string::npos ? text : text.substr(0, comment));
+		if(text.empty())
+			continue;
+
+		if(text.front() == '[')
+		{
+			if(text.back() != ']')
+				return Fail("unterminated section header");
+
+			if(current && !ValidateJob(*current))
+				return false;
+
+			const std::string name = Trim(text.substr(1, text.size() - 2));
+			if(name.empty())
+				return Fail("empty job name");
+
+			bInDefaults = ToLower(name) == DefaultsSection;
+			current = nullptr;
+			if(!bInDefaults)
+			{
+				for(const NoiseJob& job : jobs)
+				{
+					if(job.name == name)
+						return Fail("duplicate job '" + name + "'");
+				}
+
+				jobs.push_back(defaults);
+				jobs.back().name = name;
+				current = &jobs.back();
+			}
+			continue;
+		}
+
+		const size_t equals = text.find('=');
+		if(equals == std::string::npos)
+			return Fail("expected 'key = value'");
+
+		const std::string key = ToLower(Trim(text.substr(0, equals)));
+		const std::string value = Trim(text.substr(equals + 1));
+		if(!current && !bInDefaults)
+			return Fail("'" + key + "' outside of a job section");
+
+		if(!SetValue(bInDefaults ? defaults : *current, key, value))
+			return false;
+	}
+
+	if(current && !ValidateJob(*current))
+		return false;
+
+	if(jobs.empty())
+		return Fail("no jobs");
+
+	return true;
+}
+
+bool JobManifest::SetValue(NoiseJob& job, const std::string& key, const std::string& value)
+{
+	NoiseProperties& props = job.props;
+	bool bParsed = true;
+
+	if(key == "algorithm")
+	{
+		const std::string name = ToLower(value);
+		if(name == "fbm") job.algorithm = NoiseAlgorithm::FBM;
+		else if(name == "worley") job.algorithm = NoiseAlgorithm::Worley;
+		else return Fail("unknown algorithm '" + value + "' (expected fbm or worley)");
+	}
+	else if(key == "feature")
+	{
+		const std::string name = ToLower(value);
+		if(name == "f1") job.worleyFeature = NG::WorleyFeature::F1;
+		else if(name == "f2") job.worleyFeature = NG::WorleyFeature::F2;
+		else if(name == "f2-f1") job.worleyFeature = NG::WorleyFeature::F2MinusF1;
+		else return Fail("unknown Worley feature '" + value + "' (expected f1, f2 or f2-f1)");
+	}
+	else if(key == "domain")
+	{
+		const std::string name = ToLower(value);
+		if(name == "tiled") props.domain = NoiseDomain::Tiled;
+		else if(name == "unbounded") props.domain = NoiseDomain::Unbounded;
+		else return Fail("unknown domain '" + value + "' (expected tiled or unbounded)");
+	}
+	else if(key == "format")
+	{
+		const std::string name = ToLower(value);
+		if(name == "float32") job.heightmapFormat = HeightmapFormat::Float32;
+		else if(name == "float16") job.heightmapFormat = HeightmapFormat::Float16;
+		else if(name == "uint16") job.heightmapFormat = HeightmapFormat::UInt16;
+		else return Fail("unknown heightmap format '" + value + "' (expected float32, float16 or uint16)");
+	}
+	else if(key == "output")                      job.output = value;
+	else if(key == "resolution")                  bParsed = ParseInt(value, job.resolution);
+	else if(key == "seed")                        bParsed = ParseLong(value, props.seed);
+	else if(key == "roughness")                   bParsed = ParseFloat(value, props.roughness);
+	else if(key == "low_freq_skip")               bParsed = ParseInt(value, props.low_freq_skip);
+	else if(key == "high_freq_skip")              bParsed = ParseInt(value, props.high_freq_skip);
+	else if(key == "marbling")                    bParsed = ParseFloat(value, props.marbling);
+	else if(key == "turbulence")                  bParsed = ParseFloat(value, props.turbulence);
+	else if(key == "turbulence_res")              bParsed = ParseInt(value, props.turbulence_res);
+	else if(key == "turbulence_roughness")        bParsed = ParseFloat(value, props.turbulence_roughness);
+	else if(key == "turbulence_low_freq_skip")    bParsed = ParseInt(value, props.turbulence_low_freq_skip);
+	else if(key == "turbulence_high_freq_skip")   bParsed = ParseInt(value, props.turbulence_high_freq_skip);
+	else if(key == "turbulence_marbling")         bParsed = ParseFloat(value, props.turbulence_marbling);
+	else if(key == "turbulence_expshift")         bParsed = ParseFloat(value, props.turbulence_expshift);
+	else if(key == "turbulence_offset_x")         bParsed = ParseFloat(value, props.turbulence_offset_x);
+	else if(key == "turbulence_offset_y")         bParsed = ParseFloat(value, props.turbulence_offset_y);
+	else return Fail("unknown key '" + key + "'");
+
+	if(!bParsed)
+		return Fail("invalid value '" + value + "' for '" + key + "'");
+
+	return true;
+}
+
+bool JobManifest::ValidateJob(NoiseJob& job)
+{
+	if(job.resolution < MinResolution || job.resolution > MaxResolution || !NG::IsPowerOfTwo(job.resolution))
+	{
+		return Fail("job '" + job.name + "': resolution must be a power of two in ["
+			+ std::to_string(MinResolution) + ", " + std::to_string(MaxResolution) + "]");
+	}
+
+	if(job.output.empty())
+		return Fail("job '" + job.name + "' has no output");
+
+	const std::string extension = ToLower(std::filesystem::path(job.output).extension().string());
+	if(extension != ".png" && extension != HeightmapFile::Extension && extension != ".raw")
+		return Fail("job '" + job.name + "': output must end in .png, .ngh or .raw");
+
+	// turbulence_res indexes NoiseResolutions and is shifted by the noise stage
+	const NoiseProperties& props = job.props;
+	if(props.turbulence_res < 0 || props.turbulence_res >= NoiseResolutionCount)
+	{
+		return Fail("job '" + job.name + "': turbulence_res must be in [0, "
+			+ std::to_string(NoiseResolutionCount - 1) + "]");
+	}
+
+	if(props.low_freq_skip < 0 || props.high_freq_skip < 0 || props.turbulence_low_freq_skip < 0 || props.turbulence_high_freq_skip < 0)
+		return Fail("job '" + job.name + "': frequency skips must not be negative");
+
+	job.props.res = ResolutionIndex(job.resolution);
+	return true;
+}
+
+bool JobManifest::Fail(const std::string& message)
+{
+	error = source + (line > 0 ? ":" + std::to_string(line) : std::string()) + ": " + message;
+	return false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Export/HeightmapFile.h"
+#include "Noise/NoiseTypes.h"
+#include "Noise/WorleyGrid.h"
+#include <istream>
+#include <string>
+#include <vector>
+
+/** One map to render: the full generator settings plus where the result goes */
+struct NoiseJob
+{
+	std::string name;
+	NoiseAlgorithm algorithm = NoiseAlgorithm::FBM;
+	NG::WorleyFeature worleyFeature = NG::WorleyFeature::F1;
+
+	/** Width and height in pixels, a power of two */
+	int resolution = 512;
+	NoiseProperties props{};
+
+	/** .png writes 8 bit grayscale, .ngh a raw heightmap in heightmapFormat, .raw bare float32 */
+	std::string output;
+	HeightmapFormat heightmapFormat = HeightmapFormat::Float32;
+};
+
+/**
+ * Job manifest for NoiseGeneratorCLI, an INI-like text file:
+ *
+ *   ; comment
+ *   [defaults]            ; optional, applies to every job declared after it
+ *   roughness = 0.5
+ *
+ *   [mountains]           ; one section per job, the section name is the job name
+ *   algorithm = fbm       ; fbm | worley
+ *   resolution = 2048
+ *   seed = 42
+ *   output = out/mountains.ngh
+ *
+ * Keys match the NoiseProperties field names (roughness, low_freq_skip, turbulence_res, ...),
+ * plus algorithm, feature (f1 | f2 | f2-f1), domain (tiled | unbounded), resolution, output
+ * and format (float32 | float16 | uint16).
+ */
+class JobManifest
+{
+public:
+	static constexpr const char* DefaultsSection = "defaults";
+	static constexpr int MinResolution = 8;
+	static constexpr int MaxResolution = 65536;
+
+	/** Reads path, relative outputs are resolved against the manifest's folder */
+	bool Load(const std::string& path);
+
+	/** Parses manifest text, source is only used in error messages */
+	bool Parse(std::istream& input, const std::string& source = "manifest");
+
+	const std::vector<NoiseJob>& GetJobs() const { return jobs; }
+
+	/** Description of the first problem found by Load/Parse */
+	const std::string& GetError() const { return error; }
+
+private:
+	bool SetValue(NoiseJob& job, const std::string& key, const std::string& value);
+	/** Checks a finished job section and fills the fields derived from it */
+	bool ValidateJob(NoiseJob& job);
+	bool Fail(const std::string& message);
+
+	std::vector<NoiseJob> jobs;
+	std::string error;
+	std::string source;
+	int line = 0;
+};
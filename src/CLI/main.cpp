@@ -0,0 +1,228 @@
+/*
+	NoiseGeneratorCLI: renders a job manifest without a display.
+
+	Usage: NoiseGeneratorCLI <manifest> [--jobs N] [--threads-per-job N] [--memory-budget MB [--memory-policy P]]
+	                         [--huge-pages MODE] [--cache-mb MB] [--cache-dir DIR] [--trace FILE] [--quiet]
+	See CLI/JobManifest.h for the manifest format.
+*/
+
+#include "CLI/BatchRunner.h"
+#include "CLI/JobManifest.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "Noise/NoiseCache.h"
+#include "Profiling/TraceRecorder.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace
+{
+	const char* AlgorithmName(NoiseAlgorithm algorithm)
+	{
+		return algorithm == NoiseAlgorithm::Worley ? "Worley" : "FBM";
+	}
+
+	void PrintUsage()
+	{
+		printf("Usage: NoiseGeneratorCLI <manifest> [options]\n"
+			"\n"
+			"Options:\n"
+			"  --jobs N              jobs rendered at the same time (default: hardware threads)\n"
+			"  --threads-per-job N   threads inside one job (default: hardware threads / jobs)\n"
+			"  --memory-budget MB    limit the memory reserved by the running jobs\n"
+			"  --memory-policy P     jobs over the budget: queue (wait for memory, default) or refuse\n"
+			"  --huge-pages MODE     pages of large buffers: off (default), advise (transparent) or explicit (hugetlbfs)\n"
+			"  --cache-mb MB         memory kept for finished maps reused by identical jobs (default 256, 0 disables)\n"
+			"  --cache-dir DIR       also cache maps in DIR, shared between runs\n"
+			"  --trace FILE          write a Chrome trace (chrome://tracing, Perfetto) of the run\n"
+			"  --quiet               only print the summary\n"
+			"\n"
+			"Exit code: 0 all jobs succeeded, 1 a job failed, 2 invalid arguments or manifest\n");
+	}
+
+	bool ParsePolicy(const char* text, MemoryBudgetPolicy& out)
+	{
+		if(!strcmp(text, "queue")) out = MemoryBudgetPolicy::Queue;
+		else if(!strcmp(text, "refuse")) out = MemoryBudgetPolicy::Refuse;
+		else return false;
+		return true;
+	}
+
+	bool ParseCount(const char* text, int& out)
+	{
+		char* end = nullptr;
+		const long value = strtol(text, &end, 10);
+		if(!end || *end != '\0' || value <= 0 || value > 4096)
+			return false;
+		out = static_cast<int>(value);
+		return true;
+	}
+
+	bool ParseMegabytes(const char* text, long long& out)
+	{
+		char* end = nullptr;
+		const long long value = strtoll(text, &end, 10);
+		if(!end || *end != '\0' || value < 0 || value > (1ll << 30))
+			return false;
+		out = value;
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string manifestPath, tracePath, cacheDirectory;
+	BatchOptions options;
+	bool bQuiet = false;
+	long long budgetMegabytes = 0;
+	MemoryBudgetPolicy budgetPolicy = MemoryBudgetPolicy::Queue;
+	HugePageMode hugePages = HugePageMode::Off;
+	long long cacheMegabytes = (long long)(NoiseCache::DefaultCapacity >> 20);
+
+	for(int i = 1; i < argc; i++)
+	{
+		int count = 0;
+		if(!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h"))
+		{
+			PrintUsage();
+			return 0;
+		}
+		else if(!strcmp(argv[i], "--jobs") && i + 1 < argc && ParseCount(argv[i + 1], count))
+		{
+			options.concurrentJobs = static_cast<unsigned int>(count);
+			i++;
+		}
+		else if(!strcmp(argv[i], "--threads-per-job") && i + 1 < argc && ParseCount(argv[i + 1], count))
+		{
+			options.threadsPerJob = count;
+			i++;
+		}
+		else if(!strcmp(argv[i], "--memory-budget") && i + 1 < argc && ParseMegabytes(argv[i + 1], budgetMegabytes) && budgetMegabytes > 0)
+		{
+			i++;
+		}
+		else if(!strcmp(argv[i], "--memory-policy") && i + 1 < argc && ParsePolicy(argv[i + 1], budgetPolicy))
+		{
+			i++;
+		}
+		else if(!strcmp(argv[i], "--huge-pages") && i + 1 < argc && BufferPool::ParseHugePageMode(argv[i + 1], hugePages))
+		{
+			i++;
+		}
+		else if(!strcmp(argv[i], "--cache-mb") && i + 1 < argc && ParseMegabytes(argv[i + 1], cacheMegabytes))
+		{
+			i++;
+		}
+		else if(!strcmp(argv[i], "--cache-dir") && i + 1 < argc)
+		{
+			cacheDirectory = argv[++i];
+		}
+		else if(!strcmp(argv[i], "--trace") && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+		else if(!strcmp(argv[i], "--quiet"))
+		{
+			bQuiet = true;
+		}
+		else if(argv[i][0] != '-' && manifestPath.empty())
+		{
+			manifestPath = argv[i];
+		}
+		else
+		{
+			fprintf(stderr, "Invalid argument: %s\n\n", argv[i]);
+			PrintUsage();
+			return 2;
+		}
+	}
+
+	if(manifestPath.empty())
+	{
+		PrintUsage();
+		return 2;
+	}
+
+	Logger::bEchoToConsole = !bQuiet;
+
+	JobManifest manifest;
+	if(!manifest.Load(manifestPath))
+	{
+		fprintf(stderr, "%s\n", manifest.GetError().c_str());
+		return 2;
+	}
+
+	const std::vector<NoiseJob>& jobs = manifest.GetJobs();
+	BatchRunner runner(options);
+
+	if(budgetMegabytes > 0)
+		MemoryTracker::Get().SetBudget((uint64_t)budgetMegabytes << 20, budgetPolicy);
+	BufferPool::Get().SetHugePageMode(hugePages);
+	NoiseCache::Get().SetCapacity((uint64_t)cacheMegabytes << 20);
+	NoiseCache::Get().SetDirectory(cacheDirectory);
+
+	if(!tracePath.empty())
+	{
+		if(!Profiler::bEnabled)
+			fprintf(stderr, "Warning: built with NOISE_ENABLE_PROFILING=OFF, the trace will be empty\n");
+		NG_TRACE_THREAD_NAME("Main");
+		TraceRecorder::Get().Start();
+	}
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<JobResult> results = runner.Run(jobs, [&] (const JobResult& result)
+		{
+			if(bQuiet) return;
+
+			if(result.bSucceeded)
+				printf("[done] %-24s %8.1f ms  %8.2f MP/s%s\n", result.name.c_str(), result.seconds * 1000.0, result.megapixelsPerSecond,
+					result.bFromCache ? "  (cached)" : "");
+			else
+				printf("[fail] %-24s %8.1f ms  %s\n", result.name.c_str(), result.seconds * 1000.0, result.error.c_str());
+			fflush(stdout);
+		});
+	const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	if(!tracePath.empty())
+	{
+		TraceRecorder::Get().Stop();
+		if(TraceRecorder::Get().WriteChromeTrace(tracePath))
+			printf("Trace with %zu events written to %s\n", TraceRecorder::Get().GetEventCount(), tracePath.c_str());
+		else
+			fprintf(stderr, "Cannot write trace %s\n", tracePath.c_str());
+	}
+
+	printf("\n%-24s %-7s %11s %10s %10s %9s  %s\n", "job", "noise", "size", "time (ms)", "MP/s", "peak MB", "output");
+	double totalMegapixels = 0.0;
+	int failed = 0;
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		const NoiseJob& job = jobs[i];
+		const JobResult& result = results[i];
+		const std::string size = std::to_string(job.resolution) + "x" + std::to_string(job.resolution);
+
+		if(result.bSucceeded)
+		{
+			totalMegapixels += (double)job.resolution * job.resolution / 1.0e6;
+			printf("%-24s %-7s %11s %10.1f %10.2f %9.1f  %s\n", job.name.c_str(), AlgorithmName(job.algorithm), size.c_str(),
+				result.seconds * 1000.0, result.megapixelsPerSecond, result.peakBytes / (1024.0 * 1024.0), job.output.c_str());
+		}
+		else
+		{
+			failed++;
+			printf("%-24s %-7s %11s %10s %10s %9s  FAILED: %s\n", job.name.c_str(), AlgorithmName(job.algorithm), size.c_str(),
+				"-", "-", "-", result.error.c_str());
+		}
+	}
+
+	printf("\n%zu jobs, %d failed, %.2f s wall, %.2f MP/s overall, %.1f MB peak\n", jobs.size(), failed, totalSeconds,
+		totalSeconds > 0.0 ? totalMegapixels / totalSeconds : 0.0, MemoryTracker::Get().GetPeakBytes() / (1024.0 * 1024.0));
+	printf("Cache: %llu hits, %llu from disk, %llu misses\n", (unsigned long long)NoiseCache::Get().GetHitCount(),
+		(unsigned long long)NoiseCache::Get().GetDiskHitCount(), (unsigned long long)NoiseCache::Get().GetMissCount());
+
+	return failed > 0 ? 1 : 0;
+}
@@ -51,4 +51,29 @@ float SettingsManager::GetFontSize() const
 std::string SettingsManager::GetTheme() const 
 {
 	return reader.Get("imgui", "theme", "dark");
+}
+
+std::string SettingsManager::GetHugePages() const 
+{
+	return reader.Get("engine", "huge_pages", "off");
+}
+
+int SettingsManager::GetCacheMegabytes() const 
+{
+	return reader.GetInteger("engine", "cache_mb", 256);
+}
+
+std::string SettingsManager::GetCacheDirectory() const 
+{
+	return reader.Get("engine", "cache_dir", "");
+}
+
+std::string SettingsManager::GetOctaveLayers() const 
+{
+	return reader.Get("engine", "octave_layers", "off");
+}
+
+int SettingsManager::GetOctaveLayersMegabytes() const 
+{
+	return reader.GetInteger("engine", "octave_layers_mb", 768);
 }
\ No newline at end of file
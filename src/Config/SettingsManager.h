@@ -17,6 +17,17 @@ public:
 	float GetFontSize() const;
 	std::string GetTheme() const;
 
+	/** [engine] huge_pages: off | advise | explicit, see BufferPool */
+	std::string GetHugePages() const;
+
+	/** [engine] cache_mb and cache_dir: memory and disk tier of the NoiseCache */
+	int GetCacheMegabytes() const;
+	std::string GetCacheDirectory() const;
+
+	/** [engine] octave_layers (off | float32 | float16) and octave_layers_mb: the OctaveLayerCache of the editor */
+	std::string GetOctaveLayers() const;
+	int GetOctaveLayersMegabytes() const;
+
 private:
 	SettingsManager() = default;
 	INIReader reader{ "config/settings.ini" };
@@ -0,0 +1,344 @@
+#include "HeightmapFile.h"
+#include "Logger/LoggerMacro.h"
+#include "Profiling/Profiler.h"
+#include "Utils/HalfFloat.h"
+#include <algorithm>
+#include <cstring>
+
+DEFINE_LOG_CATEGORY(LogHeightmap);
+
+namespace
+{
+	/**
+	 * Header layout, all fields little-endian:
+	 *   0  char[4]  magic "NGHM"
+	 *   4  u32      version
+	 *   8  u32      width
+	 *  12  u32      height
+	 *  16  u32      format (HeightmapFormat)
+	 *  20  u32      pixel data offset
+	 *  24  u32      flags (bit 0: properties present)
+	 *  28  u32      noise domain (NoiseDomain, 0 = Tiled in files older than the field)
+	 *  32  i64      seed, followed by the remaining NoiseProperties fields as 32-bit values
+	 *      in declaration order, zero padded up to the data offset
+	 */
+	constexpr char Magic[4] = { 'N', 'G', 'H', 'M' };
+	constexpr uint32_t Version = 1;
+	constexpr uint32_t FlagHasProperties = 1u;
+
+	/** Keeps the pixel data 64 byte aligned inside the page aligned mapping */
+	constexpr size_t DataOffset = 128;
+
+	size_t BytesPerPixel(HeightmapFormat format)
+	{
+		return format == HeightmapFormat::Float32 ? 4 : 2;
+	}
+
+	bool IsValidFormat(uint32_t format)
+	{
+		return format <= static_cast<uint32_t>(HeightmapFormat::UInt16);
+	}
+
+	class HeaderWriter
+	{
+	public:
+		explicit HeaderWriter(uint8_t* data) : data(data) {}
+
+		void U32(uint32_t value)
+		{
+			for(int i = 0; i < 4; i++) data[offset++] = static_cast<uint8_t>(value >> (8 * i));
+		}
+
+		void I32(int32_t value) { U32(static_cast<uint32_t>(value)); }
+
+		void I64(int64_t value)
+		{
+			U32(static_cast<uint32_t>(static_cast<uint64_t>(value)));
+			U32(static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+		}
+
+		void F32(float value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			U32(bits);
+		}
+
+	private:
+		uint8_t* data;
+		size_t offset = 0;
+	};
+
+	class HeaderReader
+	{
+	public:
+		explicit HeaderReader(const uint8_t* data) : data(data) {}
+
+		uint32_t U32()
+		{
+			uint32_t value = 0;
+			for(int i = 0; i < 4; i++) value |= static_cast<uint32_t>(data[offset++]) << (8 * i);
+			return value;
+		}
+
+		int32_t I32() { return static_cast<int32_t>(U32()); }
+
+		int64_t I64()
+		{
+			const uint64_t low = U32();
+			const uint64_t high = U32();
+			return static_cast<int64_t>(low | (high << 32));
+		}
+
+		float F32()
+		{
+			const uint32_t bits = U32();
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+	private:
+		const uint8_t* data;
+		size_t offset = 0;
+	};
+
+	void WriteHeader(uint8_t* data, const HeightmapHeader& header)
+	{
+		memset(data, 0, DataOffset);
+		memcpy(data, Magic, sizeof(Magic));
+
+		HeaderWriter writer(data + sizeof(Magic));
+		writer.U32(Version);
+		writer.U32(static_cast<uint32_t>(header.width));
+		writer.U32(static_cast<uint32_t>(header.height));
+		writer.U32(static_cast<uint32_t>(header.format));
+		writer.U32(static_cast<uint32_t>(DataOffset));
+		writer.U32(header.bHasProperties ? FlagHasProperties : 0u);
+		writer.U32(static_cast<uint32_t>(header.properties.domain));
+
+		const NoiseProperties& props = header.properties;
+		writer.I64(props.seed);
+		writer.I32(props.res);
+		writer.F32(props.roughness);
+		writer.I32(props.low_freq_skip);
+		writer.I32(props.high_freq_skip);
+		writer.F32(props.marbling);
+		writer.F32(props.turbulence);
+		writer.I32(props.turbulence_res);
+		writer.F32(props.turbulence_roughness);
+		writer.I32(props.turbulence_low_freq_skip);
+		writer.I32(props.turbulence_high_freq_skip);
+		writer.F32(props.turbulence_marbling);
+		writer.F32(props.turbulence_expshift);
+		writer.F32(props.turbulence_offset_x);
+		writer.F32(props.turbulence_offset_y);
+	}
+
+	bool ReadHeader(const uint8_t* data, size_t size, HeightmapHeader& header)
+	{
+		if(size < DataOffset || memcmp(data, Magic, sizeof(Magic)) != 0)
+			return false;
+
+		HeaderReader reader(data + sizeof(Magic));
+		const uint32_t version = reader.U32();
+		const uint32_t width = reader.U32();
+		const uint32_t height = reader.U32();
+		const uint32_t format = reader.U32();
+		const uint32_t dataOffset = reader.U32();
+		const uint32_t flags = reader.U32();
+		const uint32_t domain = reader.U32();
+
+		if(version != Version || dataOffset != DataOffset || !IsValidFormat(format))
+			return false;
+		if(domain > static_cast<uint32_t>(NoiseDomain::Unbounded))
+			return false;
+		if(width == 0 || height == 0 || width > INT32_MAX || height > INT32_MAX)
+			return false;
+
+		header.width = static_cast<int>(width);
+		header.height = static_cast<int>(height);
+		header.format = static_cast<HeightmapFormat>(format);
+		header.bHasProperties = (flags & FlagHasProperties) != 0;
+
+		NoiseProperties& props = header.properties;
+		props.domain = static_cast<NoiseDomain>(domain);
+		props.seed = static_cast<long>(reader.I64());
+		props.res = reader.I32();
+		props.roughness = reader.F32();
+		props.low_freq_skip = reader.I32();
+		props.high_freq_skip = reader.I32();
+		props.marbling = reader.F32();
+		props.turbulence = reader.F32();
+		props.turbulence_res = reader.I32();
+		props.turbulence_roughness = reader.F32();
+		props.turbulence_low_freq_skip = reader.I32();
+		props.turbulence_high_freq_skip = reader.I32();
+		props.turbulence_marbling = reader.F32();
+		props.turbulence_expshift = reader.F32();
+		props.turbulence_offset_x = reader.F32();
+		props.turbulence_offset_y = reader.F32();
+
+		return size >= DataOffset + (size_t)width * height * BytesPerPixel(header.format);
+	}
+
+	uint16_t EncodeUInt16(float value)
+	{
+		return static_cast<uint16_t>(std::clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+}
+
+bool HeightmapWriter::Create(const std::string& filename, int width, int height, HeightmapFormat format, const NoiseProperties* props)
+{
+	Close();
+
+	if(width <= 0 || height <= 0 || !IsValidFormat(static_cast<uint32_t>(format)))
+	{
+		NGLOG(LogHeightmap, Error, "Invalid heightmap parameters for " + filename);
+		return false;
+	}
+
+	header = HeightmapHeader{};
+	header.width = width;
+	header.height = height;
+	header.format = format;
+	header.bHasProperties = props != nullptr;
+	if(props) header.properties = *props;
+
+	const size_t size = DataOffset + (size_t)width * height * BytesPerPixel(format);
+	if(!file.Open(filename, MappedFile::Mode::CreateWrite, size))
+		return false;
+
+	WriteHeader(file.GetData(), header);
+	return true;
+}
+
+bool HeightmapWriter::WriteRows(int y0, int rows, const float* data)
+{
+	if(!file.IsOpen() || !data || y0 < 0 || rows < 0 || y0 + rows > header.height)
+		return false;
+
+	const size_t first = (size_t)y0 * header.width;
+	const size_t count = (size_t)rows * header.width;
+	uint8_t* pixels = file.GetData() + DataOffset;
+
+	switch(header.format)
+	{
+	case HeightmapFormat::Float32:
+		memcpy(pixels + first * sizeof(float), data, count * sizeof(float));
+		break;
+	case HeightmapFormat::Float16:
+	{
+		uint16_t* out = reinterpret_cast<uint16_t*>(pixels) + first;
+		for(size_t i = 0; i < count; i++) out[i] = HalfFloat::FromFloat(data[i]);
+		break;
+	}
+	case HeightmapFormat::UInt16:
+	{
+		uint16_t* out = reinterpret_cast<uint16_t*>(pixels) + first;
+		for(size_t i = 0; i < count; i++) out[i] = EncodeUInt16(data[i]);
+		break;
+	}
+	}
+
+	return true;
+}
+
+void HeightmapWriter::Close()
+{
+	file.Close();
+}
+
+bool HeightmapFile::Save(const std::string& filename, const float* data, int width, int height,
+	HeightmapFormat format, const NoiseProperties* props)
+{
+	NG_PROFILE_STAGE("Export Heightmap", (int64_t)width * height);
+
+	HeightmapWriter writer;
+	if(!writer.Create(filename, width, height, format, props) || !writer.WriteRows(0, height, data))
+	{
+		NGLOG(LogHeightmap, Error, "Failed to save heightmap: " + filename);
+		return false;
+	}
+
+	writer.Close();
+	NGLOG(LogHeightmap, Info, "Saved heightmap: " + filename);
+	return true;
+}
+
+bool HeightmapFile::Open(const std::string& filename)
+{
+	Close();
+
+	if(!file.Open(filename, MappedFile::Mode::Read))
+		return false;
+
+	if(!ReadHeader(file.GetData(), file.GetSize(), header))
+	{
+		NGLOG(LogHeightmap, Error, "Not a valid heightmap file: " + filename);
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void HeightmapFile::Close()
+{
+	file.Close();
+	header = HeightmapHeader{};
+}
+
+const void* HeightmapFile::GetPixels() const
+{
+	return file.IsOpen() ? file.GetData() + DataOffset : nullptr;
+}
+
+const float* HeightmapFile::GetFloatPixels() const
+{
+	return header.format == HeightmapFormat::Float32 ? static_cast<const float*>(GetPixels()) : nullptr;
+}
+
+float HeightmapFile::GetValue(int x, int y) const
+{
+	float value = 0.0f;
+	if(x < 0 || y < 0 || x >= header.width || y >= header.height || !file.IsOpen())
+		return value;
+
+	const size_t index = (size_t)y * header.width + x;
+	switch(header.format)
+	{
+	case HeightmapFormat::Float32: value = static_cast<const float*>(GetPixels())[index]; break;
+	case HeightmapFormat::Float16: value = HalfFloat::ToFloat(static_cast<const uint16_t*>(GetPixels())[index]); break;
+	case HeightmapFormat::UInt16:  value = static_cast<const uint16_t*>(GetPixels())[index] / 65535.0f; break;
+	}
+	return value;
+}
+
+void HeightmapFile::ReadRows(int y0, int rows, float* out) const
+{
+	if(!file.IsOpen() || y0 < 0 || rows <= 0 || y0 + rows > header.height)
+		return;
+
+	const size_t first = (size_t)y0 * header.width;
+	const size_t count = (size_t)rows * header.width;
+
+	switch(header.format)
+	{
+	case HeightmapFormat::Float32:
+		memcpy(out, static_cast<const float*>(GetPixels()) + first, count * sizeof(float));
+		break;
+	case HeightmapFormat::Float16:
+	{
+		const uint16_t* in = static_cast<const uint16_t*>(GetPixels()) + first;
+		for(size_t i = 0; i < count; i++) out[i] = HalfFloat::ToFloat(in[i]);
+		break;
+	}
+	case HeightmapFormat::UInt16:
+	{
+		const uint16_t* in = static_cast<const uint16_t*>(GetPixels()) + first;
+		for(size_t i = 0; i < count; i++) out[i] = in[i] / 65535.0f;
+		break;
+	}
+	}
+}
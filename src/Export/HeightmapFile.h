@@ -0,0 +1,90 @@
+#pragma once
+
+#include "Export/MappedFile.h"
+#include "Noise/NoiseTypes.h"
+#include <cstdint>
+#include <string>
+
+/** Pixel encoding of a raw heightmap file */
+enum class HeightmapFormat : uint32_t
+{
+	/** Unmodified generator output */
+	Float32 = 0,
+	/** IEEE half precision, half the size with ~3 significant digits */
+	Float16 = 1,
+	/** [0, 1] scaled to 0 .. 65535, the common terrain tool format */
+	UInt16 = 2
+};
+
+/** Decoded header of a raw heightmap file */
+struct HeightmapHeader
+{
+	int width = 0;
+	int height = 0;
+	HeightmapFormat format = HeightmapFormat::Float32;
+
+	/** Whether properties holds the settings the map was generated with */
+	bool bHasProperties = false;
+	NoiseProperties properties{};
+};
+
+/**
+ * Raw heightmap file (.ngh): a 128 byte header followed by width * height pixels, row-major.
+ *
+ * Header fields are serialized one by one as little-endian values (see HeightmapFile.cpp), so
+ * the layout does not depend on struct padding or on NoiseProperties changing. Pixels are
+ * stored little-endian, which is the native order of every platform the generator targets.
+ * Files are written and read through a memory mapping: pixels are encoded straight into the
+ * file and a Float32 file can be used in place without loading it.
+ */
+class HeightmapWriter
+{
+public:
+	/** Creates filename sized for the whole map and writes its header */
+	bool Create(const std::string& filename, int width, int height, HeightmapFormat format, const NoiseProperties* props = nullptr);
+
+	/** Encodes rows [y0, y0 + rows) of width floats into the file */
+	bool WriteRows(int y0, int rows, const float* data);
+
+	/** Unmaps the file; pixels that were not written stay zero */
+	void Close();
+
+	bool IsOpen() const { return file.IsOpen(); }
+
+private:
+	MappedFile file;
+	HeightmapHeader header;
+};
+
+class HeightmapFile
+{
+public:
+	static constexpr const char* Extension = ".ngh";
+
+	/** Writes a complete width x height map in one call */
+	static bool Save(const std::string& filename, const float* data, int width, int height,
+		HeightmapFormat format, const NoiseProperties* props = nullptr);
+
+	/** Maps filename read-only and validates its header */
+	bool Open(const std::string& filename);
+	void Close();
+
+	bool IsOpen() const { return file.IsOpen(); }
+	const HeightmapHeader& GetHeader() const { return header; }
+
+	/** Pixels in the stored format, directly inside the mapping */
+	const void* GetPixels() const;
+
+	/** Direct view of a Float32 file, nullptr for other formats */
+	const float* GetFloatPixels() const;
+
+	/** Decodes one pixel of any format to float */
+	float GetValue(int x, int y) const;
+
+	/** Decodes rows [y0, y0 + rows) to floats */
+	void ReadRows(int y0, int rows, float* out) const;
+
+private:
+	MappedFile file;
+	HeightmapHeader header;
+};
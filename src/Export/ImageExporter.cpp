@@ -9,11 +9,14 @@
 #include <ThirdParty/stb_image_write.h>
 
 #include "Logger/LoggerMacro.h"
+#include "Profiling/Profiler.h"
 
 DEFINE_LOG_CATEGORY(LogExport);
 
 bool ImageExporter::SavePNG(const std::string& filename, unsigned int textureId, int width, int height) 
 {
+	NG_PROFILE_STAGE("Export PNG", (int64_t)width * height);
+
 	std::vector<unsigned char> rgb;
 	if(!ReadTextureAsRGB(textureId, width, height, rgb))
 	{
@@ -33,6 +36,8 @@ bool ImageExporter::SavePNG(const std::string& filename, unsigned int textureId,
 
 bool ImageExporter::SaveTGA(const std::string& filename, unsigned int textureId, int width, int height) 
 {
+	NG_PROFILE_STAGE("Export TGA", (int64_t)width * height);
+
 	std::vector<unsigned char> rgb;
 	if(!ReadTextureAsRGB(textureId, width, height, rgb))
 	{
@@ -52,6 +57,8 @@ bool ImageExporter::SaveTGA(const std::string& filename, unsigned int textureId,
 
 bool ImageExporter::SaveBMP(const std::string& filename, unsigned int textureId, int width, int height)
 {
+	NG_PROFILE_STAGE("Export BMP", (int64_t)width * height);
+
 	std::vector<unsigned char> rgb;
 	if(!ReadTextureAsRGB(textureId, width, height, rgb))
 	{
@@ -71,6 +78,8 @@ bool ImageExporter::SaveBMP(const std::string& filename, unsigned int textureId,
 
 bool ImageExporter::SaveJPG(const std::string& filename, unsigned int textureId, int width, int height, int quality)
 {
+	NG_PROFILE_STAGE("Export JPG", (int64_t)width * height);
+
 	std::vector<unsigned char> rgb;
 	if(!ReadTextureAsRGB(textureId, width, height, rgb))
 	{
@@ -0,0 +1,183 @@
+#include "MappedFile.h"
+#include "Logger/LoggerMacro.h"
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+DEFINE_LOG_CATEGORY(LogMappedFile);
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if(this != &other)
+	{
+		Close();
+		std::swap(data, other.data);
+		std::swap(size, other.size);
+#if defined(_WIN32)
+		std::swap(fileHandle, other.fileHandle);
+		std::swap(mappingHandle, other.mappingHandle);
+#else
+		std::swap(fileDescriptor, other.fileDescriptor);
+#endif
+	}
+	return *this;
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::Open(const std::string& path, Mode mode, size_t requestedSize)
+{
+	Close();
+
+	const bool bWrite = mode == Mode::CreateWrite;
+	HANDLE file = CreateFileA(path.c_str(),
+		bWrite ? (GENERIC_READ | GENERIC_WRITE) : GENERIC_READ,
+		bWrite ? 0 : FILE_SHARE_READ, nullptr,
+		bWrite ? CREATE_ALWAYS : OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(file == INVALID_HANDLE_VALUE)
+	{
+		NGLOG(LogMappedFile, Error, "Failed to open " + path);
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if(bWrite)
+	{
+		fileSize.QuadPart = static_cast<LONGLONG>(requestedSize);
+	}
+	else if(!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		NGLOG(LogMappedFile, Error, "Failed to query size of " + path);
+		return false;
+	}
+
+	if(fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		NGLOG(LogMappedFile, Error, "Cannot map empty file " + path);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, bWrite ? PAGE_READWRITE : PAGE_READONLY,
+		fileSize.HighPart, fileSize.LowPart, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, bWrite ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if(!view)
+	{
+		if(mapping) CloseHandle(mapping);
+		CloseHandle(file);
+		NGLOG(LogMappedFile, Error, "Failed to map " + path);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<uint8_t*>(view);
+	size = static_cast<size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data) UnmapViewOfFile(data);
+	if(mappingHandle) CloseHandle(mappingHandle);
+	if(fileHandle) CloseHandle(fileHandle);
+
+	data = nullptr;
+	size = 0;
+	mappingHandle = nullptr;
+	fileHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path, Mode mode, size_t requestedSize)
+{
+	Close();
+
+	const bool bWrite = mode == Mode::CreateWrite;
+	const int file = bWrite ? open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644) : open(path.c_str(), O_RDONLY);
+	if(file < 0)
+	{
+		NGLOG(LogMappedFile, Error, "Failed to open " + path);
+		return false;
+	}
+
+	size_t fileSize = requestedSize;
+	if(bWrite)
+	{
+		if(ftruncate(file, static_cast<off_t>(requestedSize)) != 0)
+		{
+			close(file);
+			NGLOG(LogMappedFile, Error, "Failed to resize " + path);
+			return false;
+		}
+	}
+	else
+	{
+		struct stat info;
+		if(fstat(file, &info) != 0)
+		{
+			close(file);
+			NGLOG(LogMappedFile, Error, "Failed to query size of " + path);
+			return false;
+		}
+		fileSize = static_cast<size_t>(info.st_size);
+	}
+
+	if(fileSize == 0)
+	{
+		close(file);
+		NGLOG(LogMappedFile, Error, "Cannot map empty file " + path);
+		return false;
+	}
+
+	void* view = mmap(nullptr, fileSize, bWrite ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, file, 0);
+	if(view == MAP_FAILED)
+	{
+		close(file);
+		NGLOG(LogMappedFile, Error, "Failed to map " + path);
+		return false;
+	}
+
+	fileDescriptor = file;
+	data = static_cast<uint8_t*>(view);
+	size = fileSize;
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if(data) munmap(data, size);
+	if(fileDescriptor >= 0) close(fileDescriptor);
+
+	data = nullptr;
+	size = 0;
+	fileDescriptor = -1;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Memory-mapped file view (mmap on POSIX, CreateFileMapping on Windows).
+ * Lets exporters encode straight into the file and readers use file contents in place.
+ */
+class MappedFile
+{
+public:
+	enum class Mode
+	{
+		/** Maps an existing file read-only */
+		Read,
+		/** Creates (or truncates) a file of the requested size and maps it writable */
+		CreateWrite
+	};
+
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/** Maps path, size is only used by CreateWrite. Returns false (and logs) on failure */
+	bool Open(const std::string& path, Mode mode, size_t size = 0);
+
+	/** Unmaps the view, written pages are flushed to the file by the OS */
+	void Close();
+
+	bool IsOpen() const { return data != nullptr; }
+	uint8_t* GetData() { return data; }
+	const uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	uint8_t* data = nullptr;
+	size_t size = 0;
+
+#if defined(_WIN32)
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+#else
+	int fileDescriptor = -1;
+#endif
+};
@@ -2,6 +2,8 @@
 #include "GuiManager.h"
 #include "Logger/LoggerUI.h"
 #include "Logger/LoggerMacro.h"
+#include "Profiling/ProfilerUI.h"
+#include "Profiling/TraceRecorder.h"
 
 #include "GUI/GuiUtils.h"
 #include "Utils/StringUtils.h"
@@ -13,8 +15,11 @@
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include "Noise/NoiseTypes.h"
+#include "Noise/NoiseCache.h"
 #include "Noise/NoiseGenerator.h"
 #include "Export/ImageExporter.h"
+#include <algorithm>
+#include <memory>
 #include <random>
 #include <type_traits>
 #include <nfd.h>
@@ -67,9 +72,23 @@ void GuiManager::Initialize(GLFWwindow* window)
 		}
 	);
 
+	// Roughness and frequency skip edits recombine kept octaves instead of evaluating them again
+	const std::string octaveLayers = SettingsManager::Get().GetOctaveLayers();
+	if(octaveLayers == "float32" || octaveLayers == "float16")
+	{
+		const uint64_t layerBytes = (uint64_t)std::max(0, SettingsManager::Get().GetOctaveLayersMegabytes()) << 20;
+		pipeline.SetLayerCache(std::make_shared<NG::OctaveLayerCache>(layerBytes, octaveLayers == "float16"
+			? NG::OctaveLayerCache::Precision::Float16 : NG::OctaveLayerCache::Precision::Float32));
+	}
+	else if(octaveLayers != "off")
+	{
+		NGLOG(LogGUI, Warning, "Unknown [engine] octave_layers value '" + octaveLayers + "', expected off, float32 or float16");
+	}
+
 	int res = 8 << resolutionIndex;
+	seed = static_cast<int>(std::random_device{}() & 0x7fffffff);
 	NoiseProperties props = {};
-	props.seed = std::random_device{}();
+	props.seed = seed;
 	props.res = resolutionIndex;
 	props.roughness = roughness;
 	props.marbling = marbling;
@@ -87,14 +106,21 @@ void GuiManager::Initialize(GLFWwindow* window)
 	props.turbulence_offset_y = turbulence_offset_y;
 
 
-	float* noise = NG::FBMNoise2D(res, &props, [this] (float progress)
+	NoiseExecution exec;
+	exec.threadCount = 0;
+
+	auto noise = NoiseCache::Get().FindOrGenerate(NoiseCache::MakeKey(NoiseAlgorithm::FBM, res, props), [&] ()
 		{
-			this->generationProgress = progress;
-			return !this->cancelRequested;
+			return pipeline.Run(res, props, [this] (float progress)
+				{
+					this->generationProgress = progress;
+					return !this->cancelRequested;
+				}, exec);
 		});
-	if(noise != nullptr)
+	if(noise)
 	{
-		this->SetNoiseData(noise, res, res);
+		this->SetNoiseData(noise->Data(), res, res);
+		this->SetHeightmapData(noise, props);
 	}
 }
 
@@ -160,6 +186,17 @@ void GuiManager::DrawOutputLog()
 	}
 }
 
+void GuiManager::DrawPerformancePanel()
+{
+	if(bShowPerformance)
+	{
+		ImGui::Begin("Performance", nullptr, ImGuiWindowFlags_NoTitleBar);
+		SHOW_HIDDEN_TAB_BAR(ImGui::GetWindowDockID());
+		DrawProfilerWindow();
+		ImGui::End();
+	}
+}
+
 void GuiManager::SetAllLock(bool state)
 {
 	lockRoughness = state;
@@ -314,6 +351,19 @@ void GuiManager::DrawResolutionComboWithLock()
 
 void GuiManager::QueueUITask(std::function<void()> task)
 {
+	NG_TRACE_SCOPE("QueueUITask");
+	if(Profiler::bEnabled && TraceRecorder::Get().IsRecording())
+	{
+		// Draw an arrow from the queuing thread to the frame that runs the task
+		const uint64_t flowId = TraceRecorder::Get().BeginFlow("UITask");
+		task = [flowId, inner = std::move(task)] ()
+			{
+				NG_TRACE_SCOPE("UITask");
+				TraceRecorder::Get().EndFlow("UITask", flowId);
+				inner();
+			};
+	}
+
 	std::lock_guard<std::mutex> lock(uiMutex);
 	uiTasks.push(std::move(task));
 }
@@ -347,13 +397,28 @@ void GuiManager::Render()
 	ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
 
-void GuiManager::SetNoiseData(float* data, int width, int height)
+void GuiManager::SetNoiseData(const float* data, int width, int height)
 {
 	noisePreview.UpdateTexture(data, width, height);
 }
 
+void GuiManager::SetHeightmapData(std::shared_ptr<const NoiseImage> image, const NoiseProperties& props)
+{
+	if(!image || !*image)
+	{
+		menuBar.SetHeightmapData(nullptr, 0, 0, props);
+		return;
+	}
+
+	// Aliases the image, its buffer goes back to the pool with the last reference
+	std::shared_ptr<const float> heightmap(image, image->Data());
+	menuBar.SetHeightmapData(heightmap, image->GetWidth(), image->GetHeight(), props);
+}
+
 void GuiManager::DrawUI()
 {
+	NG_TRACE_THREAD_NAME("UI");
+
 	ImGuiViewport* viewport = ImGui::GetMainViewport();
 	ImGuiID dockspace_id = ImGui::GetID("MainDockSpace");
 	if(!bDockBuilt)
@@ -371,10 +436,12 @@ void GuiManager::DrawUI()
 		ImGuiID dock_bottom = ImGui::DockBuilderSplitNode(dock_main_id, ImGuiDir_Down, 0.3f, nullptr, &dock_main_id);
 		ImGuiID dock_left = ImGui::DockBuilderSplitNode(dock_main_id, ImGuiDir_Left, 0.5f, nullptr, &dock_main_id);
 		ImGuiID dock_right = dock_main_id;
+		ImGuiID dock_bottom_right = ImGui::DockBuilderSplitNode(dock_bottom, ImGuiDir_Right, 0.4f, nullptr, &dock_bottom);
 
 		ImGui::DockBuilderDockWindow("Noise Generator", dock_left);
 		ImGui::DockBuilderDockWindow("Noise Preview", dock_right);
 		ImGui::DockBuilderDockWindow("Output Log", dock_bottom);
+		ImGui::DockBuilderDockWindow("Performance", dock_bottom_right);
 
 		ImGui::DockBuilderFinish(dockspace_id);
 		bDockBuilt = true;
@@ -405,8 +472,9 @@ void GuiManager::DrawUI()
 		NGLOG(LogGUI, Warning, "Generated 2D noise preview");
 
 		int res = 8 << resolutionIndex;
+		// The Seed field (rerolled by Randomize) keeps identical settings identical, so they hit the NoiseCache
 		NoiseProperties props = {};
-		props.seed = std::random_device{}();
+		props.seed = seed;
 		props.res = resolutionIndex;
 		props.roughness = roughness;
 		props.marbling = marbling;
@@ -428,18 +496,36 @@ void GuiManager::DrawUI()
 		cancelRequested = false;
 		generationThread = std::thread([this, res, props] ()
 			{
-				float* noise = NG::FBMNoise2D(res, &props, [this] (float progress)
-					{
-						this->generationProgress = progress;
-						return !this->cancelRequested;
-					});
+				NG_TRACE_THREAD_NAME("Generation");
+				NG_TRACE_SCOPE("GenerationThread");
+
+				NoiseExecution exec;
+				exec.threadCount = 0;
+
+				std::shared_ptr<const NoiseImage> noise;
+				try
+				{
+					noise = NoiseCache::Get().FindOrGenerate(NoiseCache::MakeKey(NoiseAlgorithm::FBM, res, props), [&] ()
+						{
+							return this->pipeline.Run(res, props, [this] (float progress)
+								{
+									this->generationProgress = progress;
+									return !this->cancelRequested;
+								}, exec);
+						});
+				}
+				catch(const std::exception& e)
+				{
+					// Refused by the memory budget or out of memory, the UI is reset below
+					NGLOG(LogGUI, Error, std::string("Generation failed: ") + e.what());
+				}
 
-				if(noise != nullptr)
+				if(noise && *noise)
 				{
-					this->QueueUITask([this, noise, res] ()
+					this->QueueUITask([this, noise, res, props] ()
 						{
-							this->SetNoiseData(noise, res, res);
-							free(noise);
+							this->SetNoiseData(noise->Data(), res, res);
+							this->SetHeightmapData(noise, props);
 							this->generationProgress = -1.0f;
 							this->isGenerating = false;
 						});
@@ -449,6 +535,7 @@ void GuiManager::DrawUI()
 					this->QueueUITask([this] ()
 						{
 							this->SetNoiseData(nullptr, 0, 0);
+							this->SetHeightmapData(nullptr, {});
 							this->generationProgress = -1.0f;
 							this->isGenerating = false;
 						});
@@ -472,6 +559,7 @@ void GuiManager::DrawUI()
 	if(ImGui::Button(WITH_ICON("Trash", "Clear"), ImVec2(120, 30)))
 	{
 		this->SetNoiseData(nullptr, 0, 0);
+		this->SetHeightmapData(nullptr, {});
 		NGLOG(LogGUI, Warning, "Preview cleared");
 	}
 	ImGui::EndDisabled();
@@ -604,6 +692,7 @@ void GuiManager::DrawUI()
 
 	// Log window
 	DrawOutputLog();
+	DrawPerformancePanel();
 
 
 	std::lock_guard<std::mutex> lock(uiMutex);
@@ -5,12 +5,16 @@
 #include <thread>
 #include <atomic>
 #include <functional>
+#include <memory>
 #include <queue>
 #include <mutex>
 
 
 #include "MVC/View/NoisePreviewPanelUI.h"
 #include "MVC/View/MenuBarUI.h"
+#include "Noise/NoiseImage.h"
+#include "Noise/NoisePipeline.h"
+#include "Noise/NoiseTypes.h"
 
 #include <GLFW/glfw3.h>
 
@@ -23,7 +27,10 @@ public:
 	void BeginFrame();
 	void Render();
 	void DrawUI();
-	void SetNoiseData(float* data, int width, int height);
+	void SetNoiseData(const float* data, int width, int height);
+
+	/** Keeps the generator result alive for raw heightmap export, nullptr clears it */
+	void SetHeightmapData(std::shared_ptr<const NoiseImage> image, const NoiseProperties& props);
 
 
 
@@ -35,6 +42,7 @@ private:
 
 	void DrawMenuBar();
 	void DrawOutputLog();
+	void DrawPerformancePanel();
 
 
 	void SetAllLock(bool state);
@@ -47,12 +55,16 @@ private:
 	bool bFullscreen = false;
 	bool bDockBuilt = false;
 	bool bShowOutputLog = true;
+	bool bShowPerformance = true;
 	MenuBarUI menuBar;
 	NoisePreviewPanelUI noisePreview;
 
 	std::thread generationThread;
 	std::atomic<bool> isGenerating = false;
 
+	/** Keeps the stages of the last generation, so an edit only reruns what it affects; one generation at a time */
+	NG::NoisePipeline pipeline;
+
 	std::atomic<bool> cancelRequested = false;
 	std::atomic<float> generationProgress = -1.0f;
 
@@ -85,6 +97,7 @@ private:
 	{
 		"8", "16", "32", "64", "128", "256", "512", "1024", "2048", "4096"
 	};
+	static_assert(sizeof(resolutions) / sizeof(resolutions[0]) == NoiseResolutionCount, "Resolution labels must match NoiseResolutions");
 
 	//Random properties
 	int randomStyle = 0;
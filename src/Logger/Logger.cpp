@@ -1,11 +1,21 @@
 #include "Logger.h"
-
-#ifdef _DEBUG
 #include <iostream>
-#endif
+#include <mutex>
+#include <stdexcept>
 
 std::vector<LogEntry> Logger::messages;
 std::string Logger::filePath = "log.txt";
+bool Logger::bEchoToConsole = false;
+
+namespace
+{
+	/** Noise jobs log from worker threads */
+	std::recursive_mutex& GetMessagesMutex()
+	{
+		static std::recursive_mutex mutex;
+		return mutex;
+	}
+}
 
 std::string CenterText(const std::string& text, size_t width)
 {
@@ -63,29 +73,37 @@ void Logger::Log(const std::string& category, LogVerbosity verbosity, const std:
 		<< "[" << GetTimestamp() << "] " << message;
 
 	std::string finalMessage = oss.str();
+	std::lock_guard<std::recursive_mutex> lock(GetMessagesMutex());
 
 #ifdef _DEBUG
-	const char* colorReset = "\033[0m";
-	const char* color = "";
-
-	switch(verbosity)
+	const bool bEcho = true;
+#else
+	const bool bEcho = bEchoToConsole;
+#endif
+	if(bEcho)
 	{
-	case LogVerbosity::Info:    color = "\033[37m"; break;
-	case LogVerbosity::Warning: color = "\033[33m"; break;
-	case LogVerbosity::Error:   color = "\033[31m"; break;
+		const char* colorReset = "\033[0m";
+		const char* color = "";
+
+		switch(verbosity)
+		{
+		case LogVerbosity::Info:    color = "\033[37m"; break;
+		case LogVerbosity::Warning: color = "\033[33m"; break;
+		case LogVerbosity::Error:   color = "\033[31m"; break;
+		}
+
+		if(verbosity == LogVerbosity::Info)
+			std::cout << color << finalMessage << colorReset << std::endl;
+		else
+			std::cerr << color << finalMessage << colorReset << std::endl;
 	}
 
-	if(verbosity == LogVerbosity::Info)
-		std::cout << color << finalMessage << colorReset << std::endl;
-	else
-		std::cerr << color << finalMessage << colorReset << std::endl;
-#endif
-
-	messages.emplace_back(LogEntry{ verbosity, category, oss.str() });
+	messages.emplace_back(LogEntry{ verbosity, category, std::move(finalMessage) });
 }
 
 void Logger::SaveLogToFile()
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMessagesMutex());
 	std::ofstream file(filePath, std::ios::trunc);
 	if(!file.is_open())
 	{
@@ -101,16 +119,19 @@ void Logger::SaveLogToFile()
 
 void Logger::Clear()
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMessagesMutex());
 	messages.clear();
 }
 
-const std::vector<LogEntry>& Logger::GetMessages()
+std::vector<LogEntry> Logger::GetMessages()
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMessagesMutex());
 	return messages;
 }
 
 std::vector<LogEntry> Logger::GetMessagesByVerbosity(LogVerbosity verbosity)
 {
+	std::lock_guard<std::recursive_mutex> lock(GetMessagesMutex());
 	std::vector<LogEntry> result;
 	for(const auto& entry : messages)
 	{
@@ -31,6 +31,9 @@ struct LogEntry
 
 /**
  * Logger is a static utility class that provides categorized and leveled logging.
+ *
+ * It has no UI dependency (LoggerUI.h draws the collected messages), so it is part of the
+ * headless NoiseCore library. Log may be called from any thread.
  */
 class Logger
 {
@@ -38,11 +41,15 @@ public:
 	static void Log(const std::string& category, LogVerbosity verbosity, const std::string& message);
 	static void SaveLogToFile();
 	static void Clear();
-	static const std::vector<LogEntry>& GetMessages();
+	/** Copy of the log taken under its lock, other threads may append while it is used */
+	static std::vector<LogEntry> GetMessages();
 	static std::vector<LogEntry> GetMessagesByVerbosity(LogVerbosity verbosity);
 
 	static std::string filePath;
 
+	/** Also print messages to stdout/stderr outside of Debug builds, for headless tools */
+	static bool bEchoToConsole;
+
 private:
 	static std::vector<LogEntry> messages;
 	static std::string GetTimestamp();
@@ -22,10 +22,13 @@ inline void DrawLoggerWindow(bool* open = nullptr)
 	static std::string currentCategory = "All";
 	static std::vector<std::string> knownCategories;
 
+	// One snapshot per frame, generation threads keep logging while the window is drawn
+	const std::vector<LogEntry> logs = Logger::GetMessages();
+
 	// Rebuild category list (can be cached/optimized later)
 	knownCategories.clear();
 	knownCategories.push_back("All");
-	for(const auto& entry : Logger::GetMessages())
+	for(const auto& entry : logs)
 	{
 		if(std::find(knownCategories.begin(), knownCategories.end(), entry.category) == knownCategories.end())
 		{
@@ -43,7 +46,7 @@ inline void DrawLoggerWindow(bool* open = nullptr)
 	// === Category filter with checkboxes inside combo ===
 	static std::unordered_map<std::string, bool> categoryFilterStates;
 
-	for(const auto& entry : Logger::GetMessages()) 
+	for(const auto& entry : logs) 
 	{
 		if(categoryFilterStates.find(entry.category) == categoryFilterStates.end()) 
 		{
@@ -90,8 +93,6 @@ inline void DrawLoggerWindow(bool* open = nullptr)
 	std::string searchFilter = searchBuffer;
 
 	// === Log entries ===
-	const auto& logs = Logger::GetMessages();
-
 	ImGui::BeginChild("LogScrollRegion", ImVec2(0, -40), true, ImGuiWindowFlags_HorizontalScrollbar);
 	for(const auto& entry : logs)
 	{
@@ -56,6 +56,24 @@ void MenuBarController::ExportAs(const std::string& format, GLuint textureId, in
 	}
 }
 
+void MenuBarController::ExportHeightmap(HeightmapFormat format, const float* data, int width, int height, const NoiseProperties* props)
+{
+	if(!data || width <= 0 || height <= 0)
+	{
+		NGLOG(ExportLog, Error, std::string("Invalid heightmap export parameters.  ") + __FUNCTION__);
+		return;
+	}
+
+	nfdchar_t* outPath = nullptr;
+	if(NFD_SaveDialog("ngh", nullptr, &outPath) == NFD_OKAY)
+	{
+		std::string pathStr = NG::EnsureExtension(outPath, HeightmapFile::Extension);
+		HeightmapFile::Save(pathStr, data, width, height, format, props);
+
+		free(outPath);
+	}
+}
+
 bool MenuBarController::IsFullscreen() const
 {
 	if(!Model)
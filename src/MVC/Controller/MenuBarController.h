@@ -5,6 +5,7 @@
 #include "MVC/Controller/NoisePanelController.h"
 #include "GLFW/glfw3.h"
 #include "Export/ImageExporter.h"
+#include "Export/HeightmapFile.h"
 #include "Utils/StringUtils.h"
 #include "Config/SettingsManager.h"
 #include <memory>
@@ -45,6 +46,9 @@ public:
 
 	void ExportAs(const std::string& format, GLuint textureId, int width, int height);
 
+	/** Saves the float generator output as a raw .ngh heightmap, written through a file mapping */
+	void ExportHeightmap(HeightmapFormat format, const float* data, int width, int height, const NoiseProperties* props);
+
 	bool IsFullscreen() const;
 
 
@@ -1,5 +1,7 @@
 #include "NoisePanelModel.h"
 #include "Logger/LoggerMacro.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
 
 DEFINE_LOG_CATEGORY(NoisePanelLog);
 
@@ -32,13 +34,15 @@ void NoisePanelModel::UploadData(const float* data, int width, int height)
 		return;
 	}
 
+	NG_PROFILE_STAGE("UploadTexture", (int64_t)width * height);
+
 	this->width = width;
 	this->height = height;
 	int tpixels = width * height;
-	// Using raw `new` here instead of std::vector for maximum performance,
+	// Using a raw tracked allocation here instead of std::vector for maximum performance,
 	// avoiding zero-initialization and extra safety overhead.
 	// Manual memory management is safe in this scope due to predictable allocation size.
-	float* rgb_data = new float[tpixels * 3];
+	float* rgb_data = (float*)MemoryTracker::Get().Allocate(sizeof(float) * tpixels * 3);
 	if(!rgb_data)
 	{
 		NGLOG(NoisePanelLog, Error, "Failed to allocate memory for rgbData");
@@ -67,7 +71,7 @@ void NoisePanelModel::UploadData(const float* data, int width, int height)
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
 	// Clean up allocated RGB buffer
-	delete[] rgb_data;
+	MemoryTracker::Get().Free(rgb_data);
 }
 
 GLuint NoisePanelModel::GetTextureId() const
@@ -55,6 +55,14 @@ void MenuBarUI::SetTextureData(GLuint id, int w, int h)
 	TextureHeight = h;
 }
 
+void MenuBarUI::SetHeightmapData(std::shared_ptr<const float> data, int w, int h, const NoiseProperties& props)
+{
+	HeightmapData = std::move(data);
+	HeightmapWidth = HeightmapData ? w : 0;
+	HeightmapHeight = HeightmapData ? h : 0;
+	HeightmapProperties = props;
+}
+
 MenuBarController* MenuBarUI::GetController() const
 {
 	if(!Controller)
@@ -99,6 +107,28 @@ void MenuBarUI::DrawFileItem()
 			}
 			ShowShiftOnlyTooltip(0.6f, { "Export preview image", "Format: JPG", "Lossy, great for photography" });
 
+			ImGui::Separator();
+
+			ImGui::BeginDisabled(!HeightmapData);
+			if(ImGui::MenuItem(WITH_ICON("FileExport", "Export Heightmap (float32)")))
+			{
+				Controller->ExportHeightmap(HeightmapFormat::Float32, HeightmapData.get(), HeightmapWidth, HeightmapHeight, &HeightmapProperties);
+			}
+			ShowShiftOnlyTooltip(0.6f, { "Export raw heightmap", "Format: NGH float32", "Full generator precision" });
+
+			if(ImGui::MenuItem(WITH_ICON("FileExport", "Export Heightmap (float16)")))
+			{
+				Controller->ExportHeightmap(HeightmapFormat::Float16, HeightmapData.get(), HeightmapWidth, HeightmapHeight, &HeightmapProperties);
+			}
+			ShowShiftOnlyTooltip(0.6f, { "Export raw heightmap", "Format: NGH float16", "Half size, half precision" });
+
+			if(ImGui::MenuItem(WITH_ICON("FileExport", "Export Heightmap (uint16)")))
+			{
+				Controller->ExportHeightmap(HeightmapFormat::UInt16, HeightmapData.get(), HeightmapWidth, HeightmapHeight, &HeightmapProperties);
+			}
+			ShowShiftOnlyTooltip(0.6f, { "Export raw heightmap", "Format: NGH uint16", "65536 height levels" });
+			ImGui::EndDisabled();
+
 			ImGui::EndMenu();
 		}
 
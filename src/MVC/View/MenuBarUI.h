@@ -5,6 +5,7 @@
 #include <GLFW/glfw3.h>
 #include <string>
 #include <vector>
+#include "Noise/NoiseTypes.h"
 
 class MenuBarController;
 
@@ -14,6 +15,7 @@ public:
 	void Initialize();
 	void Draw();
 	void SetTextureData(GLuint id, int w, int h);
+	void SetHeightmapData(std::shared_ptr<const float> data, int w, int h, const NoiseProperties& props);
 	MenuBarController* GetController() const;
 private:
 	void DrawFileItem();
@@ -28,5 +30,11 @@ private:
 	GLuint TextureId = 0;
 	int TextureWidth = 0;
 	int TextureHeight = 0;
+
+	/** Generator output behind the preview, exported as raw heightmap without precision loss */
+	std::shared_ptr<const float> HeightmapData;
+	int HeightmapWidth = 0;
+	int HeightmapHeight = 0;
+	NoiseProperties HeightmapProperties{};
 };
 
@@ -122,7 +122,7 @@ void NoisePreviewPanelUI::Draw()
 		ImGui::Spacing();
 		ImGui::TextWrapped(" - F11: Toggle fullscreen mode.");
 		ImGui::TextWrapped(" - Alt+F4: Exit application.");
-		ImGui::TextWrapped(" - Export menu: Save previews in PNG/TGA/BMP/JPG formats.");
+		ImGui::TextWrapped(" - Export menu: Save previews in PNG/TGA/BMP/JPG formats, or raw float/16-bit heightmaps (.ngh).");
 		ImGui::TextWrapped(" - Lock buttons: Prevent randomization of specific parameters.");
 		ImGui::EndGroup();
 	}
@@ -0,0 +1,305 @@
+#include "BufferPool.h"
+#include "MemoryTracker.h"
+#include "Logger/Logger.h"
+#include "Logger/LoggerMacro.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+DEFINE_LOG_CATEGORY(LogBufferPool);
+
+namespace
+{
+	void* AlignedAlloc(size_t bytes)
+	{
+#if defined(_WIN32)
+		return _aligned_malloc(bytes, BufferPool::Alignment);
+#else
+		// Size classes are multiples of the alignment, as aligned_alloc requires
+		return std::aligned_alloc(BufferPool::Alignment, bytes);
+#endif
+	}
+
+	void AlignedFree(void* ptr)
+	{
+#if defined(_WIN32)
+		_aligned_free(ptr);
+#else
+		std::free(ptr);
+#endif
+	}
+}
+
+BufferPool& BufferPool::Get()
+{
+	static BufferPool instance;
+	return instance;
+}
+
+BufferPool::~BufferPool()
+{
+	TrimTo(0);
+}
+
+size_t BufferPool::GetBucketBytes(size_t bytes)
+{
+	if(bytes <= MinBucketBytes)
+		return MinBucketBytes;
+
+	// power < bytes <= 2 * power, rounded up to a quarter of power
+	size_t power = MinBucketBytes;
+	while(power * 2 < bytes)
+		power *= 2;
+
+	const size_t step = power / 4;
+	return (bytes + step - 1) / step * step;
+}
+
+bool BufferPool::ParseHugePageMode(const std::string& text, HugePageMode& outMode)
+{
+	if(text == "off") outMode = HugePageMode::Off;
+	else if(text == "advise") outMode = HugePageMode::Advise;
+	else if(text == "explicit") outMode = HugePageMode::Explicit;
+	else return false;
+	return true;
+}
+
+const char* BufferPool::GetHugePageModeName(HugePageMode mode)
+{
+	switch(mode)
+	{
+	case HugePageMode::Advise:		return "advise";
+	case HugePageMode::Explicit:	return "explicit";
+	default:						return "off";
+	}
+}
+
+void* BufferPool::Acquire(size_t bytes, bool bZeroed)
+{
+	const size_t bucket = GetBucketBytes(bytes);
+	Block block;
+	HugePageMode mode;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		mode = hugePageMode;
+		auto idle = idleBlocks.find(bucket);
+		if(idle != idleBlocks.end() && !idle->second.empty())
+		{
+			block = idle->second.back();
+			idle->second.pop_back();
+			pooledBytes -= bucket;
+			++hits;
+		}
+		else
+		{
+			++misses;
+		}
+	}
+
+	const bool bReused = block.ptr != nullptr;
+	if(bReused)
+	{
+		NG_PROFILE_COUNTER("BufferPool hits", 1);
+	}
+	else
+	{
+		block = Allocate(bucket, mode);
+		if(!block.ptr && MemoryTracker::Get().Reclaim(bucket) > 0)
+		{
+			// Reclaimed blocks may have gone to the idle lists, the new one needs them freed
+			Trim();
+			block = Allocate(bucket, mode);
+		}
+		if(!block.ptr)
+			return nullptr;
+
+		NG_PROFILE_COUNTER("BufferPool misses", 1);
+		NG_PROFILE_ALLOC(bucket);
+	}
+
+	bool bWarnHugeTlb = false;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!bReused && block.backing != Backing::Heap)
+			hugePageBytes += bucket;
+
+		if(!bReused && block.mode == HugePageMode::Explicit && block.backing == Backing::Advised && !bHugeTlbWarned)
+			bWarnHugeTlb = bHugeTlbWarned = true;
+
+		usedBlocks[block.ptr] = block;
+	}
+	MemoryTracker::Get().Track(block.ptr, bucket);
+
+	if(bWarnHugeTlb)
+		NGLOG(LogBufferPool, Warning, "No free hugetlbfs pages (vm.nr_hugepages), large buffers use transparent huge pages instead");
+
+	// Fresh hugetlbfs mappings are zero filled by the kernel
+	if(bZeroed && (bReused || block.backing != Backing::HugeTlb))
+		memset(block.ptr, 0, bytes);
+	return block.ptr;
+}
+
+void BufferPool::Release(void* ptr)
+{
+	if(!ptr)
+		return;
+
+	MemoryTracker::Get().Untrack(ptr);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto used = usedBlocks.find(ptr);
+	if(used == usedBlocks.end())
+		return;
+
+	const Block block = used->second;
+	usedBlocks.erase(used);
+
+	// Blocks of an earlier huge page mode are not reused
+	if(block.mode != hugePageMode || pooledBytes + block.bytes > capacity)
+	{
+		Free(block);
+		return;
+	}
+
+	idleBlocks[block.bytes].push_back(block);
+	pooledBytes += block.bytes;
+}
+
+void BufferPool::SetCapacity(uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	capacity = bytes;
+	TrimTo(capacity);
+}
+
+uint64_t BufferPool::GetCapacity() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return capacity;
+}
+
+void BufferPool::Trim()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	TrimTo(0);
+}
+
+uint64_t BufferPool::GetPooledBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return pooledBytes;
+}
+
+void BufferPool::SetHugePageMode(HugePageMode mode)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	if(mode == hugePageMode)
+		return;
+
+	hugePageMode = mode;
+	TrimTo(0);
+	NGLOG(LogBufferPool, Info, std::string("Huge pages: ") + GetHugePageModeName(mode));
+}
+
+HugePageMode BufferPool::GetHugePageMode() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hugePageMode;
+}
+
+uint64_t BufferPool::GetHugePageBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hugePageBytes;
+}
+
+uint64_t BufferPool::GetHitCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+uint64_t BufferPool::GetMissCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return misses;
+}
+
+BufferPool::Block BufferPool::Allocate(size_t bucket, HugePageMode mode)
+{
+	Block block;
+	block.bytes = bucket;
+	block.mode = mode;
+
+#if defined(__linux__)
+	if(mode != HugePageMode::Off && bucket >= HugePageMinBytes)
+	{
+		if(mode == HugePageMode::Explicit)
+		{
+			void* mapped = mmap(nullptr, bucket, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if(mapped != MAP_FAILED)
+			{
+				block.ptr = mapped;
+				block.backing = Backing::HugeTlb;
+				return block;
+			}
+		}
+
+		// Aligned to a huge page, so the kernel can back the whole block with them
+		void* aligned = nullptr;
+		if(posix_memalign(&aligned, HugePageBytes, bucket) == 0)
+		{
+			madvise(aligned, bucket, MADV_HUGEPAGE);
+			block.ptr = aligned;
+			block.backing = Backing::Advised;
+		}
+		return block;
+	}
+#endif
+
+	block.ptr = AlignedAlloc(bucket);
+	return block;
+}
+
+void BufferPool::Free(const Block& block)
+{
+	if(block.backing != Backing::Heap)
+		hugePageBytes -= block.bytes;
+
+#if defined(__linux__)
+	if(block.backing == Backing::HugeTlb)
+	{
+		munmap(block.ptr, block.bytes);
+		return;
+	}
+#endif
+
+	AlignedFree(block.ptr);
+}
+
+void BufferPool::TrimTo(uint64_t bytes)
+{
+	// Largest classes first, they give back the most memory per block
+	std::vector<size_t> buckets;
+	for(const auto& idle : idleBlocks)
+		buckets.push_back(idle.first);
+	std::sort(buckets.rbegin(), buckets.rend());
+
+	for(size_t bucket : buckets)
+	{
+		std::vector<Block>& blocks = idleBlocks[bucket];
+		while(pooledBytes > bytes && !blocks.empty())
+		{
+			Free(blocks.back());
+			blocks.pop_back();
+			pooledBytes -= bucket;
+		}
+	}
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Page size behind the large blocks of the BufferPool */
+enum class HugePageMode
+{
+	/** Regular 4 KB pages */
+	Off,
+
+	/** Transparent huge pages, requested with madvise(MADV_HUGEPAGE) */
+	Advise,
+
+	/** Pages reserved in hugetlbfs (MAP_HUGETLB); falls back to Advise when none are free */
+	Explicit
+};
+
+/**
+ * Recycles the large image buffers of the noise engine.
+ *
+ * Requests are rounded up to a size class (four per power of two, at most 25% slack) and released
+ * blocks are kept per class, so regenerating at the same resolution takes back memory that is
+ * already allocated and faulted in instead of going to the heap. Blocks are 64-byte aligned and
+ * charged to the current MemoryTracker job while they are in use; idle blocks are not.
+ *
+ * Blocks of HugePageMinBytes and more can be backed by 2 MB pages (Linux only, other platforms
+ * always use regular pages). The warp passes sample their source at scattered positions, with
+ * 4 KB pages nearly every read of a 4096^2 image misses the TLB.
+ */
+class BufferPool
+{
+public:
+	static constexpr size_t Alignment = 64;
+	static constexpr size_t MinBucketBytes = 4096;
+	static constexpr uint64_t DefaultCapacity = 512ull << 20;
+
+	/** Huge page size, and the smallest block using them; size classes from there on are multiples of 2 MB */
+	static constexpr size_t HugePageBytes = 2u << 20;
+	static constexpr size_t HugePageMinBytes = 8u << 20;
+
+	static BufferPool& Get();
+
+	/** Size class a request of bytes is served from */
+	static size_t GetBucketBytes(size_t bytes);
+
+	/** "off", "advise" or "explicit"; returns false for anything else */
+	static bool ParseHugePageMode(const std::string& text, HugePageMode& outMode);
+	static const char* GetHugePageModeName(HugePageMode mode);
+
+	/** Aligned block of at least bytes (zero filled with bZeroed), nullptr when out of memory */
+	void* Acquire(size_t bytes, bool bZeroed = false);
+
+	/** Returns a block from Acquire to the pool, or frees it when the pool is full */
+	void Release(void* ptr);
+
+	/** Limits the idle bytes kept for reuse; lowering it frees blocks right away */
+	void SetCapacity(uint64_t bytes);
+	uint64_t GetCapacity() const;
+
+	/** Backing of blocks allocated from now on; idle blocks of the old mode are freed. Default Off */
+	void SetHugePageMode(HugePageMode mode);
+	HugePageMode GetHugePageMode() const;
+
+	/** Frees every idle block */
+	void Trim();
+
+	/** Bytes of the idle blocks */
+	uint64_t GetPooledBytes() const;
+
+	/** Bytes of the blocks (used and idle) allocated with huge pages requested */
+	uint64_t GetHugePageBytes() const;
+
+	/** Acquire calls served by an idle block / by a new allocation */
+	uint64_t GetHitCount() const;
+	uint64_t GetMissCount() const;
+
+private:
+	/** How a block was allocated, decides how it is freed */
+	enum class Backing
+	{
+		Heap,
+		Advised,
+		HugeTlb
+	};
+
+	struct Block
+	{
+		void* ptr = nullptr;
+		size_t bytes = 0;
+		Backing backing = Backing::Heap;
+		HugePageMode mode = HugePageMode::Off;
+	};
+
+	BufferPool() = default;
+	~BufferPool();
+
+	BufferPool(const BufferPool&) = delete;
+	BufferPool& operator=(const BufferPool&) = delete;
+
+	/** New block of a size class in the given mode, ptr is nullptr when out of memory */
+	Block Allocate(size_t bucket, HugePageMode mode);
+	void Free(const Block& block);
+
+	/** Frees idle blocks until at most bytes are left; mutex must be held */
+	void TrimTo(uint64_t bytes);
+
+	mutable std::mutex mutex;
+
+	/** Idle blocks per size class */
+	std::unordered_map<size_t, std::vector<Block>> idleBlocks;
+
+	/** Every block handed out */
+	std::unordered_map<void*, Block> usedBlocks;
+
+	uint64_t capacity = DefaultCapacity;
+	HugePageMode hugePageMode = HugePageMode::Off;
+	uint64_t pooledBytes = 0;
+	uint64_t hugePageBytes = 0;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	bool bHugeTlbWarned = false;
+};
@@ -0,0 +1,273 @@
+#include "MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+	/** Job the calling thread works for */
+	thread_local MemoryJob* currentJob = nullptr;
+
+	std::string ToMegabytes(uint64_t bytes)
+	{
+		return std::to_string((bytes + (1 << 20) - 1) >> 20) + " MB";
+	}
+}
+
+MemoryTracker& MemoryTracker::Get()
+{
+	static MemoryTracker instance;
+	return instance;
+}
+
+void* MemoryTracker::Allocate(size_t bytes, bool bZeroed)
+{
+	void* ptr = bZeroed ? calloc(1, bytes) : malloc(bytes);
+	if(!ptr && Reclaim(bytes) > 0)
+		ptr = bZeroed ? calloc(1, bytes) : malloc(bytes);
+	if(!ptr)
+		return nullptr;
+
+	Track(ptr, bytes);
+	NG_PROFILE_ALLOC(bytes);
+	return ptr;
+}
+
+void MemoryTracker::Free(void* ptr)
+{
+	if(!ptr)
+		return;
+
+	Untrack(ptr);
+	free(ptr);
+}
+
+void MemoryTracker::Track(void* ptr, size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	// A tracked block released with plain free() can come back from malloc, drop its old entry
+	auto stale = allocations.find(ptr);
+	if(stale != allocations.end())
+	{
+		currentBytes -= stale->second.bytes;
+		if(stale->second.job)
+			stale->second.job->currentBytes -= stale->second.bytes;
+		allocations.erase(stale);
+	}
+	allocations[ptr] = Allocation{ bytes, currentJob };
+
+	currentBytes += bytes;
+	if(currentBytes > peakBytes) peakBytes = currentBytes;
+	if(currentJob)
+	{
+		currentJob->currentBytes += bytes;
+		if(currentJob->currentBytes > currentJob->peakBytes) currentJob->peakBytes = currentJob->currentBytes;
+	}
+}
+
+void MemoryTracker::Untrack(void* ptr)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = allocations.find(ptr);
+	if(found != allocations.end())
+	{
+		currentBytes -= found->second.bytes;
+		if(found->second.job)
+			found->second.job->currentBytes -= found->second.bytes;
+		allocations.erase(found);
+	}
+}
+
+int64_t MemoryTracker::GetCurrentBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return currentBytes;
+}
+
+int64_t MemoryTracker::GetPeakBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return peakBytes;
+}
+
+void MemoryTracker::ResetPeak()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	peakBytes = currentBytes;
+}
+
+uint64_t MemoryTracker::GetReservedBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return reservedBytes;
+}
+
+void MemoryTracker::SetBudget(uint64_t bytes, MemoryBudgetPolicy policy)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		budgetBytes = bytes;
+		budgetPolicy = policy;
+	}
+	// A larger budget may admit queued jobs
+	reservationReleased.notify_all();
+}
+
+uint64_t MemoryTracker::GetBudget() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return budgetBytes;
+}
+
+MemoryBudgetPolicy MemoryTracker::GetBudgetPolicy() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return budgetPolicy;
+}
+
+uint64_t MemoryTracker::AddReclaimer(Reclaimer reclaimer)
+{
+	std::lock_guard<std::mutex> lock(reclaimMutex);
+	reclaimers.emplace_back(++lastReclaimerId, std::move(reclaimer));
+	return lastReclaimerId;
+}
+
+void MemoryTracker::RemoveReclaimer(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(reclaimMutex);
+	reclaimers.erase(std::remove_if(reclaimers.begin(), reclaimers.end(),
+		[id] (const std::pair<uint64_t, Reclaimer>& entry) { return entry.first == id; }), reclaimers.end());
+}
+
+uint64_t MemoryTracker::Reclaim(uint64_t bytes)
+{
+	std::lock_guard<std::mutex> lock(reclaimMutex);
+
+	uint64_t released = 0;
+	for(auto& entry : reclaimers)
+	{
+		if(released >= bytes)
+			break;
+		released += entry.second(bytes - released);
+	}
+
+	if(released > 0)
+		NG_PROFILE_COUNTER("MemoryTracker reclaimed bytes", (int64_t)released);
+	return released;
+}
+
+std::vector<MemoryJobReport> MemoryTracker::GetRecentJobs() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return std::vector<MemoryJobReport>(recentJobs.begin(), recentJobs.end());
+}
+
+MemoryJob* MemoryTracker::GetCurrentJob()
+{
+	return currentJob;
+}
+
+void MemoryTracker::BeginJob(MemoryJob& job)
+{
+	// Cached memory goes first when the job would push the tracked bytes over the budget
+	uint64_t excess = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const uint64_t needed = (uint64_t)std::max<int64_t>(currentBytes, 0) + job.reservedBytes;
+		if(budgetBytes != 0 && needed > budgetBytes)
+			excess = needed - budgetBytes;
+	}
+	if(excess > 0)
+		Reclaim(excess);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	auto fits = [&] { return budgetBytes == 0 || reservedBytes + job.reservedBytes <= budgetBytes; };
+
+	if(!fits())
+	{
+		if(job.reservedBytes > budgetBytes)
+		{
+			throw MemoryBudgetError("Job '" + job.name + "' needs about " + ToMegabytes(job.reservedBytes)
+				+ ", more than the memory budget of " + ToMegabytes(budgetBytes));
+		}
+
+		if(budgetPolicy == MemoryBudgetPolicy::Refuse)
+		{
+			throw MemoryBudgetError("Job '" + job.name + "' needs about " + ToMegabytes(job.reservedBytes) + " but only "
+				+ ToMegabytes(budgetBytes - reservedBytes) + " of the memory budget are free");
+		}
+
+		reservationReleased.wait(lock, [&] { return fits() || job.reservedBytes > budgetBytes; });
+		if(!fits())
+		{
+			throw MemoryBudgetError("Job '" + job.name + "' needs about " + ToMegabytes(job.reservedBytes)
+				+ ", more than the memory budget of " + ToMegabytes(budgetBytes));
+		}
+	}
+
+	reservedBytes += job.reservedBytes;
+}
+
+void MemoryTracker::EndJob(MemoryJob& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		reservedBytes -= job.reservedBytes;
+
+		// Whatever the job still holds was returned to the caller: it stays tracked until released
+		for(auto& allocation : allocations)
+		{
+			if(allocation.second.job == &job)
+				allocation.second.job = nullptr;
+		}
+
+		recentJobs.push_back(MemoryJobReport{ job.name, job.reservedBytes, job.peakBytes });
+		if(recentJobs.size() > RecentJobCount)
+			recentJobs.pop_front();
+	}
+	reservationReleased.notify_all();
+}
+
+MemoryJobScope::MemoryJobScope(const std::string& name, uint64_t estimatedBytes)
+{
+	if(currentJob)
+	{
+		job = currentJob;
+		return;
+	}
+
+	ownedJob = std::make_unique<MemoryJob>();
+	ownedJob->name = name;
+	ownedJob->reservedBytes = estimatedBytes;
+	MemoryTracker::Get().BeginJob(*ownedJob);
+
+	job = ownedJob.get();
+	currentJob = job;
+}
+
+MemoryJobScope::~MemoryJobScope()
+{
+	if(ownedJob)
+	{
+		currentJob = nullptr;
+		MemoryTracker::Get().EndJob(*ownedJob);
+	}
+}
+
+int64_t MemoryJobScope::GetPeakBytes() const
+{
+	std::lock_guard<std::mutex> lock(MemoryTracker::Get().mutex);
+	return job->peakBytes;
+}
+
+MemoryJobBinding::MemoryJobBinding(MemoryJob* job)
+	: previous(currentJob)
+{
+	currentJob = job;
+}
+
+MemoryJobBinding::~MemoryJobBinding()
+{
+	currentJob = previous;
+}
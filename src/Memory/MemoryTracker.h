@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Accounting of the memory used by the noise engine.
+ *
+ * Engine buffers come from MemoryTracker::Allocate or a TrackedVector and are charged to the job
+ * running on the calling thread. A job is opened with MemoryJobScope: generators open one
+ * themselves, callers that run several generators as one unit (batch jobs) open it around them.
+ * A job reserves its estimated peak when it starts; with a memory budget set, a job that does not
+ * fit is refused with MemoryBudgetError or waits until running jobs release enough memory.
+ *
+ * Buffers a generator returns (NoiseImage) leave the job with the caller when the outermost job
+ * ends and stay counted in GetCurrentBytes until they are released.
+ *
+ * Caches that can drop what they hold register a reclaimer. Before a job starts, memory is
+ * reclaimed until the tracked bytes plus the job's reservation fit into the budget, and a failed
+ * allocation reclaims its size and tries once more.
+ */
+
+/** What happens to a job whose reservation does not fit into the budget */
+enum class MemoryBudgetPolicy
+{
+	/** Throw MemoryBudgetError */
+	Refuse,
+
+	/** Block until enough running jobs finished; jobs larger than the whole budget are still refused */
+	Queue
+};
+
+/** Thrown when a job is refused by the memory budget */
+class MemoryBudgetError : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+/** Memory of one job, shared by every thread that works on it; guarded by the tracker */
+struct MemoryJob
+{
+	std::string name;
+	uint64_t reservedBytes = 0;
+	int64_t currentBytes = 0;
+	int64_t peakBytes = 0;
+};
+
+/** Summary of a finished job */
+struct MemoryJobReport
+{
+	std::string name;
+	uint64_t reservedBytes = 0;
+	int64_t peakBytes = 0;
+};
+
+class MemoryTracker
+{
+public:
+	static constexpr size_t RecentJobCount = 16;
+
+	static MemoryTracker& Get();
+
+	/** malloc (or calloc with bZeroed) charged to the current job, nullptr when out of memory */
+	void* Allocate(size_t bytes, bool bZeroed = false);
+
+	/** Frees memory from Allocate; pointers the tracker does not know are passed to free() */
+	void Free(void* ptr);
+
+	/** Charges a block obtained elsewhere (BufferPool) to the current job, until Untrack */
+	void Track(void* ptr, size_t bytes);
+	void Untrack(void* ptr);
+
+	/** Bytes currently allocated through the tracker, and the highest value since ResetPeak */
+	int64_t GetCurrentBytes() const;
+	int64_t GetPeakBytes() const;
+	void ResetPeak();
+
+	/** Sum of the reservations of the running jobs */
+	uint64_t GetReservedBytes() const;
+
+	/** Limits the sum of the job reservations; 0 disables the budget */
+	void SetBudget(uint64_t bytes, MemoryBudgetPolicy policy = MemoryBudgetPolicy::Refuse);
+	uint64_t GetBudget() const;
+	MemoryBudgetPolicy GetBudgetPolicy() const;
+
+	/**
+	 * Frees cached memory on request: receives the bytes wanted and returns the bytes it released.
+	 * Called without tracker locks held; it must not allocate through the tracker and should skip
+	 * (return 0) instead of blocking on a lock its own owner may hold while allocating.
+	 */
+	using Reclaimer = std::function<uint64_t(uint64_t bytes)>;
+
+	/** Registers reclaimer and returns its id for RemoveReclaimer */
+	uint64_t AddReclaimer(Reclaimer reclaimer);
+
+	/** Unregisters a reclaimer, waiting for a Reclaim that is calling it */
+	void RemoveReclaimer(uint64_t id);
+
+	/** Asks the reclaimers in registration order until bytes are released; returns the bytes released */
+	uint64_t Reclaim(uint64_t bytes);
+
+	/** The last RecentJobCount finished jobs, oldest first */
+	std::vector<MemoryJobReport> GetRecentJobs() const;
+
+	/** Job the calling thread works for, nullptr outside of jobs */
+	static MemoryJob* GetCurrentJob();
+
+private:
+	friend class MemoryJobScope;
+
+	struct Allocation
+	{
+		size_t bytes = 0;
+		MemoryJob* job = nullptr;
+	};
+
+	MemoryTracker() = default;
+
+	/** Reserves the job's estimate, blocks or throws according to the budget */
+	void BeginJob(MemoryJob& job);
+
+	/** Releases the reservation and detaches the job's remaining allocations from it */
+	void EndJob(MemoryJob& job);
+
+	mutable std::mutex mutex;
+	std::condition_variable reservationReleased;
+	std::unordered_map<void*, Allocation> allocations;
+
+	int64_t currentBytes = 0;
+	int64_t peakBytes = 0;
+	uint64_t reservedBytes = 0;
+	uint64_t budgetBytes = 0;
+	MemoryBudgetPolicy budgetPolicy = MemoryBudgetPolicy::Refuse;
+	std::deque<MemoryJobReport> recentJobs;
+
+	/** Separate from mutex, reclaimers free tracked memory while they run */
+	std::mutex reclaimMutex;
+	std::vector<std::pair<uint64_t, Reclaimer>> reclaimers;
+	uint64_t lastReclaimerId = 0;
+};
+
+/**
+ * Runs the enclosing scope as a job of the memory tracker. A scope opened on a thread that already
+ * works for a job joins that job and reserves nothing.
+ */
+class MemoryJobScope
+{
+public:
+	/** Throws MemoryBudgetError when the budget refuses estimatedBytes */
+	MemoryJobScope(const std::string& name, uint64_t estimatedBytes);
+	~MemoryJobScope();
+
+	MemoryJobScope(const MemoryJobScope&) = delete;
+	MemoryJobScope& operator=(const MemoryJobScope&) = delete;
+
+	/** Peak bytes of the job so far, including the jobs this scope joined */
+	int64_t GetPeakBytes() const;
+
+private:
+	std::unique_ptr<MemoryJob> ownedJob;
+	MemoryJob* job = nullptr;
+};
+
+/** Makes the calling thread work for job until the scope ends, used by worker threads */
+class MemoryJobBinding
+{
+public:
+	explicit MemoryJobBinding(MemoryJob* job);
+	~MemoryJobBinding();
+
+	MemoryJobBinding(const MemoryJobBinding&) = delete;
+	MemoryJobBinding& operator=(const MemoryJobBinding&) = delete;
+
+private:
+	MemoryJob* previous;
+};
+
+/** std::allocator replacement that routes container storage through the memory tracker */
+template<typename T>
+struct TrackingAllocator
+{
+	using value_type = T;
+
+	TrackingAllocator() = default;
+	template<typename U> TrackingAllocator(const TrackingAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		if(count > std::numeric_limits<size_t>::max() / sizeof(T))
+			throw std::bad_array_new_length();
+
+		void* ptr = MemoryTracker::Get().Allocate(count * sizeof(T));
+		if(!ptr)
+			throw std::bad_alloc();
+		return static_cast<T*>(ptr);
+	}
+
+	void deallocate(T* ptr, size_t)
+	{
+		MemoryTracker::Get().Free(ptr);
+	}
+
+	template<typename U> bool operator==(const TrackingAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const TrackingAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using TrackedVector = std::vector<T, TrackingAllocator<T>>;
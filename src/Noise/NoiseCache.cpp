@@ -0,0 +1,377 @@
+#include "NoiseCache.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+DEFINE_LOG_CATEGORY(LogNoiseCache);
+
+namespace
+{
+	/**
+	 * Disk entry layout, header fields little-endian, pixels in native byte order:
+	 *   0  char[4]  magic "NGCE"
+	 *   4  u32      key byte count n
+	 *   8  u8[n]    key bytes, compared on load so a hash collision is a miss
+	 *      i32      width, height, depth
+	 *      f32[]    width * height * depth pixels
+	 */
+	constexpr char Magic[4] = { 'N', 'G', 'C', 'E' };
+
+	/** Appends little-endian values, the same encoding on every platform */
+	class KeyWriter
+	{
+	public:
+		void U32(uint32_t value)
+		{
+			for(int i = 0; i < 4; i++) bytes.push_back(static_cast<char>(value >> (8 * i)));
+		}
+
+		void I32(int32_t value) { U32(static_cast<uint32_t>(value)); }
+
+		void I64(int64_t value)
+		{
+			U32(static_cast<uint32_t>(static_cast<uint64_t>(value)));
+			U32(static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+		}
+
+		/** By bit pattern, with -0 folded into 0 as the generators cannot tell them apart */
+		void F32(float value)
+		{
+			uint32_t bits = 0;
+			if(value != 0.0f)
+				memcpy(&bits, &value, sizeof(bits));
+			U32(bits);
+		}
+
+		std::string bytes;
+	};
+
+	uint32_t ReadU32(const char* data)
+	{
+		uint32_t value = 0;
+		for(int i = 0; i < 4; i++) value |= static_cast<uint32_t>(static_cast<unsigned char>(data[i])) << (8 * i);
+		return value;
+	}
+
+	uint64_t HashBytes(const std::string& bytes)
+	{
+		// FNV-1a, stable across platforms and runs unlike std::hash
+		uint64_t hash = 14695981039346656037ull;
+		for(char c : bytes)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
+
+std::string NoiseCacheKey::ToHex() const
+{
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+	return text;
+}
+
+NoiseCache& NoiseCache::Get()
+{
+	static NoiseCache instance;
+	return instance;
+}
+
+NoiseCacheKey NoiseCache::MakeKey(NoiseAlgorithm algorithm, int res, const NoiseProperties& props, NG::WorleyFeature feature)
+{
+	KeyWriter key;
+	key.U32(KeyVersion);
+	key.U32(static_cast<uint32_t>(algorithm));
+	key.I32(res);
+	key.I64(props.seed);
+
+	if(algorithm == NoiseAlgorithm::Worley)
+	{
+		key.U32(static_cast<uint32_t>(feature));
+	}
+	else
+	{
+		key.F32(props.roughness);
+		key.U32(static_cast<uint32_t>(props.domain));
+	}
+	key.I32(props.low_freq_skip);
+	key.I32(props.high_freq_skip);
+	key.F32(props.marbling);
+
+	key.F32(props.turbulence);
+	if(props.turbulence != 0.0f)
+	{
+		key.I32(props.turbulence_res);
+		key.F32(props.turbulence_roughness);
+		key.I32(props.turbulence_low_freq_skip);
+		key.I32(props.turbulence_high_freq_skip);
+		key.F32(props.turbulence_marbling);
+		key.F32(props.turbulence_expshift);
+		key.F32(props.turbulence_offset_x);
+		key.F32(props.turbulence_offset_y);
+	}
+
+	NoiseCacheKey result;
+	result.hash = HashBytes(key.bytes);
+	result.bytes = std::move(key.bytes);
+	return result;
+}
+
+NoiseCache::NoiseCache(uint64_t inCapacity)
+	: capacity(inCapacity)
+{
+	reclaimerId = MemoryTracker::Get().AddReclaimer([this] (uint64_t wanted) { return Reclaim(wanted); });
+}
+
+NoiseCache::~NoiseCache()
+{
+	MemoryTracker::Get().RemoveReclaimer(reclaimerId);
+}
+
+std::shared_ptr<const NoiseImage> NoiseCache::Find(const NoiseCacheKey& key)
+{
+	std::string folder;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = index.find(key.bytes);
+		if(found != index.end())
+		{
+			entries.splice(entries.begin(), entries, found->second);
+			++hits;
+			NG_PROFILE_COUNTER("NoiseCache hits", 1);
+			return found->second->image;
+		}
+		folder = directory;
+	}
+
+	std::shared_ptr<const NoiseImage> image;
+	if(!folder.empty())
+		image = Load((std::filesystem::path(folder) / (key.ToHex() + Extension)).string(), key);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	if(image)
+	{
+		++diskHits;
+		NG_PROFILE_COUNTER("NoiseCache disk hits", 1);
+		Store(key, image);
+	}
+	else
+	{
+		++misses;
+		NG_PROFILE_COUNTER("NoiseCache misses", 1);
+	}
+	return image;
+}
+
+std::shared_ptr<const NoiseImage> NoiseCache::Insert(const NoiseCacheKey& key, NoiseImage image)
+{
+	if(!image)
+		return nullptr;
+
+	auto shared = std::make_shared<const NoiseImage>(std::move(image));
+	const std::string folder = GetDirectory();
+	if(!folder.empty())
+	{
+		std::error_code ec;
+		std::filesystem::create_directories(folder, ec);
+		const std::string path = (std::filesystem::path(folder) / (key.ToHex() + Extension)).string();
+		if(!Save(path, key, *shared))
+			NGLOG(LogNoiseCache, Warning, "Cannot write cache entry " + path);
+	}
+
+	std::lock_guard<std::mutex> lock(mutex);
+	Store(key, shared);
+	return shared;
+}
+
+std::shared_ptr<const NoiseImage> NoiseCache::FindOrGenerate(const NoiseCacheKey& key, const std::function<NoiseImage()>& generate)
+{
+	if(auto image = Find(key))
+		return image;
+	return Insert(key, generate());
+}
+
+void NoiseCache::SetCapacity(uint64_t inBytes)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	capacity = inBytes;
+	TrimTo(capacity);
+}
+
+uint64_t NoiseCache::GetCapacity() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return capacity;
+}
+
+void NoiseCache::SetDirectory(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	directory = path;
+}
+
+std::string NoiseCache::GetDirectory() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return directory;
+}
+
+void NoiseCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	TrimTo(0);
+}
+
+uint64_t NoiseCache::Reclaim(uint64_t wanted)
+{
+	// Called by the MemoryTracker from any thread, a Find or Insert holding the lock is not waited for
+	std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+	if(!lock.owns_lock())
+		return 0;
+
+	const uint64_t before = bytes;
+	TrimTo(bytes > wanted ? bytes - wanted : 0);
+	if(before != bytes)
+		NGLOG(LogNoiseCache, Info, "Evicted " + std::to_string(before - bytes) + " bytes of cached maps under memory pressure");
+	return before - bytes;
+}
+
+uint64_t NoiseCache::GetBytes() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return bytes;
+}
+
+size_t NoiseCache::GetEntryCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return entries.size();
+}
+
+uint64_t NoiseCache::GetHitCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+uint64_t NoiseCache::GetDiskHitCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return diskHits;
+}
+
+uint64_t NoiseCache::GetMissCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return misses;
+}
+
+void NoiseCache::ResetCounters()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	hits = diskHits = misses = 0;
+}
+
+void NoiseCache::Store(const NoiseCacheKey& key, const std::shared_ptr<const NoiseImage>& image)
+{
+	auto found = index.find(key.bytes);
+	if(found != index.end())
+	{
+		bytes -= found->second->image->GetBytes();
+		entries.erase(found->second);
+		index.erase(found);
+	}
+
+	if(image->GetBytes() > capacity)
+		return;
+
+	entries.push_front({ key, image });
+	index[key.bytes] = entries.begin();
+	bytes += image->GetBytes();
+	TrimTo(capacity);
+}
+
+void NoiseCache::TrimTo(uint64_t limit)
+{
+	// Images still used by a caller stay alive through their shared_ptr
+	while(bytes > limit && !entries.empty())
+	{
+		const Entry& last = entries.back();
+		bytes -= last.image->GetBytes();
+		index.erase(last.key.bytes);
+		entries.pop_back();
+	}
+}
+
+std::shared_ptr<const NoiseImage> NoiseCache::Load(const std::string& path, const NoiseCacheKey& key) const
+{
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		return nullptr;
+
+	NG_PROFILE_STAGE("NoiseCache Load", 0);
+
+	char header[8];
+	if(!file.read(header, sizeof(header)) || memcmp(header, Magic, sizeof(Magic)) != 0 || ReadU32(header + 4) != key.bytes.size())
+		return nullptr;
+
+	std::string storedKey(key.bytes.size(), '\0');
+	char size[12];
+	if(!file.read(&storedKey[0], (std::streamsize)storedKey.size()) || storedKey != key.bytes || !file.read(size, sizeof(size)))
+		return nullptr;
+
+	const int width = static_cast<int32_t>(ReadU32(size));
+	const int height = static_cast<int32_t>(ReadU32(size + 4));
+	const int depth = static_cast<int32_t>(ReadU32(size + 8));
+	if(width <= 0 || height <= 0 || depth <= 0)
+		return nullptr;
+
+	NoiseImage image(width, height, depth);
+	if(!image || !file.read(reinterpret_cast<char*>(image.Data()), (std::streamsize)image.GetBytes()))
+		return nullptr;
+
+	return std::make_shared<const NoiseImage>(std::move(image));
+}
+
+bool NoiseCache::Save(const std::string& path, const NoiseCacheKey& key, const NoiseImage& image) const
+{
+	NG_PROFILE_STAGE("NoiseCache Save", (int64_t)image.GetCount());
+
+	KeyWriter header;
+	header.bytes.assign(Magic, sizeof(Magic));
+	header.U32(static_cast<uint32_t>(key.bytes.size()));
+	header.bytes += key.bytes;
+	header.I32(image.GetWidth());
+	header.I32(image.GetHeight());
+	header.I32(image.GetDepth());
+
+	// Written next to the entry and renamed, so readers never see a partial file
+	const std::string temporary = path + ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file.write(header.bytes.data(), (std::streamsize)header.bytes.size());
+		file.write(reinterpret_cast<const char*>(image.Data()), (std::streamsize)image.GetBytes());
+		if(!file.good())
+		{
+			file.close();
+			std::remove(temporary.c_str());
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(temporary, path, ec);
+	if(ec)
+	{
+		std::remove(temporary.c_str());
+		return false;
+	}
+	return true;
+}
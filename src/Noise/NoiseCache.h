@@ -0,0 +1,136 @@
+#pragma once
+
+#include "NoiseImage.h"
+#include "NoiseTypes.h"
+#include "WorleyGrid.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * Identity of a generated image: the canonical bytes of every input its values depend on, and
+ * their 64-bit FNV-1a hash. Keys are equal exactly when the images are.
+ */
+struct NoiseCacheKey
+{
+	std::string bytes;
+	uint64_t hash = 0;
+
+	/** hash as 16 lowercase hex digits, the file name of the disk tier */
+	std::string ToHex() const;
+
+	bool operator==(const NoiseCacheKey& other) const { return bytes == other.bytes; }
+	bool operator!=(const NoiseCacheKey& other) const { return bytes != other.bytes; }
+};
+
+/**
+ * Content-addressed cache of generator results, so a repeated request returns the image it
+ * produced before instead of generating it again.
+ *
+ * The memory tier keeps the most recently used images up to a byte budget and hands them out as
+ * shared, read-only images; a hit costs a hash lookup. With a directory set, every inserted image
+ * is also written there (<hash>.ngc, native byte order) and memory misses are looked up on disk,
+ * so results survive between runs and are shared by processes using the same directory. Disk
+ * files are never evicted, delete them to reclaim the space.
+ *
+ * Concurrent requests for the same missing key each generate it; the last insert wins. The memory
+ * tier is a MemoryTracker reclaimer: under a memory budget, jobs that need room evict the least
+ * recently used images.
+ */
+class NoiseCache
+{
+public:
+	static constexpr uint64_t DefaultCapacity = 256ull << 20;
+	static constexpr const char* Extension = ".ngc";
+
+	/** Part of every key, bump it when a generator changes its output so old disk entries miss */
+	static constexpr uint32_t KeyVersion = 1;
+
+	/** Shared cache of the application and the batch runner */
+	static NoiseCache& Get();
+
+	/**
+	 * Key of a res x res image of algorithm. Inputs the generator ignores are left out: the GUI
+	 * resolution index props.res, roughness and domain for Worley, the turbulence settings while
+	 * turbulence is 0, and feature for FBM. Floats are compared by value, so 0 and -0 are equal.
+	 */
+	static NoiseCacheKey MakeKey(NoiseAlgorithm algorithm, int res, const NoiseProperties& props,
+		NG::WorleyFeature feature = NG::WorleyFeature::F1);
+
+	explicit NoiseCache(uint64_t capacity = DefaultCapacity);
+	~NoiseCache();
+
+	NoiseCache(const NoiseCache&) = delete;
+	NoiseCache& operator=(const NoiseCache&) = delete;
+
+	/** Cached image of key from memory or disk, nullptr on a miss */
+	std::shared_ptr<const NoiseImage> Find(const NoiseCacheKey& key);
+
+	/**
+	 * Stores image under key and returns it shared; an empty image is not stored and gives nullptr.
+	 * Images larger than the capacity skip the memory tier but are still written to disk.
+	 */
+	std::shared_ptr<const NoiseImage> Insert(const NoiseCacheKey& key, NoiseImage image);
+
+	/** Find, or Insert the result of generate on a miss */
+	std::shared_ptr<const NoiseImage> FindOrGenerate(const NoiseCacheKey& key, const std::function<NoiseImage()>& generate);
+
+	/** Limits the bytes of the memory tier; 0 disables it. Lowering it evicts right away */
+	void SetCapacity(uint64_t bytes);
+	uint64_t GetCapacity() const;
+
+	/** Folder of the disk tier, created when needed; empty (the default) disables it */
+	void SetDirectory(const std::string& path);
+	std::string GetDirectory() const;
+
+	/** Drops every image of the memory tier, the disk tier is kept */
+	void Clear();
+
+	/** Evicts least recently used images until bytes are freed; returns the bytes freed */
+	uint64_t Reclaim(uint64_t bytes);
+
+	/** Bytes and images held by the memory tier */
+	uint64_t GetBytes() const;
+	size_t GetEntryCount() const;
+
+	/** Find calls served from memory / from disk / by neither */
+	uint64_t GetHitCount() const;
+	uint64_t GetDiskHitCount() const;
+	uint64_t GetMissCount() const;
+	void ResetCounters();
+
+private:
+	struct Entry
+	{
+		NoiseCacheKey key;
+		std::shared_ptr<const NoiseImage> image;
+	};
+
+	/** Adds image to the memory tier, evicting the least recently used ones; mutex must be held */
+	void Store(const NoiseCacheKey& key, const std::shared_ptr<const NoiseImage>& image);
+
+	/** Evicts until at most bytes are held; mutex must be held */
+	void TrimTo(uint64_t bytes);
+
+	std::shared_ptr<const NoiseImage> Load(const std::string& path, const NoiseCacheKey& key) const;
+	bool Save(const std::string& path, const NoiseCacheKey& key, const NoiseImage& image) const;
+
+	mutable std::mutex mutex;
+
+	/** Most recently used first */
+	std::list<Entry> entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+	std::string directory;
+	uint64_t capacity = DefaultCapacity;
+	uint64_t bytes = 0;
+	uint64_t hits = 0;
+	uint64_t diskHits = 0;
+	uint64_t misses = 0;
+
+	uint64_t reclaimerId = 0;
+};
@@ -1,52 +1,146 @@
 #include "NoiseGenerator.h"
 #include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Noise/NoiseRegion.h"
+#include "Noise/NoiseStages.h"
+#include "Noise/OctaveKernel.h"
+#include "Noise/WorleyGrid.h"
 #include "Logger/Logger.h"
 #include "Logger/LoggerMacro.h"
-#include "Utils/RandomGenerator.h"
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include "Utils/HashRandom.h"
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <type_traits>
+#include <vector>
 
 #define PI      3.14159265358979323846264338327950f
-#define PI2     6.28318530717958647692528676655901f
 #define EPSILON 0.00000001000000000000000000000000f
 
 DEFINE_LOG_CATEGORY(LogNoise);
 
 namespace NG
 {
-	float* StupidNoise1D(int res, int freq, float* data2, float scale, unsigned int seed)
+	NoiseImage StupidNoise1D(int res, int freq, NoiseImage data2, float scale, unsigned int seed)
 	{
-		float* data1 = (float*)calloc(sizeof(float), freq);
-		if(!data2) data2 = (float*)calloc(sizeof(float), res);
+		MemoryJobScope memoryJob("StupidNoise1D", sizeof(float) * (uint64_t)freq + BufferPool::GetBucketBytes(sizeof(float) * res));
+
+		float* data1 = (float*)MemoryTracker::Get().Allocate(sizeof(float) * freq, true);
+		if(!data2) data2 = NoiseImage(res, 1, 1, true);
 		if(!data1 || !data2) 
 		{
 			NGLOG(LogNoise, Error, "Out of memory");
 			throw std::runtime_error("Out of memory");
 		}
 
-		RandomGenerator rng(seed);
 		for(int i = 0; i < freq; i++)
-			data1[i] = rng.NextFloat();
+			data1[i] = HashRandom::Float(seed, i);
+
+		auto accumulate = [&] (auto bPowerOfTwo)
+			{
+				for(int x = 0; x < res; x++) 
+				{
+					int x3 = (x * freq) / res - 1;
+					float tmp[4];
+					for(int x2 = 0; x2 < 4; x2++)
+					{
+						tmp[x2] = data1[CalcIndex1D<decltype(bPowerOfTwo)::value>(x2 + x3, freq)];
+					}
+					float xf = (float)(x * freq) / res;
+					xf -= floorf(xf);
+					data2[x] += Interpolate1D(tmp, xf) * scale;
+				}
+			};
+
+		if(IsPowerOfTwo(freq))
+			accumulate(std::true_type{});
+		else
+			accumulate(std::false_type{});
+
+		MemoryTracker::Get().Free(data1);
+		return data2;
+	}
 
-		for(int x = 0; x < res; x++) 
+	namespace
+	{
+		/**
+		 * Peak of a generator whose own pass needs passBytes (image included) and which may
+		 * warp the image with two fields, each needing estimateField bytes while generated.
+		 */
+		template<typename EstimateField>
+		uint64_t EstimateWithTurbulence(int res, const NoiseProperties& props, uint64_t passBytes, EstimateField estimateField)
 		{
-			int x3 = (x * freq) / res - 1;
-			float tmp[4];
-			for(int x2 = 0; x2 < 4; x2++)
+			if(props.turbulence == 0.0f)
+				return passBytes;
+
+			const uint64_t image = BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res);
+			const int turbulenceRes = 8 << props.turbulence_res;
+			const NoiseProperties turbulence = MakeTurbulenceProperties(props);
+			const uint64_t field = BufferPool::GetBucketBytes(sizeof(float) * (size_t)turbulenceRes * turbulenceRes);
+
+			// dy is generated while the image and dx are held, the warp then adds a copy of the image
+			return std::max({ passBytes, image + field + estimateField(turbulenceRes, turbulence), 2 * image + 2 * field });
+		}
+
+		/**
+		 * Adds one octave of 2D lattice noise to data2, splitting the rows across exec.
+		 * Returns false if onProgress canceled the pass; data2 is then partially written.
+		 */
+		bool AccumulateOctave2D(int res, int freq, float* data2, float scale, unsigned int seed,
+			const NoiseExecution& exec, const std::function<bool(float)>& onProgress)
+		{
+			float* data1 = (float*)MemoryTracker::Get().Allocate(sizeof(float) * freq * freq, true);
+			if(!data1)
 			{
-				tmp[x2] = data1[CalcIndex1D(x2 + x3, freq)];
+				NGLOG(LogNoise, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
 			}
-			float xf = (float)(x * freq) / res;
-			xf -= floorf(xf);
-			data2[CalcIndex1D(x, res)] += Interpolate1D(tmp, xf) * scale;
-		}
 
-		free(data1);
-		return data2;
+			// Lattice values are a pure hash of (seed, x, y), rows can be filled on any thread
+			ParallelForRows(freq, exec, [&] (int rowBegin, int rowEnd)
+				{
+					for(int y = rowBegin; y < rowEnd; y++)
+						HashRandom::FillRow(seed, y, freq, data1 + (size_t)y * freq);
+				});
+
+			// Taps and weights only depend on one coordinate, the same table serves both axes
+			BSplineColumns axis;
+			axis.Build(0, res, freq, res);
+			const SimdLevel simd = GetSimdLevel();
+
+			// Separable evaluation: interpolate every lattice row along x once (freq x res) ...
+			TrackedVector<float> interpolated((size_t)freq * res);
+			ParallelForRows(freq, exec, [&] (int begin, int end)
+				{
+					for(int row = begin; row < end; row++)
+						InterpolateBSplineX(simd, data1 + row * freq, axis, 0, res, interpolated.data() + (size_t)row * res);
+				});
+			MemoryTracker::Get().Free(data1);
+
+			// ... then each output row is a weighted sum of four of those rows along y
+			bool bCompleted = ParallelForRows(res, exec, [&] (int begin, int end)
+				{
+					for(int y = begin; y < end; y++) {
+						const float* rows[4];
+						float wy[4];
+						for(int y2 = 0; y2 < 4; y2++) {
+							rows[y2] = interpolated.data() + (size_t)axis.taps[y2 * res + y] * res;
+							wy[y2] = axis.weights[y2 * res + y];
+						}
+
+						AccumulateBSplineY(simd, rows, wy, res, scale, data2 + y * res);
+					}
+				}, onProgress);
+
+			return bCompleted;
+		}
 	}
 
-	float* StupidNoise2D(int res, int freq, float* data2, float scale, unsigned int seed)
+	NoiseImage StupidNoise2D(int res, int freq, NoiseImage data2, float scale, unsigned int seed, const NoiseExecution& exec)
 	{
 		if(res <= 0 || freq <= 0)
 		{
@@ -54,293 +148,261 @@ namespace NG
 			throw std::invalid_argument("Resolution and frequency must be > 0");
 		} 
 
-		if(res <= 0 || freq <= 0)
-		{
-			NGLOG(LogNoise, Error, "Invalid resolution or frequency in StupidNoise2D");
-			throw std::invalid_argument("Resolution and frequency must be > 0");
-		}
+		MemoryJobScope memoryJob("StupidNoise2D", BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res)
+			+ sizeof(float) * ((uint64_t)freq * freq + (uint64_t)freq * res));
 
-		float* data1 = (float*)calloc(sizeof(float), freq * freq);
-		if(!data2) data2 = (float*)calloc(sizeof(float), res * res);
-		if(!data1 || !data2) 
+		if(!data2) data2 = NoiseImage(res, res, 1, true);
+		if(!data2) 
 		{
 			NGLOG(LogNoise, Error, "Out of memory");
 			throw std::runtime_error("Out of memory");
 		}
 
-		RandomGenerator rng(seed);
-		for(int i = 0; i < freq * freq; i++)
-			data1[i] = rng.NextFloat();
-
-		for(int y = 0; y < res; y++) {
-			for(int x = 0; x < res; x++) {
-				int x3 = (x * freq) / res - 1;
-				int y3 = (y * freq) / res - 1;
-				float tmp[16];
-
-				for(int y2 = 0; y2 < 4; y2++)
-					for(int x2 = 0; x2 < 4; x2++)
-						tmp[x2 + y2 * 4] = data1[CalcIndex2D(x2 + x3, y2 + y3, freq)];
-
-				float xf = (float)(x * freq) / res;
-				float yf = (float)(y * freq) / res;
-				xf -= floorf(xf);
-				yf -= floorf(yf);
-
-				data2[CalcIndex2D(x, y, res)] += Interpolate2D(tmp, xf, yf) * scale;
-			}
-		}
-
-		free(data1);
+		AccumulateOctave2D(res, freq, data2.Data(), scale, seed, exec, nullptr);
 		return data2;
 	}
 
-	float* StupidNoise3D(int res, int freq, float* data2, float scale, unsigned int seed)
+	NoiseImage StupidNoise3D(int res, int freq, NoiseImage data2, float scale, unsigned int seed)
 	{
+		const uint64_t r = res, f = freq;
+		MemoryJobScope memoryJob("StupidNoise3D", BufferPool::GetBucketBytes(sizeof(float) * (size_t)(r * r * r))
+			+ sizeof(float) * (f * f * f + f * f * r + f * r * r));
 
-		float* data1 = (float*)calloc(sizeof(float), freq * freq * freq);
-		if(!data2) data2 = (float*)calloc(sizeof(float), res * res * res);
+		float* data1 = (float*)MemoryTracker::Get().Allocate(sizeof(float) * freq * freq * freq, true);
+		if(!data2) data2 = NoiseImage(res, res, res, true);
 		if(!data1 || !data2) 
 		{
 			NGLOG(LogNoise, Error, "Out of memory");
 			throw std::runtime_error("Out of memory");
 		}
 
-		RandomGenerator rng(seed);
-		for(int i = 0; i < freq * freq * freq; i++)
-			data1[i] = rng.NextFloat();
+		for(int z = 0; z < freq; z++)
+			for(int y = 0; y < freq; y++)
+				HashRandom::FillRow(seed, y, z, freq, data1 + ((size_t)z * freq + y) * freq);
+
+		// Separable evaluation along x, then y, then z; the same operation order as Interpolate3D
+		BSplineColumns axis;
+		axis.Build(0, res, freq, res);
+		const SimdLevel simd = GetSimdLevel();
+
+		TrackedVector<float> alongX((size_t)freq * freq * res);
+		for(int row = 0; row < freq * freq; row++)
+			InterpolateBSplineX(simd, data1 + row * freq, axis, 0, res, alongX.data() + (size_t)row * res);
+
+		TrackedVector<float> alongXY((size_t)freq * res * res);
+		for(int z = 0; z < freq; z++)
+			for(int y = 0; y < res; y++) {
+				const float* rows[4];
+				float wy[4];
+				for(int y2 = 0; y2 < 4; y2++) {
+					rows[y2] = alongX.data() + ((size_t)z * freq + axis.taps[y2 * res + y]) * res;
+					wy[y2] = axis.weights[y2 * res + y];
+				}
+				InterpolateBSplineY(simd, rows, wy, res, alongXY.data() + ((size_t)z * res + y) * res);
+			}
 
 		for(int z = 0; z < res; z++)
-			for(int y = 0; y < res; y++)
-				for(int x = 0; x < res; x++) {
-					int x3 = (x * freq) / res - 1;
-					int y3 = (y * freq) / res - 1;
-					int z3 = (z * freq) / res - 1;
-					float tmp[64];
-
-					for(int z2 = 0; z2 < 4; z2++)
-						for(int y2 = 0; y2 < 4; y2++)
-							for(int x2 = 0; x2 < 4; x2++)
-								tmp[x2 + y2 * 4 + z2 * 16] =
-								data1[CalcIndex3D(x2 + x3, y2 + y3, z2 + z3, freq)];
-
-					float xf = (float)(x * freq) / res;
-					float yf = (float)(y * freq) / res;
-					float zf = (float)(z * freq) / res;
-					xf -= floorf(xf);
-					yf -= floorf(yf);
-					zf -= floorf(zf);
-
-					data2[CalcIndex3D(x, y, z, res)] += Interpolate3D(tmp, xf, yf, zf) * scale;
+			for(int y = 0; y < res; y++) {
+				const float* rows[4];
+				float wz[4];
+				for(int z2 = 0; z2 < 4; z2++) {
+					rows[z2] = alongXY.data() + ((size_t)axis.taps[z2 * res + z] * res + y) * res;
+					wz[z2] = axis.weights[z2 * res + z];
 				}
+				AccumulateBSplineY(simd, rows, wz, res, scale, data2.Data() + CalcIndex3D(0, y, z, res));
+			}
 
-		free(data1);
+		MemoryTracker::Get().Free(data1);
 		return data2;
 	}
 
-	float* FBMNoise2D(int res, const NoiseProperties* in_props, std::function<bool(float)> onProgress)
+	NoiseImage FBMNoise2D(int res, const NoiseProperties* in_props, std::function<bool(float)> onProgress, const NoiseExecution& exec)
 	{
-		if(!in_props) return nullptr;
-
-		float* data = nullptr;
-		float scale = 1.0f;
-		int freq = 2;
-		int octaves = 0;
-		while((1 << octaves) < res) octaves++;
-
-		for(int level = 0; level < octaves; level++) {
-			if(level >= in_props->low_freq_skip && level <= octaves - in_props->high_freq_skip) {
-				unsigned int levelSeed = in_props->seed + level * 31;
-				data = StupidNoise2D(res, freq, data, scale, levelSeed);
-			}
+		if(!in_props) return {};
 
-			if(onProgress && !onProgress((float)level / octaves * 0.4f)) {
-				if(data) free(data);
-				return nullptr;
-			}
-
-			freq *= 2;
-			scale *= in_props->roughness;
-		}
+		const int64_t pixels = (int64_t)res * res;
+		NG_PROFILE_STAGE("FBMNoise2D", pixels);
+		NG_PROFILE_COUNTER("FBMNoise2D calls", 1);
+		MemoryJobScope memoryJob("FBMNoise2D", EstimateFBMNoise2DBytes(res, in_props));
 
-		if(!data) {
-			data = (float*)calloc(sizeof(float), res * res);
-			if(!data) 
+		// Unbounded noise is the window [0, res)^2 of the world plane, the region evaluator owns that pipeline
+		if(in_props->domain == NoiseDomain::Unbounded)
+		{
+			NoiseImage data(res, res);
+			if(!data)
 			{
 				NGLOG(LogNoise, Error, "Out of memory");
 				throw std::runtime_error("Out of memory");
 			}
+
+			auto regionProgress = [&] (float fraction)
+				{
+					return onProgress(fraction * 0.9f);
+				};
+
+			if(!GenerateRegion(res, in_props, 0, 0, res, res, data.Data(), res, exec, onProgress ? regionProgress : std::function<bool(float)>()))
+				return {};
+			if(onProgress && !onProgress(1.0f))
+				return {};
 			return data;
 		}
 
-		// === Turbulence Pass ===
-		if(in_props->turbulence != 0.0f) {
-			NoiseProperties prop = *in_props;
-			prop.turbulence = 0.0f;
-			prop.roughness = in_props->turbulence_roughness;
-			prop.low_freq_skip = in_props->turbulence_low_freq_skip;
-			prop.high_freq_skip = in_props->turbulence_high_freq_skip;
-			prop.marbling = in_props->turbulence_marbling;
-
-			int turbulence_res = 8 << in_props->turbulence_res;
-			float turbulence_exp = powf(2.0f, in_props->turbulence_expshift);
-
-			prop.seed = in_props->seed + 100;
-			float* dx = FBMNoise2D(turbulence_res, &prop, [] (float) { return true; });
-			prop.seed = in_props->seed + 200;
-			float* dy = FBMNoise2D(turbulence_res, &prop, [] (float) { return true; });
-
-			if(!dx || !dy) 
+		auto stageProgress = [&] (float begin, float end) -> std::function<bool(float)>
 			{
-				if(data) free(data);
-				if(dx) free(dx);
-				if(dy) free(dy);
-				NGLOG(LogNoise, Error, "Turbulence sub-pass canceled or failed");
-				return nullptr;
-			}
+				if(!onProgress) return nullptr;
+				return [&onProgress, begin, end] (float fraction) { return onProgress(begin + fraction * (end - begin)); };
+			};
 
-			float* temp = new float[res * res];
-			memcpy(temp, data, res * res * sizeof(float));
-
-			for(int j = 0; j < res; j++) 
-			{
-				for(int i = 0; i < res; i++) 
-				{
-					float x = Sample2D(dx, turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
-					float y = Sample2D(dy, turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+		// === Octaves ===
+		NoiseImage data;
+		bool bHasOctaves = false;
+		{
+			NG_PROFILE_STAGE("Octaves", pixels);
+			data = SumOctaves2D(res, *in_props, exec, stageProgress(0.0f, 0.4f), bHasOctaves);
+		}
 
-					if(turbulence_exp != 1.0f) {
-						x = powf(fabsf(x), turbulence_exp) * (x >= 0.0f ? 1.0f : -1.0f);
-						y = powf(fabsf(y), turbulence_exp) * (y >= 0.0f ? 1.0f : -1.0f);
-					}
+		if(!data || !bHasOctaves) {
+			return data;
+		}
 
-					x += in_props->turbulence_offset_x;
-					y += in_props->turbulence_offset_y;
+		// === Turbulence Pass ===
+		if(in_props->turbulence != 0.0f) {
+			const int turbulence_res = 8 << in_props->turbulence_res;
 
-					x = x * in_props->turbulence / 64.0f + (float)i / res;
-					y = y * in_props->turbulence / 64.0f + (float)j / res;
+			NoiseImage dx;
+			NoiseImage dy;
+			{
+				NG_PROFILE_STAGE("Turbulence", 2 * (int64_t)turbulence_res * turbulence_res);
+				if(!GenerateTurbulenceFields(*in_props, exec, dx, dy))
+					return {};
+			}
 
-					data[i + j * res] = Sample2D(temp, res, res, x, y);
-				}
+			NG_PROFILE_STAGE("Warp", pixels);
 
-				if(onProgress && !onProgress(0.4f + (float)j / res * 0.5f)) 
-				{
-					delete[] temp;
-					free(data);
-					free(dx);
-					free(dy);
-					return nullptr;
-				}
+			NoiseImage temp = data.Clone();
+			if(!temp)
+			{
+				NGLOG(LogNoise, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
 			}
 
-			delete[] temp;
-			free(dx);
-			free(dy);
+			if(!WarpImage(res, temp.Data(), data.Data(), dx, dy, *in_props, exec, stageProgress(0.4f, 0.9f)))
+			{
+				return {};
+			}
 		}
 
 		// === Normalize ===
-		float min_v = data[0], max_v = data[0];
-		for(int i = 1; i < res * res; i++) 
 		{
-			if(data[i] < min_v) min_v = data[i];
-			if(data[i] > max_v) max_v = data[i];
-		}
-		for(int i = 0; i < res * res; i++) 
-		{
-			data[i] = (data[i] - min_v) / (max_v - min_v);
+			NG_PROFILE_STAGE("Normalize", pixels);
+
+			float min_v, max_v;
+			MeasureRange(res, data.Data(), exec, min_v, max_v);
+			NormalizeImage(res, data.Data(), data.Data(), min_v, max_v, exec);
 		}
 
 		// === Marbling ===
 		if(in_props->marbling != 0.0f)
 		{
-			for(int i = 0; i < res * res; i++) 
-			{
-				data[i] = sinf(PI2 * data[i] * in_props->marbling) * 0.5f + 0.5f;
-			}
+			NG_PROFILE_STAGE("Marbling", pixels);
+			MarbleImage(res, data.Data(), in_props->marbling, exec);
 		}
 
 		if(onProgress && !onProgress(1.0f)) 
 		{
-			free(data);
-			return nullptr;
+			return {};
 		}
 
 		return data;
 	}
-	float* WorleyNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress)
+	NoiseImage WorleyNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress, WorleyFeature feature)
 	{
-		if(!props) return nullptr;
+		if(!props) return {};
+
+		const int64_t pixels = (int64_t)res * res;
+		NG_PROFILE_STAGE("WorleyNoise2D", pixels);
+		NG_PROFILE_COUNTER("WorleyNoise2D calls", 1);
+		MemoryJobScope memoryJob("WorleyNoise2D", EstimateWorleyNoise2DBytes(res, props));
 
 		unsigned int seed = static_cast<unsigned int>(props->seed);
 		int pointCount = std::max(1, 32 << std::max(0, (int)(props->low_freq_skip - props->high_freq_skip)));
 
-		srand(seed);
+		// Point i is drawn from stream indices 2i / 2i + 1, no global RNG state is touched
 		std::vector<std::pair<float, float>> points;
 		points.reserve(pointCount);
 
 		for(int i = 0; i < pointCount; ++i) {
-			points.emplace_back(static_cast<float>(rand()) / RAND_MAX,
-				static_cast<float>(rand()) / RAND_MAX);
+			points.emplace_back(HashRandom::Float(seed, 2 * i), HashRandom::Float(seed, 2 * i + 1));
 		}
 
-		float* data = (float*)calloc(sizeof(float), res * res);
+		WorleyGrid grid;
+		grid.Build(points);
+
+		// Every pixel is written by the distance pass
+		NoiseImage data(res, res);
 		if(!data) {
 			NGLOG(LogNoise, Error, "Out of memory in WorleyNoise2D");
-			return nullptr;
+			return {};
 		}
 
-		for(int y = 0; y < res; ++y) {
-			for(int x = 0; x < res; ++x) {
-				float fx = static_cast<float>(x) / res;
-				float fy = static_cast<float>(y) / res;
-
-				float minDist = 999999.0f;
-				for(const auto& [px, py] : points) {
-					float d = Distance(fx, fy, px, py);
-					if(d < minDist) minDist = d;
+		{
+			NG_PROFILE_STAGE("Distance", pixels);
+			for(int y = 0; y < res; ++y) {
+				for(int x = 0; x < res; ++x) {
+					float fx = static_cast<float>(x) / res;
+					float fy = static_cast<float>(y) / res;
+
+					// F1 and F2 come out of the same neighbour-cell search
+					float f1, f2;
+					grid.Query(fx, fy, f1, f2);
+
+					switch(feature) {
+					case WorleyFeature::F2:			data[x + y * res] = f2; break;
+					case WorleyFeature::F2MinusF1:	data[x + y * res] = f2 - f1; break;
+					default:						data[x + y * res] = f1; break;
+					}
 				}
 
-				data[x + y * res] = minDist;
-			}
-
-			if(onProgress && !onProgress((float)y / res * 0.4f)) {
-				free(data);
-				return nullptr;
+				if(onProgress && !onProgress((float)y / res * 0.4f)) {
+					return {};
+				}
 			}
 		}
 
 		// === Turbulence Pass ===
 		if(props->turbulence != 0.0f) {
-			NoiseProperties prop = *props;
-			prop.turbulence = 0.0f;
-			prop.roughness = props->turbulence_roughness;
-			prop.low_freq_skip = props->turbulence_low_freq_skip;
-			prop.high_freq_skip = props->turbulence_high_freq_skip;
-			prop.marbling = props->turbulence_marbling;
+			NoiseProperties prop = MakeTurbulenceProperties(*props);
 
 			int turbulence_res = 8 << props->turbulence_res;
 			float turbulence_exp = powf(2.0f, props->turbulence_expshift);
 
-			prop.seed = props->seed + 100;
-			float* dx = WorleyNoise2D(turbulence_res, &prop, [] (float) { return true; });
-			prop.seed = props->seed + 200;
-			float* dy = WorleyNoise2D(turbulence_res, &prop, [] (float) { return true; });
+			NoiseImage dx;
+			NoiseImage dy;
+			{
+				NG_PROFILE_STAGE("Turbulence", 2 * (int64_t)turbulence_res * turbulence_res);
+				prop.seed = props->seed + 100;
+				dx = WorleyNoise2D(turbulence_res, &prop, [] (float) { return true; }, feature);
+				prop.seed = props->seed + 200;
+				dy = WorleyNoise2D(turbulence_res, &prop, [] (float) { return true; }, feature);
+			}
 
 			if(!dx || !dy) {
-				if(data) free(data);
-				if(dx) free(dx);
-				if(dy) free(dy);
 				NGLOG(LogNoise, Error, "Turbulence sub-pass failed");
-				return nullptr;
+				return {};
 			}
 
-			float* temp = new float[res * res];
-			memcpy(temp, data, res * res * sizeof(float));
+			NG_PROFILE_STAGE("Warp", pixels);
+
+			NoiseImage temp = data.Clone();
+			if(!temp) {
+				NGLOG(LogNoise, Error, "Out of memory in WorleyNoise2D");
+				return {};
+			}
 
 			for(int j = 0; j < res; j++) {
 				for(int i = 0; i < res; i++) {
-					float x = Sample2D(dx, turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
-					float y = Sample2D(dy, turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+					float x = Sample2D(dx.Data(), turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+					float y = Sample2D(dy.Data(), turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
 
 					if(turbulence_exp != 1.0f) {
 						x = powf(fabsf(x), turbulence_exp) * (x >= 0.0f ? 1.0f : -1.0f);
@@ -353,45 +415,67 @@ namespace NG
 					x = x * props->turbulence / 64.0f + (float)i / res;
 					y = y * props->turbulence / 64.0f + (float)j / res;
 
-					data[i + j * res] = Sample2D(temp, res, res, x, y);
+					data[i + j * res] = Sample2D(temp.Data(), res, res, x, y);
 				}
 
 				if(onProgress && !onProgress(0.4f + (float)j / res * 0.4f)) {
-					delete[] temp;
-					free(data);
-					free(dx);
-					free(dy);
-					return nullptr;
+					return {};
 				}
 			}
-
-			delete[] temp;
-			free(dx);
-			free(dy);
 		}
 
 		// Normalize
-		float min_v = data[0], max_v = data[0];
-		for(int i = 1; i < res * res; i++) {
-			if(data[i] < min_v) min_v = data[i];
-			if(data[i] > max_v) max_v = data[i];
-		}
-		for(int i = 0; i < res * res; i++) {
-			data[i] = (data[i] - min_v) / (max_v - min_v);
+		{
+			NG_PROFILE_STAGE("Normalize", pixels);
+			float min_v = data[0], max_v = data[0];
+			for(int i = 1; i < res * res; i++) {
+				if(data[i] < min_v) min_v = data[i];
+				if(data[i] > max_v) max_v = data[i];
+			}
+			for(int i = 0; i < res * res; i++) {
+				data[i] = (data[i] - min_v) / (max_v - min_v);
+			}
 		}
 
 		// Optional marbling pass
 		if(props->marbling != 0.0f) {
+			NG_PROFILE_STAGE("Marbling", pixels);
 			for(int i = 0; i < res * res; i++) {
 				data[i] = sinf(PI2 * data[i] * props->marbling) * 0.5f + 0.5f;
 			}
 		}
 
 		if(onProgress && !onProgress(1.0f)) {
-			free(data);
-			return nullptr;
+			return {};
 		}
 
 		return data;
 	}
-}
\ No newline at end of file
+
+	uint64_t EstimateFBMNoise2DBytes(int res, const NoiseProperties* props)
+	{
+		if(!props || res <= 0) return 0;
+
+		if(props->domain == NoiseDomain::Unbounded)
+			return BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res) + EstimateRegionBytes(res, props, res, res);
+
+		// Octaves hold the image and the lattice rows hashed per band, Normalize adds two floats per row
+		const uint64_t pass = BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res) + sizeof(float) * 2 * (uint64_t)res
+			+ EstimateOctaveStackBytes(res, props);
+		return EstimateWithTurbulence(res, *props, pass, [] (int fieldRes, const NoiseProperties& field)
+			{
+				return EstimateFBMNoise2DBytes(fieldRes, &field);
+			});
+	}
+
+	uint64_t EstimateWorleyNoise2DBytes(int res, const NoiseProperties* props)
+	{
+		if(!props || res <= 0) return 0;
+
+		const uint64_t pass = BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res);
+		return EstimateWithTurbulence(res, *props, pass, [] (int fieldRes, const NoiseProperties& field)
+			{
+				return EstimateWorleyNoise2DBytes(fieldRes, &field);
+			});
+	}
+}
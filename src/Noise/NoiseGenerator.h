@@ -1,15 +1,36 @@
 #pragma once
 
+#include "NoiseImage.h"
 #include "NoiseTypes.h"
+#include "WorleyGrid.h"
+#include <cstdint>
 #include <functional>
 
 namespace NG
 {
-	float* StupidNoise1D(int res, int freq, float* data2, float scale, unsigned int seed);
-	float* StupidNoise2D(int res, int freq, float* data2, float scale, unsigned int seed);
-	float* StupidNoise3D(int res, int freq, float* data2, float scale, unsigned int seed);
-	float* FBMNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress);
+	/**
+	 * One octave of lattice noise added to data2 and returned; an empty data2 starts from a zeroed
+	 * res (x res (x res)) image. Pass the accumulated image back in with std::move.
+	 */
+	NoiseImage StupidNoise1D(int res, int freq, NoiseImage data2, float scale, unsigned int seed);
+	NoiseImage StupidNoise2D(int res, int freq, NoiseImage data2, float scale, unsigned int seed, const NoiseExecution& exec = {});
+	NoiseImage StupidNoise3D(int res, int freq, NoiseImage data2, float scale, unsigned int seed);
 
-	float* WorleyNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress = nullptr);
+	/**
+	 * Normalized res x res image, empty if canceled by onProgress.
+	 * With props->domain Unbounded the image is the world rectangle [0, res)^2 of a non-repeating
+	 * plane, normalized by the octave amplitude sum (see NoiseDomain); the other generators ignore domain.
+	 */
+	NoiseImage FBMNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress, const NoiseExecution& exec = {});
+
+	NoiseImage WorleyNoise2D(int res, const NoiseProperties* props, std::function<bool(float)> onProgress = nullptr,
+		WorleyFeature feature = WorleyFeature::F1);
+
+	/**
+	 * Estimated peak memory of one FBMNoise2D / WorleyNoise2D call, turbulence fields included.
+	 * Generators reserve it from the MemoryTracker budget before they allocate anything.
+	 */
+	uint64_t EstimateFBMNoise2DBytes(int res, const NoiseProperties* props);
+	uint64_t EstimateWorleyNoise2DBytes(int res, const NoiseProperties* props);
 
 }
\ No newline at end of file
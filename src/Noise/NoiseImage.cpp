@@ -0,0 +1,62 @@
+#include "NoiseImage.h"
+#include "Memory/BufferPool.h"
+#include <cstring>
+#include <utility>
+
+NoiseImage::NoiseImage(int width, int height, int depth, bool bZeroed)
+{
+	if(width <= 0 || height <= 0 || depth <= 0)
+		return;
+
+	data = static_cast<float*>(BufferPool::Get().Acquire(sizeof(float) * (size_t)width * height * depth, bZeroed));
+	if(data)
+	{
+		this->width = width;
+		this->height = height;
+		this->depth = depth;
+	}
+}
+
+NoiseImage::~NoiseImage()
+{
+	Reset();
+}
+
+NoiseImage::NoiseImage(NoiseImage&& other) noexcept
+	: data(std::exchange(other.data, nullptr))
+	, width(std::exchange(other.width, 0))
+	, height(std::exchange(other.height, 0))
+	, depth(std::exchange(other.depth, 0))
+{
+}
+
+NoiseImage& NoiseImage::operator=(NoiseImage&& other) noexcept
+{
+	if(this != &other)
+	{
+		Reset();
+		data = std::exchange(other.data, nullptr);
+		width = std::exchange(other.width, 0);
+		height = std::exchange(other.height, 0);
+		depth = std::exchange(other.depth, 0);
+	}
+	return *this;
+}
+
+NoiseImage NoiseImage::Clone() const
+{
+	if(!data)
+		return NoiseImage();
+
+	NoiseImage copy(width, height, depth);
+	if(copy)
+		memcpy(copy.data, data, GetBytes());
+	return copy;
+}
+
+void NoiseImage::Reset()
+{
+	BufferPool::Get().Release(data);
+	data = nullptr;
+	width = height = depth = 0;
+}
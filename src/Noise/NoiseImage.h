@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+
+/**
+ * Owning float buffer the noise generators return: width x height x depth values, row-major and
+ * 64-byte aligned. Storage comes from the BufferPool and goes back to it when the image is
+ * destroyed, so a regeneration at the same resolution reuses the previous buffers.
+ * An empty image (no storage) stands for a canceled or failed generation.
+ */
+class NoiseImage
+{
+public:
+	NoiseImage() = default;
+
+	/** Uninitialized, or zero filled with bZeroed; the image stays empty when out of memory */
+	NoiseImage(int width, int height, int depth = 1, bool bZeroed = false);
+	~NoiseImage();
+
+	NoiseImage(NoiseImage&& other) noexcept;
+	NoiseImage& operator=(NoiseImage&& other) noexcept;
+
+	NoiseImage(const NoiseImage&) = delete;
+	NoiseImage& operator=(const NoiseImage&) = delete;
+
+	/** Copy with its own buffer, empty when out of memory */
+	NoiseImage Clone() const;
+
+	/** Returns the buffer to the pool and leaves the image empty */
+	void Reset();
+
+	float* Data() { return data; }
+	const float* Data() const { return data; }
+
+	float& operator[](size_t index) { return data[index]; }
+	const float& operator[](size_t index) const { return data[index]; }
+
+	int GetWidth() const { return width; }
+	int GetHeight() const { return height; }
+	int GetDepth() const { return depth; }
+
+	/** Number of values and their size in bytes */
+	size_t GetCount() const { return (size_t)width * height * depth; }
+	size_t GetBytes() const { return GetCount() * sizeof(float); }
+
+	bool IsEmpty() const { return data == nullptr; }
+	explicit operator bool() const { return data != nullptr; }
+
+private:
+	float* data = nullptr;
+	int width = 0;
+	int height = 0;
+	int depth = 0;
+};
@@ -1,44 +1,13 @@
 #include "NoiseMath.h"
+#include "NoiseSimd.h"
+#include "Utils/HalfFloat.h"
 #include <cmath>
-#include <immintrin.h> 
 #include <cassert>
 #include <algorithm>
+#include <atomic>
 
 namespace NG
 {
-	int CalcIndex1D(int x, int res)
-	{
-		x %= res; 
-		if(x < 0) x += res;
-
-		return x;
-	}
-
-	int CalcIndex2D(int x, int y, int res)
-	{
-		x %= res; 
-		if(x < 0) x += res;
-		
-		y %= res; 
-		if(y < 0) y += res;
-
-		return x + y * res;
-	}
-
-	int CalcIndex3D(int x, int y, int z, int res)
-	{
-		x %= res; 
-		if(x < 0) x += res;
-		
-		y %= res; 
-		if(y < 0) y += res;
-		
-		z %= res; 
-		if(z < 0) z += res;
-
-		return x + y * res + z * res * res;
-	}
-
 	float Interpolate1D(const float* data, float xf)
 	{
 		const float x2 = xf * xf;
@@ -167,4 +136,494 @@ namespace NG
 
 		return d1 * (1.0f - yf) + d2 * yf;
 	}
-}
\ No newline at end of file
+
+	namespace
+	{
+		std::atomic<int> activeSimdLevel{ -1 };
+
+		SimdLevel DetectSimdLevel()
+		{
+#if NG_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			const int maxLeaf = info[0];
+
+			__cpuid(info, 1);
+			const bool bSSE2 = (info[3] & (1 << 26)) != 0;
+			const bool bOSXSave = (info[2] & (1 << 27)) != 0;
+			const bool bAVX = (info[2] & (1 << 28)) != 0;
+
+			if(maxLeaf >= 7 && bOSXSave && bAVX && (_xgetbv(0) & 0x6) == 0x6)
+			{
+				__cpuidex(info, 7, 0);
+				if(info[1] & (1 << 5))
+					return SimdLevel::AVX2;
+			}
+			return bSSE2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+#else
+			__builtin_cpu_init();
+			if(__builtin_cpu_supports("avx2"))
+				return SimdLevel::AVX2;
+			if(__builtin_cpu_supports("sse2"))
+				return SimdLevel::SSE2;
+			return SimdLevel::Scalar;
+#endif
+#else
+			return SimdLevel::Scalar;
+#endif
+		}
+
+		/** Half float conversion instructions, every AVX2 CPU so far has them but they are a separate flag */
+		bool HasF16C()
+		{
+#if NG_SIMD_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 1);
+			static const bool bF16C = (info[2] & (1 << 29)) != 0;
+#else
+			__builtin_cpu_init();
+			static const bool bF16C = __builtin_cpu_supports("f16c");
+#endif
+			return bF16C;
+#else
+			return false;
+#endif
+		}
+
+		void InterpolateXScalar(const float* row, const BSplineColumns& columns, int begin, int count, float* out)
+		{
+			const int stride = columns.count;
+			const int* t0 = columns.taps.data() + begin;
+			const int* t1 = t0 + stride;
+			const int* t2 = t1 + stride;
+			const int* t3 = t2 + stride;
+			const float* w0 = columns.weights.data() + begin;
+			const float* w1 = w0 + stride;
+			const float* w2 = w1 + stride;
+			const float* w3 = w2 + stride;
+
+			for(int i = 0; i < count; i++)
+			{
+				out[i] = (row[t0[i]] * w0[i] + row[t1[i]] * w1[i] + row[t2[i]] * w2[i] + row[t3[i]] * w3[i]) / 6.0f;
+			}
+		}
+
+		template<bool bAccumulate>
+		void InterpolateYScalar(const float* const* rows, const float* wy, int count, float scale, float* out)
+		{
+			const float* r0 = rows[0];
+			const float* r1 = rows[1];
+			const float* r2 = rows[2];
+			const float* r3 = rows[3];
+
+			for(int i = 0; i < count; i++)
+			{
+				const float v = (r0[i] * wy[0] + r1[i] * wy[1] + r2[i] * wy[2] + r3[i] * wy[3]) / 6.0f;
+				if(bAccumulate)
+					out[i] += v * scale;
+				else
+					out[i] = v;
+			}
+		}
+
+		void AccumulateScaledScalar(const float* in, int count, float scale, float* acc)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				acc[i] += in[i] * scale;
+			}
+		}
+
+		void AccumulateScaledHalfScalar(const uint16_t* in, int count, float scale, float* acc)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				acc[i] += HalfFloat::ToFloat(in[i]) * scale;
+			}
+		}
+
+		void ConvertToHalfScalar(const float* in, int count, uint16_t* out)
+		{
+			for(int i = 0; i < count; i++)
+			{
+				out[i] = HalfFloat::FromFloat(in[i]);
+			}
+		}
+
+#if NG_SIMD_X86
+		void InterpolateXSSE2(const float* row, const BSplineColumns& columns, int begin, int count, float* out)
+		{
+			const int stride = columns.count;
+			const int* t0 = columns.taps.data() + begin;
+			const int* t1 = t0 + stride;
+			const int* t2 = t1 + stride;
+			const int* t3 = t2 + stride;
+			const float* w0 = columns.weights.data() + begin;
+			const float* w1 = w0 + stride;
+			const float* w2 = w1 + stride;
+			const float* w3 = w2 + stride;
+
+			const __m128 six = _mm_set1_ps(6.0f);
+			auto tap = [row] (const int* t, int i)
+				{
+					return _mm_setr_ps(row[t[i]], row[t[i + 1]], row[t[i + 2]], row[t[i + 3]]);
+				};
+
+			int i = 0;
+			for(; i + 4 <= count; i += 4)
+			{
+				__m128 c = _mm_mul_ps(tap(t0, i), _mm_loadu_ps(w0 + i));
+				c = _mm_add_ps(c, _mm_mul_ps(tap(t1, i), _mm_loadu_ps(w1 + i)));
+				c = _mm_add_ps(c, _mm_mul_ps(tap(t2, i), _mm_loadu_ps(w2 + i)));
+				c = _mm_add_ps(c, _mm_mul_ps(tap(t3, i), _mm_loadu_ps(w3 + i)));
+				_mm_storeu_ps(out + i, _mm_div_ps(c, six));
+			}
+
+			InterpolateXScalar(row, columns, begin + i, count - i, out + i);
+		}
+
+		template<bool bAccumulate>
+		void InterpolateYSSE2(const float* const* rows, const float* wy, int count, float scale, float* out)
+		{
+			const __m128 six = _mm_set1_ps(6.0f);
+			const __m128 vscale = _mm_set1_ps(scale);
+			const __m128 vy0 = _mm_set1_ps(wy[0]);
+			const __m128 vy1 = _mm_set1_ps(wy[1]);
+			const __m128 vy2 = _mm_set1_ps(wy[2]);
+			const __m128 vy3 = _mm_set1_ps(wy[3]);
+
+			int i = 0;
+			for(; i + 4 <= count; i += 4)
+			{
+				__m128 v = _mm_mul_ps(_mm_loadu_ps(rows[0] + i), vy0);
+				v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(rows[1] + i), vy1));
+				v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(rows[2] + i), vy2));
+				v = _mm_add_ps(v, _mm_mul_ps(_mm_loadu_ps(rows[3] + i), vy3));
+				v = _mm_div_ps(v, six);
+
+				if(bAccumulate)
+					_mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(v, vscale)));
+				else
+					_mm_storeu_ps(out + i, v);
+			}
+
+			const float* tail[4] = { rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i };
+			InterpolateYScalar<bAccumulate>(tail, wy, count - i, scale, out + i);
+		}
+
+		void AccumulateScaledSSE2(const float* in, int count, float scale, float* acc)
+		{
+			const __m128 vscale = _mm_set1_ps(scale);
+
+			int i = 0;
+			for(; i + 4 <= count; i += 4)
+			{
+				_mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(in + i), vscale)));
+			}
+
+			AccumulateScaledScalar(in + i, count - i, scale, acc + i);
+		}
+
+		NG_TARGET_AVX2 void InterpolateXAVX2(const float* row, const BSplineColumns& columns, int begin, int count, float* out)
+		{
+			const int stride = columns.count;
+			const int* t0 = columns.taps.data() + begin;
+			const int* t1 = t0 + stride;
+			const int* t2 = t1 + stride;
+			const int* t3 = t2 + stride;
+			const float* w0 = columns.weights.data() + begin;
+			const float* w1 = w0 + stride;
+			const float* w2 = w1 + stride;
+			const float* w3 = w2 + stride;
+
+			const __m256 six = _mm256_set1_ps(6.0f);
+
+			int i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				__m256 c = _mm256_mul_ps(_mm256_i32gather_ps(row, _mm256_loadu_si256((const __m256i*)(t0 + i)), 4), _mm256_loadu_ps(w0 + i));
+				c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_i32gather_ps(row, _mm256_loadu_si256((const __m256i*)(t1 + i)), 4), _mm256_loadu_ps(w1 + i)));
+				c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_i32gather_ps(row, _mm256_loadu_si256((const __m256i*)(t2 + i)), 4), _mm256_loadu_ps(w2 + i)));
+				c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_i32gather_ps(row, _mm256_loadu_si256((const __m256i*)(t3 + i)), 4), _mm256_loadu_ps(w3 + i)));
+				_mm256_storeu_ps(out + i, _mm256_div_ps(c, six));
+			}
+
+			InterpolateXScalar(row, columns, begin + i, count - i, out + i);
+		}
+
+		template<bool bAccumulate>
+		NG_TARGET_AVX2 void InterpolateYAVX2(const float* const* rows, const float* wy, int count, float scale, float* out)
+		{
+			const __m256 six = _mm256_set1_ps(6.0f);
+			const __m256 vscale = _mm256_set1_ps(scale);
+			const __m256 vy0 = _mm256_set1_ps(wy[0]);
+			const __m256 vy1 = _mm256_set1_ps(wy[1]);
+			const __m256 vy2 = _mm256_set1_ps(wy[2]);
+			const __m256 vy3 = _mm256_set1_ps(wy[3]);
+
+			int i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				__m256 v = _mm256_mul_ps(_mm256_loadu_ps(rows[0] + i), vy0);
+				v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(rows[1] + i), vy1));
+				v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(rows[2] + i), vy2));
+				v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_loadu_ps(rows[3] + i), vy3));
+				v = _mm256_div_ps(v, six);
+
+				if(bAccumulate)
+					_mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(v, vscale)));
+				else
+					_mm256_storeu_ps(out + i, v);
+			}
+
+			const float* tail[4] = { rows[0] + i, rows[1] + i, rows[2] + i, rows[3] + i };
+			InterpolateYScalar<bAccumulate>(tail, wy, count - i, scale, out + i);
+		}
+
+		NG_TARGET_AVX2 void AccumulateScaledAVX2(const float* in, int count, float scale, float* acc)
+		{
+			const __m256 vscale = _mm256_set1_ps(scale);
+
+			int i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				_mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), vscale)));
+			}
+
+			AccumulateScaledScalar(in + i, count - i, scale, acc + i);
+		}
+
+		NG_TARGET_AVX2_F16C void AccumulateScaledHalfF16C(const uint16_t* in, int count, float scale, float* acc)
+		{
+			const __m256 vscale = _mm256_set1_ps(scale);
+
+			int i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				const __m256 v = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+				_mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(v, vscale)));
+			}
+
+			AccumulateScaledHalfScalar(in + i, count - i, scale, acc + i);
+		}
+
+		NG_TARGET_AVX2_F16C void ConvertToHalfF16C(const float* in, int count, uint16_t* out)
+		{
+			int i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_cvtps_ph(_mm256_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT));
+			}
+
+			ConvertToHalfScalar(in + i, count - i, out + i);
+		}
+#endif
+	}
+
+	SimdLevel GetSupportedSimdLevel()
+	{
+		static const SimdLevel supported = DetectSimdLevel();
+		return supported;
+	}
+
+	SimdLevel GetSimdLevel()
+	{
+		const int level = activeSimdLevel.load(std::memory_order_relaxed);
+		return level < 0 ? GetSupportedSimdLevel() : static_cast<SimdLevel>(level);
+	}
+
+	void SetSimdLevel(SimdLevel level)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+		activeSimdLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+	}
+
+	void PaddedLattice2D::Resize(int freq)
+	{
+		this->freq = freq;
+		stride = PadBefore + freq + PadAfter;
+		values.resize((size_t)stride * stride);
+	}
+
+	void PaddedLattice2D::WrapRow(float* row, int freq)
+	{
+		for(int x = -PadBefore; x < 0; x++)
+			row[x] = row[x + freq];
+		for(int x = freq; x < freq + PadAfter; x++)
+			row[x] = row[x - freq];
+	}
+
+	void PaddedLattice2D::WrapBorders()
+	{
+		for(int y = 0; y < freq; y++)
+			WrapRow(Row(y), freq);
+
+		// Whole rows, border columns included
+		for(int y = -PadBefore; y < 0; y++)
+			std::copy(Row(y + freq) - PadBefore, Row(y + freq) - PadBefore + stride, Row(y) - PadBefore);
+		for(int y = freq; y < freq + PadAfter; y++)
+			std::copy(Row(y - freq) - PadBefore, Row(y - freq) - PadBefore + stride, Row(y) - PadBefore);
+	}
+
+	void BSplineColumns::Build(int x0, int count, int freq, int res, bool bPadded)
+	{
+		this->count = count;
+		taps.resize((size_t)count * 4);
+		weights.resize((size_t)count * 4);
+
+		const bool bPowerOfTwo = IsPowerOfTwo(freq);
+
+		for(int i = 0; i < count; i++)
+		{
+			const int x = x0 + i;
+			const int x3 = LatticeCell(x, freq, res) - 1;
+			float xf = (float)((int64_t)x * freq) / res;
+			xf -= floorf(xf);
+
+			float w[4];
+			BSplineWeights(xf, w);
+			for(int k = 0; k < 4; k++)
+			{
+				if(bPadded)
+					taps[k * count + i] = x3 + k;
+				else
+					taps[k * count + i] = bPowerOfTwo ? CalcIndex1D<true>(x3 + k, freq) : CalcIndex1D(x3 + k, freq);
+				weights[k * count + i] = w[k];
+			}
+		}
+	}
+
+	void BSplineColumns::BuildUnbounded(int64_t x0, int count, int freq, int res)
+	{
+		this->count = count;
+		taps.resize((size_t)count * 4);
+		weights.resize((size_t)count * 4);
+
+		float xf = 0.0f;
+		firstTap = WorldLatticeCell(x0, freq, res, xf) - 1;
+		tapCount = count > 0 ? (int)(WorldLatticeCell(x0 + count - 1, freq, res, xf) - 1 + 4 - firstTap) : 0;
+
+		for(int i = 0; i < count; i++)
+		{
+			const int x3 = (int)(WorldLatticeCell(x0 + i, freq, res, xf) - 1 - firstTap);
+
+			float w[4];
+			BSplineWeights(xf, w);
+			for(int k = 0; k < 4; k++)
+			{
+				taps[k * count + i] = x3 + k;
+				weights[k * count + i] = w[k];
+			}
+		}
+	}
+
+	void InterpolateBSplineX(SimdLevel level, const float* row, const BSplineColumns& columns, int begin, int count, float* out)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+		switch(level)
+		{
+#if NG_SIMD_X86
+		case SimdLevel::AVX2:
+			InterpolateXAVX2(row, columns, begin, count, out);
+			break;
+		case SimdLevel::SSE2:
+			InterpolateXSSE2(row, columns, begin, count, out);
+			break;
+#endif
+		default:
+			InterpolateXScalar(row, columns, begin, count, out);
+			break;
+		}
+	}
+
+	void InterpolateBSplineY(SimdLevel level, const float* const* rows, const float* wy, int count, float* out)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+		switch(level)
+		{
+#if NG_SIMD_X86
+		case SimdLevel::AVX2:
+			InterpolateYAVX2<false>(rows, wy, count, 1.0f, out);
+			break;
+		case SimdLevel::SSE2:
+			InterpolateYSSE2<false>(rows, wy, count, 1.0f, out);
+			break;
+#endif
+		default:
+			InterpolateYScalar<false>(rows, wy, count, 1.0f, out);
+			break;
+		}
+	}
+
+	void AccumulateBSplineY(SimdLevel level, const float* const* rows, const float* wy, int count, float scale, float* acc)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+		switch(level)
+		{
+#if NG_SIMD_X86
+		case SimdLevel::AVX2:
+			InterpolateYAVX2<true>(rows, wy, count, scale, acc);
+			break;
+		case SimdLevel::SSE2:
+			InterpolateYSSE2<true>(rows, wy, count, scale, acc);
+			break;
+#endif
+		default:
+			InterpolateYScalar<true>(rows, wy, count, scale, acc);
+			break;
+		}
+	}
+
+	void AccumulateScaled(SimdLevel level, const float* in, int count, float scale, float* acc)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+		switch(level)
+		{
+#if NG_SIMD_X86
+		case SimdLevel::AVX2:
+			AccumulateScaledAVX2(in, count, scale, acc);
+			break;
+		case SimdLevel::SSE2:
+			AccumulateScaledSSE2(in, count, scale, acc);
+			break;
+#endif
+		default:
+			AccumulateScaledScalar(in, count, scale, acc);
+			break;
+		}
+	}
+
+	void AccumulateScaledHalf(SimdLevel level, const uint16_t* in, int count, float scale, float* acc)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+#if NG_SIMD_X86
+		if(level == SimdLevel::AVX2 && HasF16C())
+		{
+			AccumulateScaledHalfF16C(in, count, scale, acc);
+			return;
+		}
+#endif
+		AccumulateScaledHalfScalar(in, count, scale, acc);
+	}
+
+	void ConvertToHalf(SimdLevel level, const float* in, int count, uint16_t* out)
+	{
+		level = std::min(level, GetSupportedSimdLevel());
+
+#if NG_SIMD_X86
+		if(level == SimdLevel::AVX2 && HasF16C())
+		{
+			ConvertToHalfF16C(in, count, out);
+			return;
+		}
+#endif
+		ConvertToHalfScalar(in, count, out);
+	}
+}
@@ -1,7 +1,12 @@
 #pragma once
+#include "Memory/MemoryTracker.h"
 #include <cmath>
+#include <cstdint>
+#include <vector>
 namespace NG
 {
+	/** 2 pi, the period of the marbling sine */
+	constexpr float PI2 = 6.28318530717958647692528676655901f;
 
 	inline float Distance(float x1, float y1, float x2, float y2) {
 		float dx = x1 - x2;
@@ -18,9 +23,186 @@ namespace NG
 	float Interpolate3D_Linear(const float* data, float xf, float yf, float zf);
 
 
-	int CalcIndex1D(int x, int res);
-	int CalcIndex2D(int x, int y, int res);
-	int CalcIndex3D(int x, int y, int z, int res);
+	inline bool IsPowerOfTwo(int value)
+	{
+		return value > 0 && (value & (value - 1)) == 0;
+	}
+
+	/**
+	 * Wraps x into [0, res). The power-of-two specialization is a single mask, which
+	 * two's complement keeps correct for negative x. Callers pick it with IsPowerOfTwo.
+	 */
+	template<bool bPowerOfTwo = false>
+	inline int WrapIndex(int x, int res)
+	{
+		if constexpr(bPowerOfTwo)
+		{
+			return x & (res - 1);
+		}
+		else
+		{
+			x %= res;
+			if(x < 0) x += res;
+			return x;
+		}
+	}
+
+	template<bool bPowerOfTwo = false>
+	inline int CalcIndex1D(int x, int res)
+	{
+		return WrapIndex<bPowerOfTwo>(x, res);
+	}
+
+	template<bool bPowerOfTwo = false>
+	inline int CalcIndex2D(int x, int y, int res)
+	{
+		return WrapIndex<bPowerOfTwo>(x, res) + WrapIndex<bPowerOfTwo>(y, res) * res;
+	}
+
+	template<bool bPowerOfTwo = false>
+	inline int CalcIndex3D(int x, int y, int z, int res)
+	{
+		return WrapIndex<bPowerOfTwo>(x, res) + WrapIndex<bPowerOfTwo>(y, res) * res + WrapIndex<bPowerOfTwo>(z, res) * res * res;
+	}
+
+	/** Lattice cell containing pixel x of a res wide image sampling freq cells, 64-bit safe for huge images */
+	inline int LatticeCell(int x, int freq, int res)
+	{
+		return static_cast<int>(((int64_t)x * freq) / res);
+	}
+
+	/**
+	 * Lattice cell containing world pixel x (any sign) for freq cells per res pixels, and the position
+	 * of x inside that cell in [0, 1). Integer arithmetic, so the result only depends on x and not on
+	 * the rectangle x belongs to.
+	 */
+	inline int64_t WorldLatticeCell(int64_t x, int freq, int res, float& outFraction)
+	{
+		const int64_t scaled = x * freq;
+		int64_t cell = scaled / res;
+		int64_t rest = scaled - cell * res;
+		if(rest < 0)
+		{
+			cell--;
+			rest += res;
+		}
+		outFraction = (float)rest / (float)res;
+		return cell;
+	}
+
+	/**
+	 * Square tiling lattice stored with a wrapped border: one cell before and two after
+	 * every row and column. B-spline taps (x3 .. x3 + 3 with x3 in [-1, freq - 2]) can
+	 * then be read directly, without wrapping in the inner loop.
+	 */
+	struct PaddedLattice2D
+	{
+		static constexpr int PadBefore = 1;
+		static constexpr int PadAfter = 2;
+
+		int freq = 0;
+		int stride = 0;
+		TrackedVector<float> values;
+
+		/** Allocates a freq x freq lattice plus its border, contents undefined */
+		void Resize(int freq);
+
+		/** Wraps rows / columns [0, freq) into the border, call after the interior is written */
+		void WrapBorders();
+
+		/** Wraps columns [0, freq) of one padded row into its border, row points at column 0 */
+		static void WrapRow(float* row, int freq);
+
+		/** Lattice row y in [-1, freq + 1]; element x is valid for x in [-1, freq + 1] */
+		float* Row(int y) { return values.data() + (size_t)(y + PadBefore) * stride + PadBefore; }
+		const float* Row(int y) const { return values.data() + (size_t)(y + PadBefore) * stride + PadBefore; }
+	};
 
 	float Sample2D(const float* data, short width, short height, float x, float y);
+
+	/**
+	 * Cubic B-spline weights of the four taps around xf.
+	 * Same terms as Interpolate1D, so a weighted sum divided by 6 matches it bit for bit.
+	 */
+	inline void BSplineWeights(float xf, float* w)
+	{
+		const float x2 = xf * xf;
+		const float x3 = xf * x2;
+
+		w[0] = 1.0f - 3.0f * xf + 3.0f * x2 - 1.0f * x3;
+		w[1] = 4.0f - 6.0f * x2 + 3.0f * x3;
+		w[2] = 1.0f + 3.0f * xf + 3.0f * x2 - 3.0f * x3;
+		w[3] = 1.0f * x3;
+	}
+
+	/** Instruction sets the B-spline row kernel can dispatch to */
+	enum class SimdLevel
+	{
+		Scalar,
+		SSE2,
+		AVX2
+	};
+
+	/** Best instruction set supported by this CPU, detected once */
+	SimdLevel GetSupportedSimdLevel();
+
+	/** Instruction set used by the noise kernels (the supported one unless overridden) */
+	SimdLevel GetSimdLevel();
+
+	/** Overrides the kernel instruction set, clamped to what the CPU supports */
+	void SetSimdLevel(SimdLevel level);
+
+	/**
+	 * Lattice tap indices and B-spline weights for a run of output columns of one octave.
+	 * They only depend on x, so they are computed once and reused by every row.
+	 * Stored as four planes (tap k of column i at [k * count + i]) for vector loads.
+	 */
+	struct BSplineColumns
+	{
+		int count = 0;
+		std::vector<int> taps;
+		std::vector<float> weights;
+
+		/**
+		 * Fills the columns [x0, x0 + count) of a res wide image sampling a lattice of freq cells.
+		 * Taps are wrapped into [0, freq), or left unwrapped for rows of a PaddedLattice2D.
+		 */
+		void Build(int x0, int count, int freq, int res, bool bPadded = false);
+
+		/**
+		 * Fills the world columns [x0, x0 + count) of an unbounded lattice (see WorldLatticeCell).
+		 * Taps are relative to firstTap: tap t reads lattice column firstTap + t, tapCount columns in total.
+		 */
+		void BuildUnbounded(int64_t x0, int count, int freq, int res);
+
+		int64_t firstTap = 0;
+		int tapCount = 0;
+	};
+
+	/**
+	 * Separable evaluation, x pass: interpolates one lattice row at the output columns
+	 * [begin, begin + count) of columns, out[i] = Interpolate1D(row taps, xf).
+	 */
+	void InterpolateBSplineX(SimdLevel level, const float* row, const BSplineColumns& columns, int begin, int count, float* out);
+
+	/**
+	 * Separable evaluation, y pass: combines four x-interpolated rows with the row weights wy,
+	 * out[i] = Interpolate1D({ rows[0][i], .., rows[3][i] }, yf).
+	 */
+	void InterpolateBSplineY(SimdLevel level, const float* const* rows, const float* wy, int count, float* out);
+
+	/** Same as InterpolateBSplineY but adds the result times scale to acc */
+	void AccumulateBSplineY(SimdLevel level, const float* const* rows, const float* wy, int count, float scale, float* acc);
+
+	/**
+	 * acc[i] += in[i] * scale, the step the octave kernel adds a finished octave row with;
+	 * every SimdLevel rounds like the scalar loop.
+	 */
+	void AccumulateScaled(SimdLevel level, const float* in, int count, float scale, float* acc);
+
+	/** AccumulateScaled of IEEE binary16 values (HalfFloat), widened exactly; AVX2 uses F16C when present */
+	void AccumulateScaledHalf(SimdLevel level, const uint16_t* in, int count, float scale, float* acc);
+
+	/** out[i] = HalfFloat::FromFloat(in[i]), rounded to nearest even on every SimdLevel */
+	void ConvertToHalf(SimdLevel level, const float* in, int count, uint16_t* out);
 }
@@ -0,0 +1,197 @@
+#include "NoiseParallel.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/TraceRecorder.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace NG
+{
+	namespace
+	{
+		/** Bands queued per thread, so uneven rows (turbulence, skipped octaves) still balance out */
+		constexpr int BandsPerThread = 8;
+
+		/** Bands used on the serial path, which only exist to report progress */
+		constexpr int SerialBandCount = 64;
+
+		struct BandState
+		{
+			const std::function<void(int, int)>* body = nullptr;
+			int rows = 0;
+			int bandRows = 0;
+			int bandCount = 0;
+
+			std::atomic<int> nextBand{ 0 };
+			std::atomic<bool> bCanceled{ false };
+
+			std::mutex mutex;
+			std::condition_variable bandFinished;
+			int finishedBands = 0;
+			int finishedRows = 0;
+			std::exception_ptr error;
+
+			/** Memory job of the calling thread, helpers allocate on its behalf */
+			MemoryJob* memoryJob = nullptr;
+
+			/** Bands become trace slices named after the stage that started them */
+			bool bTrace = false;
+			std::string traceName;
+		};
+
+		/**
+		 * Claims and runs one band. Returns false when no band was left to claim.
+		 * Claimed bands are always counted as finished, even when skipped after a cancel.
+		 */
+		bool RunNextBand(BandState& state)
+		{
+			const int band = state.nextBand.fetch_add(1);
+			if(band >= state.bandCount)
+				return false;
+
+			const int begin = band * state.bandRows;
+			const int end = std::min(state.rows, begin + state.bandRows);
+			const TraceRecorder::Clock::time_point bandStart = state.bTrace ? TraceRecorder::Clock::now() : TraceRecorder::Clock::time_point{};
+
+			std::exception_ptr error;
+			if(!state.bCanceled)
+			{
+				try
+				{
+					(*state.body)(begin, end);
+				}
+				catch(...)
+				{
+					error = std::current_exception();
+					state.bCanceled = true;
+				}
+			}
+
+			if(state.bTrace)
+			{
+				TraceRecorder::Get().AddComplete(state.traceName, "band", bandStart, TraceRecorder::Clock::now(),
+					"{\"begin\":" + std::to_string(begin) + ",\"end\":" + std::to_string(end) + "}");
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(state.mutex);
+				state.finishedBands++;
+				state.finishedRows += end - begin;
+				if(error && !state.error) state.error = error;
+			}
+			state.bandFinished.notify_all();
+			return true;
+		}
+	}
+
+	ThreadPool& GetEnginePool()
+	{
+		// The calling thread always works on its own bands, so one thread less is enough.
+		// hardware_concurrency may report 0, which must not wrap around
+		static const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+		static ThreadPool pool(hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+		return pool;
+	}
+
+	int ResolveThreadCount(const NoiseExecution& exec)
+	{
+		if(exec.threadCount > 0)
+			return exec.threadCount;
+
+		return static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+	}
+
+	bool ParallelForRows(int rows, const NoiseExecution& exec, const std::function<void(int, int)>& body,
+		const std::function<bool(float)>& onProgress)
+	{
+		if(rows <= 0) return true;
+
+		const int threads = std::min(ResolveThreadCount(exec), rows);
+		if(threads <= 1)
+		{
+			const int bandRows = (rows + SerialBandCount - 1) / SerialBandCount;
+			for(int begin = 0; begin < rows; begin += bandRows)
+			{
+				const int end = std::min(rows, begin + bandRows);
+				body(begin, end);
+
+				if(onProgress && !onProgress((float)end / rows))
+					return false;
+			}
+			return true;
+		}
+
+		auto state = std::make_shared<BandState>();
+		state->body = &body;
+		state->rows = rows;
+		state->bandRows = std::max(1, rows / (threads * BandsPerThread));
+		state->bandCount = (rows + state->bandRows - 1) / state->bandRows;
+		state->memoryJob = MemoryTracker::GetCurrentJob();
+		if(Profiler::bEnabled && TraceRecorder::Get().IsRecording())
+		{
+			const std::string* stage = ScopedStageTimer::CurrentPath();
+			state->bTrace = true;
+			state->traceName = (stage ? *stage : std::string("ParallelForRows")) + " band";
+		}
+
+		// Helpers that only get scheduled after every band was claimed exit without touching body
+		ThreadPool& pool = GetEnginePool();
+		for(int i = 1; i < threads; ++i)
+		{
+			pool.Enqueue([state]
+				{
+					NG_TRACE_THREAD_NAME("Engine worker");
+					MemoryJobBinding binding(state->memoryJob);
+					while(RunNextBand(*state)) {}
+				});
+		}
+
+		bool bCanceled = false;
+		float reported = 0.0f;
+		auto report = [&] (float progress)
+			{
+				reported = progress;
+				if(onProgress && !bCanceled && !onProgress(progress))
+				{
+					bCanceled = true;
+					state->bCanceled = true;
+				}
+			};
+
+		while(RunNextBand(*state))
+		{
+			int finishedRows;
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				finishedRows = state->finishedRows;
+			}
+			report((float)finishedRows / rows);
+		}
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		while(state->finishedBands < state->bandCount)
+		{
+			state->bandFinished.wait(lock);
+
+			const int finishedRows = state->finishedRows;
+			lock.unlock();
+			report((float)finishedRows / rows);
+			lock.lock();
+		}
+		lock.unlock();
+
+		if(state->error)
+			std::rethrow_exception(state->error);
+
+		if(reported < 1.0f)
+			report(1.0f);
+
+		return !bCanceled;
+	}
+}
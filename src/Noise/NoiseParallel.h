@@ -0,0 +1,28 @@
+#pragma once
+
+#include "NoiseTypes.h"
+#include <functional>
+
+class ThreadPool;
+
+namespace NG
+{
+	/** Returns the process-wide worker pool shared by the noise generators */
+	ThreadPool& GetEnginePool();
+
+	/** Resolves NoiseExecution::threadCount to the number of threads that will work on a generation */
+	int ResolveThreadCount(const NoiseExecution& exec);
+
+	/**
+	 * Splits the rows [0, rows) into horizontal bands and calls body(begin, end) once per band.
+	 * With more than one thread the bands run on the engine pool and the calling thread takes
+	 * bands as well, so nested or saturated pools can never deadlock.
+	 *
+	 * onProgress is only invoked from the calling thread, with the completed fraction in [0, 1].
+	 * Returning false cancels every band that has not started yet.
+	 *
+	 * @return false if the work was canceled through onProgress
+	 */
+	bool ParallelForRows(int rows, const NoiseExecution& exec, const std::function<void(int, int)>& body,
+		const std::function<bool(float)>& onProgress = nullptr);
+}
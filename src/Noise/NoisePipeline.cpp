@@ -0,0 +1,276 @@
+#include "NoisePipeline.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseRegion.h"
+#include "Noise/NoiseStages.h"
+#include "Noise/OctaveKernel.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+DEFINE_LOG_CATEGORY(LogNoisePipeline);
+
+namespace NG
+{
+	namespace
+	{
+		/** Maps the fractions of one stage onto [begin, end] of the whole run */
+		std::function<bool(float)> ScaleProgress(const std::function<bool(float)>& onProgress, float begin, float end)
+		{
+			if(!onProgress) return nullptr;
+			return [&onProgress, begin, end] (float fraction) { return onProgress(begin + fraction * (end - begin)); };
+		}
+
+		NoiseImage AllocateImage(int res)
+		{
+			NoiseImage image(res, res);
+			if(!image)
+			{
+				NGLOG(LogNoisePipeline, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
+			}
+			return image;
+		}
+	}
+
+	NoiseImage NoisePipeline::Run(int res, const NoiseProperties& props, std::function<bool(float)> onProgress, const NoiseExecution& exec)
+	{
+		NG_PROFILE_STAGE("NoisePipeline", (int64_t)res * res);
+		NG_PROFILE_COUNTER("NoisePipeline runs", 1);
+		uint64_t estimate = EstimateBytes(res, props);
+		if(layerCache && props.domain == NoiseDomain::Tiled)
+			estimate += layerCache->EstimateBytes(res, props);
+		MemoryJobScope memoryJob("NoisePipeline", estimate);
+
+		if(props.domain == NoiseDomain::Unbounded)
+			return RunUnbounded(res, props, onProgress, exec);
+		return RunTiled(res, props, onProgress, exec);
+	}
+
+	NoiseImage NoisePipeline::RunTiled(int res, const NoiseProperties& props, const std::function<bool(float)>& onProgress, const NoiseExecution& exec)
+	{
+		const int64_t pixels = (int64_t)res * res;
+
+		// === Octaves ===
+		NoiseProperties sumProps = props;
+		sumProps.turbulence = 0.0f;
+		sumProps.marbling = 0.0f;
+		const NoiseCacheKey sumKey = NoiseCache::MakeKey(NoiseAlgorithm::FBM, res, sumProps);
+
+		// Float16 layers sum to slightly different values than the direct evaluation
+		const bool bHalfLayers = layerCache && layerCache->GetPrecision() == OctaveLayerCache::Precision::Float16;
+		if(!sum || sumInputs != sumKey || bSumHalfLayers != bHalfLayers)
+		{
+			NG_PROFILE_STAGE("Octaves", pixels);
+
+			// Invalidated first, so a canceled or failed stage is executed again next time
+			sum.Reset();
+			sumInputs = {};
+			sumVersion = 0;
+
+			if(layerCache)
+				sum = layerCache->SumOctaves(res, props, exec, ScaleProgress(onProgress, 0.0f, 0.4f), bHasOctaves);
+			else
+				sum = SumOctaves2D(res, props, exec, ScaleProgress(onProgress, 0.0f, 0.4f), bHasOctaves);
+			if(!sum)
+				return {};
+
+			sumInputs = sumKey;
+			bSumHalfLayers = bHalfLayers;
+			sumVersion = ++lastVersion;
+			runCounts[(int)Stage::Octaves]++;
+		}
+
+		// Without octaves FBMNoise2D returns the zero image as is
+		if(!bHasOctaves)
+		{
+			NoiseImage zero = sum.Clone();
+			if(!zero)
+			{
+				NGLOG(LogNoisePipeline, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
+			}
+			return zero;
+		}
+
+		const float* source = sum.Data();
+		uint64_t sourceVersion = sumVersion;
+
+		// === Turbulence Pass ===
+		if(props.turbulence != 0.0f)
+		{
+			const int turbulenceRes = 8 << props.turbulence_res;
+			const NoiseCacheKey fieldKey = NoiseCache::MakeKey(NoiseAlgorithm::FBM, turbulenceRes, MakeTurbulenceProperties(props));
+			if(!dx || !dy || fieldInputs != fieldKey)
+			{
+				NG_PROFILE_STAGE("Turbulence", 2 * (int64_t)turbulenceRes * turbulenceRes);
+
+				dx.Reset();
+				dy.Reset();
+				fieldInputs = {};
+				fieldVersion = 0;
+
+				if(!GenerateTurbulenceFields(props, exec, dx, dy))
+					return {};
+
+				fieldInputs = fieldKey;
+				fieldVersion = ++lastVersion;
+				runCounts[(int)Stage::Turbulence]++;
+			}
+
+			const WarpInputs inputs(sumVersion, fieldVersion, props.turbulence, props.turbulence_expshift,
+				props.turbulence_offset_x, props.turbulence_offset_y);
+			if(warpVersion == 0 || warpInputs != inputs)
+			{
+				NG_PROFILE_STAGE("Warp", pixels);
+
+				warpVersion = 0;
+				if(warped.GetWidth() != res)
+				{
+					warped.Reset();
+					warped = AllocateImage(res);
+				}
+
+				if(!WarpImage(res, sum.Data(), warped.Data(), dx, dy, props, exec, ScaleProgress(onProgress, 0.4f, 0.9f)))
+					return {};
+
+				warpInputs = inputs;
+				warpVersion = ++lastVersion;
+				runCounts[(int)Stage::Warp]++;
+			}
+
+			source = warped.Data();
+			sourceVersion = warpVersion;
+		}
+
+		// === Normalize ===
+		NoiseImage result = AllocateImage(res);
+		{
+			NG_PROFILE_STAGE("Normalize", pixels);
+
+			if(rangeSource != sourceVersion)
+			{
+				MeasureRange(res, source, exec, rangeMin, rangeMax);
+				rangeSource = sourceVersion;
+				runCounts[(int)Stage::Range]++;
+			}
+			NormalizeImage(res, source, result.Data(), rangeMin, rangeMax, exec);
+		}
+
+		// === Marbling ===
+		if(props.marbling != 0.0f)
+		{
+			NG_PROFILE_STAGE("Marbling", pixels);
+			MarbleImage(res, result.Data(), props.marbling, exec);
+		}
+
+		if(onProgress && !onProgress(1.0f))
+			return {};
+		return result;
+	}
+
+	NoiseImage NoisePipeline::RunUnbounded(int res, const NoiseProperties& props, const std::function<bool(float)>& onProgress, const NoiseExecution& exec)
+	{
+		const int64_t pixels = (int64_t)res * res;
+
+		// === Region ===
+		// GenerateRegion fuses octaves, warp and the fixed-range normalize; only marbling is split off
+		NoiseProperties regionProps = props;
+		regionProps.marbling = 0.0f;
+		const NoiseCacheKey regionKey = NoiseCache::MakeKey(NoiseAlgorithm::FBM, res, regionProps);
+		if(!region || regionInputs != regionKey)
+		{
+			NG_PROFILE_STAGE("Region", pixels);
+
+			regionInputs = {};
+			if(region.GetWidth() != res)
+			{
+				region.Reset();
+				region = AllocateImage(res);
+			}
+
+			if(!GenerateRegion(res, &regionProps, 0, 0, res, res, region.Data(), res, exec, ScaleProgress(onProgress, 0.0f, 0.9f)))
+				return {};
+
+			regionAmplitude = GetOctaveAmplitude(BuildOctaveStack(res, &props));
+			regionInputs = regionKey;
+			runCounts[(int)Stage::Region]++;
+		}
+
+		NoiseImage result = region.Clone();
+		if(!result)
+		{
+			NGLOG(LogNoisePipeline, Error, "Out of memory");
+			throw std::runtime_error("Out of memory");
+		}
+
+		// === Marbling ===
+		// Without octaves GenerateRegion returns zeros, which are not marbled
+		if(props.marbling != 0.0f && regionAmplitude != 0.0f)
+		{
+			NG_PROFILE_STAGE("Marbling", pixels);
+			MarbleImage(res, result.Data(), props.marbling, exec);
+		}
+
+		if(onProgress && !onProgress(1.0f))
+			return {};
+		return result;
+	}
+
+	void NoisePipeline::SetLayerCache(std::shared_ptr<OctaveLayerCache> cache)
+	{
+		layerCache = std::move(cache);
+	}
+
+	uint64_t NoisePipeline::GetCachedBytes() const
+	{
+		return sum.GetBytes() + dx.GetBytes() + dy.GetBytes() + warped.GetBytes() + region.GetBytes();
+	}
+
+	void NoisePipeline::Reset()
+	{
+		sum.Reset();
+		sumInputs = {};
+		sumVersion = 0;
+		bHasOctaves = false;
+		bSumHalfLayers = false;
+
+		dx.Reset();
+		dy.Reset();
+		fieldInputs = {};
+		fieldVersion = 0;
+
+		warped.Reset();
+		warpInputs = {};
+		warpVersion = 0;
+
+		rangeSource = 0;
+
+		region.Reset();
+		regionInputs = {};
+		regionAmplitude = 0.0f;
+	}
+
+	uint64_t NoisePipeline::EstimateBytes(int res, const NoiseProperties& props)
+	{
+		const uint64_t image = BufferPool::GetBucketBytes(sizeof(float) * (size_t)res * res);
+		if(props.domain == NoiseDomain::Unbounded)
+			return EstimateRegionBytes(res, &props, res, res) + 2 * image;
+
+		// The octave sum is built next to the cached images, the result next to all of them
+		uint64_t stage = EstimateOctaveStackBytes(res, &props) + image;
+		uint64_t cached = image;
+		if(props.turbulence != 0.0f)
+		{
+			const int turbulenceRes = 8 << props.turbulence_res;
+			const NoiseProperties fieldProps = MakeTurbulenceProperties(props);
+			const uint64_t field = BufferPool::GetBucketBytes(sizeof(float) * (size_t)turbulenceRes * turbulenceRes);
+
+			stage = std::max(stage, field + EstimateFBMNoise2DBytes(turbulenceRes, &fieldProps));
+			cached += image + 2 * field;
+		}
+		return stage + cached + image;
+	}
+}
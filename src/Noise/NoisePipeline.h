@@ -0,0 +1,110 @@
+#pragma once
+
+#include "NoiseCache.h"
+#include "NoiseImage.h"
+#include "NoiseTypes.h"
+#include "OctaveLayerCache.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <tuple>
+
+namespace NG
+{
+	/**
+	 * FBMNoise2D as a chain of cached stages for editors that regenerate the same map with small
+	 * parameter changes:
+	 *
+	 *   octaves -> turbulence fields -> warp -> range -> normalize -> marbling
+	 *
+	 * Every cached stage remembers the inputs it was computed from (the props fields it reads and
+	 * the versions of the stages it consumes) and is only executed again when one of them changed.
+	 * Editing marbling only reruns the two pointwise passes, editing the turbulence strength,
+	 * exponent or offsets reruns the warp but keeps the octave sum and the fields.
+	 *
+	 * Normalize and marbling write the returned image and run on every call; the octave sum, the
+	 * turbulence fields, the warped image and its range stay cached until their inputs change or
+	 * Reset is called, about two images plus the fields. Unbounded props (see NoiseDomain) cache
+	 * the whole GenerateRegion result apart from marbling as the Region stage.
+	 *
+	 * With an OctaveLayerCache set, the octave stage keeps every octave separately, so roughness and
+	 * frequency skip edits only recombine cached octaves instead of evaluating them again.
+	 *
+	 * Results equal FBMNoise2D bit for bit (unless the layer cache stores Float16). One Run at a
+	 * time; the returned images are independent.
+	 */
+	class NoisePipeline
+	{
+	public:
+		/** Cached stages, for GetRunCount */
+		enum class Stage
+		{
+			Octaves,
+			Turbulence,
+			Warp,
+			Range,
+			Region,
+			Count
+		};
+
+		/** Same image as FBMNoise2D(res, &props, onProgress, exec), empty if canceled */
+		NoiseImage Run(int res, const NoiseProperties& props, std::function<bool(float)> onProgress = nullptr,
+			const NoiseExecution& exec = {});
+
+		/** Octave layers the Octaves stage sums (Tiled domain); nullptr, the default, sums them directly */
+		void SetLayerCache(std::shared_ptr<OctaveLayerCache> cache);
+		const std::shared_ptr<OctaveLayerCache>& GetLayerCache() const { return layerCache; }
+
+		/** Times stage was executed instead of served from its cache */
+		uint64_t GetRunCount(Stage stage) const { return runCounts[(int)stage]; }
+
+		/** Bytes of the cached stage images, the layer cache not included */
+		uint64_t GetCachedBytes() const;
+
+		/** Frees every cached stage, the next Run starts from scratch; the layer cache is kept */
+		void Reset();
+
+		/** Peak memory of a Run that executes every stage, cached images included */
+		static uint64_t EstimateBytes(int res, const NoiseProperties& props);
+
+	private:
+		NoiseImage RunTiled(int res, const NoiseProperties& props, const std::function<bool(float)>& onProgress, const NoiseExecution& exec);
+		NoiseImage RunUnbounded(int res, const NoiseProperties& props, const std::function<bool(float)>& onProgress, const NoiseExecution& exec);
+
+		/** Warp inputs: sum and field versions, turbulence, expshift, offset x / y */
+		using WarpInputs = std::tuple<uint64_t, uint64_t, float, float, float, float>;
+
+		/** Raw octave sum, keyed like NoiseCache with turbulence and marbling cleared */
+		NoiseImage sum;
+		NoiseCacheKey sumInputs;
+		uint64_t sumVersion = 0;
+		bool bHasOctaves = false;
+		bool bSumHalfLayers = false;
+
+		/** Turbulence fields, keyed by their own FBMNoise2D inputs */
+		NoiseImage dx;
+		NoiseImage dy;
+		NoiseCacheKey fieldInputs;
+		uint64_t fieldVersion = 0;
+
+		NoiseImage warped;
+		WarpInputs warpInputs{};
+		uint64_t warpVersion = 0;
+
+		/** Range of the image with version rangeSource */
+		float rangeMin = 0.0f;
+		float rangeMax = 0.0f;
+		uint64_t rangeSource = 0;
+
+		/** Unbounded GenerateRegion result without marbling, and its octave amplitude sum */
+		NoiseImage region;
+		NoiseCacheKey regionInputs;
+		float regionAmplitude = 0.0f;
+
+		std::shared_ptr<OctaveLayerCache> layerCache;
+
+		/** Source of the stage versions, 0 stands for "not computed" */
+		uint64_t lastVersion = 0;
+		uint64_t runCounts[(int)Stage::Count] = {};
+	};
+}
@@ -0,0 +1,299 @@
+#include "NoiseQuery.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseSimd.h"
+#include "Noise/OctaveKernel.h"
+#include "Utils/HashRandom.h"
+#include "Logger/LoggerMacro.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+DEFINE_LOG_CATEGORY(LogNoiseQuery);
+
+namespace NG
+{
+	namespace
+	{
+		using Octave = NoiseQuery::Octave;
+
+		/** Lattice cell of p and the B-spline weights of its four taps */
+		inline uint32_t CellWeights(float p, float* w)
+		{
+			const float cell = floorf(p);
+			BSplineWeights(p - cell, w);
+			return static_cast<uint32_t>(static_cast<int32_t>(cell));
+		}
+
+		/**
+		 * Sum of the four taps of one lattice row, in the operation order of the fused octave kernel
+		 * (InterpolateBSplineX then AccumulateBSplineY), which keeps integer coordinates bit-identical
+		 */
+		inline float RowValue(uint32_t prefix, uint32_t cellX, uint32_t mask, const float* wx)
+		{
+			float row = HashRandom::ToFloat(HashRandom::Permute(((cellX - 1u) & mask) ^ prefix)) * wx[0];
+			for(uint32_t k = 1; k < 4; k++)
+				row = row + HashRandom::ToFloat(HashRandom::Permute(((cellX + k - 1u) & mask) ^ prefix)) * wx[k];
+			return row / 6.0f;
+		}
+
+		/** Octave value of a 2D lattice at (px, py) in cells; planeHash is Permute(seed) or a z slice hash */
+		inline float PlaneValue(uint32_t planeHash, uint32_t cellX, uint32_t cellY, uint32_t mask, const float* wx, const float* wy)
+		{
+			float sum = 0.0f;
+			for(uint32_t r = 0; r < 4; r++)
+			{
+				const uint32_t prefix = HashRandom::Permute(((cellY + r - 1u) & mask) ^ planeHash);
+				const float c = RowValue(prefix, cellX, mask, wx) * wy[r];
+				sum = r == 0 ? c : sum + c;
+			}
+			return sum / 6.0f;
+		}
+
+		void Sample2DScalar(const std::vector<Octave>& octaves, const float* x, const float* y, size_t count, float* out)
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				float acc = 0.0f;
+				for(const Octave& octave : octaves)
+				{
+					float wx[4], wy[4];
+					const uint32_t cellX = CellWeights(x[i] * octave.cellsPerPixel, wx);
+					const uint32_t cellY = CellWeights(y[i] * octave.cellsPerPixel, wy);
+					acc = acc + PlaneValue(octave.seedHash, cellX, cellY, octave.mask, wx, wy) * octave.scale;
+				}
+				out[i] = acc;
+			}
+		}
+
+		void Sample3DScalar(const std::vector<Octave>& octaves, const float* x, const float* y, const float* z, size_t count, float* out)
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				float acc = 0.0f;
+				for(const Octave& octave : octaves)
+				{
+					float wx[4], wy[4], wz[4];
+					const uint32_t cellX = CellWeights(x[i] * octave.cellsPerPixel, wx);
+					const uint32_t cellY = CellWeights(y[i] * octave.cellsPerPixel, wy);
+					const uint32_t cellZ = CellWeights(z[i] * octave.cellsPerPixel, wz);
+
+					float sum = 0.0f;
+					for(uint32_t s = 0; s < 4; s++)
+					{
+						const uint32_t planeHash = HashRandom::Permute(((cellZ + s - 1u) & octave.mask) ^ octave.seedHash);
+						const float c = PlaneValue(planeHash, cellX, cellY, octave.mask, wx, wy) * wz[s];
+						sum = s == 0 ? c : sum + c;
+					}
+					acc = acc + sum / 6.0f * octave.scale;
+				}
+				out[i] = acc;
+			}
+		}
+
+#if NG_SIMD_X86
+		/** HashRandom::Permute on eight lanes */
+		NG_TARGET_AVX2 inline __m256i Permute8(__m256i value)
+		{
+			const __m256i state = _mm256_add_epi32(_mm256_mullo_epi32(value, _mm256_set1_epi32(747796405)), _mm256_set1_epi32((int)2891336453u));
+			const __m256i shift = _mm256_add_epi32(_mm256_srli_epi32(state, 28), _mm256_set1_epi32(4));
+			const __m256i word = _mm256_mullo_epi32(_mm256_xor_si256(_mm256_srlv_epi32(state, shift), state), _mm256_set1_epi32(277803737));
+			return _mm256_xor_si256(_mm256_srli_epi32(word, 22), word);
+		}
+
+		/** HashRandom::ToFloat on eight lanes; the 24 bit values convert exactly */
+		NG_TARGET_AVX2 inline __m256 ToFloat8(__m256i bits)
+		{
+			return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+		}
+
+		/** CellWeights on eight lanes, same expressions as BSplineWeights */
+		NG_TARGET_AVX2 inline __m256i CellWeights8(__m256 p, __m256* w)
+		{
+			const __m256 cell = _mm256_floor_ps(p);
+			const __m256 xf = _mm256_sub_ps(p, cell);
+			const __m256 x2 = _mm256_mul_ps(xf, xf);
+			const __m256 x3 = _mm256_mul_ps(xf, x2);
+			const __m256 one = _mm256_set1_ps(1.0f);
+			const __m256 three = _mm256_set1_ps(3.0f);
+
+			w[0] = _mm256_sub_ps(_mm256_add_ps(_mm256_sub_ps(one, _mm256_mul_ps(three, xf)), _mm256_mul_ps(three, x2)), _mm256_mul_ps(one, x3));
+			w[1] = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(4.0f), _mm256_mul_ps(_mm256_set1_ps(6.0f), x2)), _mm256_mul_ps(three, x3));
+			w[2] = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(one, _mm256_mul_ps(three, xf)), _mm256_mul_ps(three, x2)), _mm256_mul_ps(three, x3));
+			w[3] = _mm256_mul_ps(one, x3);
+			return _mm256_cvttps_epi32(cell);
+		}
+
+		/** Lattice index cell + offset - 1, wrapped by mask */
+		NG_TARGET_AVX2 inline __m256i Tap8(__m256i cell, int offset, __m256i mask)
+		{
+			return _mm256_and_si256(_mm256_add_epi32(cell, _mm256_set1_epi32(offset - 1)), mask);
+		}
+
+		NG_TARGET_AVX2 __m256 PlaneValue8(__m256i planeHash, __m256i cellX, __m256i cellY, __m256i mask, const __m256* wx, const __m256* wy)
+		{
+			const __m256 six = _mm256_set1_ps(6.0f);
+
+			__m256i tapsX[4];
+			for(int k = 0; k < 4; k++)
+				tapsX[k] = Tap8(cellX, k, mask);
+
+			__m256 sum = _mm256_setzero_ps();
+			for(int r = 0; r < 4; r++)
+			{
+				const __m256i prefix = Permute8(_mm256_xor_si256(Tap8(cellY, r, mask), planeHash));
+
+				__m256 row = _mm256_mul_ps(ToFloat8(Permute8(_mm256_xor_si256(tapsX[0], prefix))), wx[0]);
+				for(int k = 1; k < 4; k++)
+					row = _mm256_add_ps(row, _mm256_mul_ps(ToFloat8(Permute8(_mm256_xor_si256(tapsX[k], prefix))), wx[k]));
+
+				const __m256 c = _mm256_mul_ps(_mm256_div_ps(row, six), wy[r]);
+				sum = r == 0 ? c : _mm256_add_ps(sum, c);
+			}
+			return _mm256_div_ps(sum, six);
+		}
+
+		/** Eight points per iteration, the remainder goes through the scalar path */
+		NG_TARGET_AVX2 size_t Sample2DAVX2(const std::vector<Octave>& octaves, const float* x, const float* y, size_t count, float* out)
+		{
+			size_t i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				const __m256 vx = _mm256_loadu_ps(x + i);
+				const __m256 vy = _mm256_loadu_ps(y + i);
+
+				__m256 acc = _mm256_setzero_ps();
+				for(const Octave& octave : octaves)
+				{
+					const __m256 cellsPerPixel = _mm256_set1_ps(octave.cellsPerPixel);
+					const __m256i mask = _mm256_set1_epi32((int)octave.mask);
+
+					__m256 wx[4], wy[4];
+					const __m256i cellX = CellWeights8(_mm256_mul_ps(vx, cellsPerPixel), wx);
+					const __m256i cellY = CellWeights8(_mm256_mul_ps(vy, cellsPerPixel), wy);
+
+					const __m256 value = PlaneValue8(_mm256_set1_epi32((int)octave.seedHash), cellX, cellY, mask, wx, wy);
+					acc = _mm256_add_ps(acc, _mm256_mul_ps(value, _mm256_set1_ps(octave.scale)));
+				}
+				_mm256_storeu_ps(out + i, acc);
+			}
+			return i;
+		}
+
+		NG_TARGET_AVX2 size_t Sample3DAVX2(const std::vector<Octave>& octaves, const float* x, const float* y, const float* z, size_t count, float* out)
+		{
+			const __m256 six = _mm256_set1_ps(6.0f);
+
+			size_t i = 0;
+			for(; i + 8 <= count; i += 8)
+			{
+				const __m256 vx = _mm256_loadu_ps(x + i);
+				const __m256 vy = _mm256_loadu_ps(y + i);
+				const __m256 vz = _mm256_loadu_ps(z + i);
+
+				__m256 acc = _mm256_setzero_ps();
+				for(const Octave& octave : octaves)
+				{
+					const __m256 cellsPerPixel = _mm256_set1_ps(octave.cellsPerPixel);
+					const __m256i mask = _mm256_set1_epi32((int)octave.mask);
+					const __m256i seedHash = _mm256_set1_epi32((int)octave.seedHash);
+
+					__m256 wx[4], wy[4], wz[4];
+					const __m256i cellX = CellWeights8(_mm256_mul_ps(vx, cellsPerPixel), wx);
+					const __m256i cellY = CellWeights8(_mm256_mul_ps(vy, cellsPerPixel), wy);
+					const __m256i cellZ = CellWeights8(_mm256_mul_ps(vz, cellsPerPixel), wz);
+
+					__m256 sum = _mm256_setzero_ps();
+					for(int s = 0; s < 4; s++)
+					{
+						const __m256i planeHash = Permute8(_mm256_xor_si256(Tap8(cellZ, s, mask), seedHash));
+						const __m256 c = _mm256_mul_ps(PlaneValue8(planeHash, cellX, cellY, mask, wx, wy), wz[s]);
+						sum = s == 0 ? c : _mm256_add_ps(sum, c);
+					}
+					acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_div_ps(sum, six), _mm256_set1_ps(octave.scale)));
+				}
+				_mm256_storeu_ps(out + i, acc);
+			}
+			return i;
+		}
+#endif
+	}
+
+	NoiseQuery::NoiseQuery(int res, const NoiseProperties& props)
+	{
+		if(res <= 0)
+		{
+			NGLOG(LogNoiseQuery, Error, "Invalid resolution in NoiseQuery");
+			throw std::invalid_argument("Resolution must be > 0");
+		}
+
+		// The points would silently differ from the warped map they are meant to match
+		if(props.turbulence != 0.0f)
+		{
+			NGLOG(LogNoiseQuery, Error, "NoiseQuery does not apply turbulence");
+			throw std::invalid_argument("NoiseQuery requires turbulence 0");
+		}
+
+		// Tiled cells wrap with the freq - 1 mask
+		if(props.domain == NoiseDomain::Tiled && !IsPowerOfTwo(res))
+		{
+			NGLOG(LogNoiseQuery, Error, "Tiled NoiseQuery resolution " + std::to_string(res) + " is not a power of two");
+			throw std::invalid_argument("Tiled NoiseQuery resolution must be a power of two");
+		}
+
+		marbling = props.marbling;
+
+		// Lattices are hashed per point, nothing is stored
+		const std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props);
+		amplitude = GetOctaveAmplitude(layers);
+
+		for(const OctaveLayer& layer : layers)
+		{
+			Octave octave;
+			octave.cellsPerPixel = (float)layer.freq / (float)res;
+			octave.seedHash = HashRandom::Permute(layer.seed);
+			octave.mask = layer.domain == NoiseDomain::Unbounded ? ~0u : (uint32_t)layer.freq - 1u;
+			octave.scale = layer.scale;
+			octaves.push_back(octave);
+		}
+	}
+
+	void NoiseQuery::Sample2D(const float* x, const float* y, size_t count, float* out) const
+	{
+		size_t done = 0;
+#if NG_SIMD_X86
+		if(GetSimdLevel() == SimdLevel::AVX2)
+			done = Sample2DAVX2(octaves, x, y, count, out);
+#endif
+		Sample2DScalar(octaves, x + done, y + done, count - done, out + done);
+		Finish(out, count);
+	}
+
+	void NoiseQuery::Sample3D(const float* x, const float* y, const float* z, size_t count, float* out) const
+	{
+		size_t done = 0;
+#if NG_SIMD_X86
+		if(GetSimdLevel() == SimdLevel::AVX2)
+			done = Sample3DAVX2(octaves, x, y, z, count, out);
+#endif
+		Sample3DScalar(octaves, x + done, y + done, z + done, count - done, out + done);
+		Finish(out, count);
+	}
+
+	void NoiseQuery::Finish(float* out, size_t count) const
+	{
+		// Same normalize and marbling as GenerateRegion; without octaves the noise is all zero
+		if(amplitude == 0.0f)
+		{
+			std::fill(out, out + count, 0.0f);
+			return;
+		}
+
+		for(size_t i = 0; i < count; i++)
+		{
+			float value = out[i] / amplitude;
+			if(marbling != 0.0f)
+				value = sinf(PI2 * value * marbling) * 0.5f + 0.5f;
+			out[i] = value;
+		}
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "NoiseTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NG
+{
+	/**
+	 * Point queries of FBM noise for runtime code (placement, collision heights, densities) that
+	 * needs values at scattered positions instead of whole images.
+	 *
+	 * Built once from res and props: the same octaves, roughness, frequency skips, seeds, domain and
+	 * marbling as FBMNoise2D, normalized by the octave amplitude sum like GenerateRegion. Coordinates
+	 * are pixels of that plane; at integer coordinates Sample2D returns exactly the GenerateRegion
+	 * pixel for power of two res. Turbulence is a warp of whole images and cannot be queried.
+	 *
+	 * Coordinates come as separate x / y (/ z) arrays. Points are evaluated eight at a time with AVX2
+	 * (lattice hashes included), other SimdLevels use the scalar path with identical results.
+	 * Sampling allocates nothing and is safe to call from any number of threads at once.
+	 * Cell indices must fit in 32 bits: |x| * 2^(octaves) / res below 2^31.
+	 */
+	class NoiseQuery
+	{
+	public:
+		/** Throws std::invalid_argument for res <= 0, turbulence != 0, or Tiled props with res not a power of two */
+		NoiseQuery(int res, const NoiseProperties& props);
+
+		/** out[i] = noise at (x[i], y[i]) for i < count */
+		void Sample2D(const float* x, const float* y, size_t count, float* out) const;
+
+		/**
+		 * Volumetric variant: the same octave stack over a 3D lattice, value (x, y, z) of an
+		 * octave is HashRandom::Float(seed, x, y, z) like StupidNoise3D.
+		 */
+		void Sample3D(const float* x, const float* y, const float* z, size_t count, float* out) const;
+
+		/** Enabled octaves after the frequency skips */
+		int GetOctaveCount() const { return (int)octaves.size(); }
+
+		/** One octave of the stack, as the sample kernels read it */
+		struct Octave
+		{
+			/** Lattice cells per pixel (freq / res) */
+			float cellsPerPixel = 0.0f;
+
+			/** Permute(seed), the first step of every lattice hash */
+			uint32_t seedHash = 0;
+
+			/** Cell index mask (freq - 1) for tiled lattices, all bits for unbounded ones */
+			uint32_t mask = 0;
+
+			float scale = 0.0f;
+		};
+
+	private:
+		/** Raw octave sums to normalized, marbled values */
+		void Finish(float* out, size_t count) const;
+
+		std::vector<Octave> octaves;
+		float amplitude = 0.0f;
+		float marbling = 0.0f;
+	};
+}
@@ -0,0 +1,321 @@
+#include "NoiseRegion.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Noise/NoiseStages.h"
+#include "Noise/OctaveKernel.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+namespace NG
+{
+	namespace
+	{
+		/** Source pixels of the turbulence warp are evaluated in tiles of this size, as they are sampled */
+		constexpr int SourceTileSize = 64;
+		constexpr size_t SourceTileArea = (size_t)SourceTileSize * SourceTileSize;
+
+		int64_t FloorMod(int64_t x, int64_t period)
+		{
+			const int64_t rest = x % period;
+			return rest < 0 ? rest + period : rest;
+		}
+
+		int64_t SourceTile(int64_t x)
+		{
+			return (x - FloorMod(x, SourceTileSize)) / SourceTileSize;
+		}
+
+		/**
+		 * Raw octave sums of the world rectangle [x0, x1) x [y0, y1). Tiled layers repeat every res
+		 * pixels, the rectangle is split at the period edges so the kernel only sees [0, res).
+		 */
+		void EvaluateWorld(const std::vector<OctaveLayer>& layers, int res, int64_t x0, int64_t y0, int64_t x1, int64_t y1, float* out, int stride)
+		{
+			if(layers.empty())
+			{
+				for(int64_t y = y0; y < y1; y++)
+					std::fill(out + (size_t)(y - y0) * stride, out + (size_t)(y - y0) * stride + (x1 - x0), 0.0f);
+				return;
+			}
+
+			if(layers.front().domain == NoiseDomain::Unbounded)
+			{
+				EvaluateOctaves2D(layers, res, x0, y0, x1, y1, out, stride);
+				return;
+			}
+
+			for(int64_t y = y0; y < y1; )
+			{
+				const int64_t py = FloorMod(y, res);
+				const int64_t rows = std::min<int64_t>(y1 - y, res - py);
+
+				for(int64_t x = x0; x < x1; )
+				{
+					const int64_t px = FloorMod(x, res);
+					const int64_t cols = std::min<int64_t>(x1 - x, res - px);
+					EvaluateOctaves2D(layers, res, px, py, px + cols, py + rows, out + (size_t)(y - y0) * stride + (x - x0), stride);
+					x += cols;
+				}
+
+				y += rows;
+			}
+		}
+
+		/** Fixed-range normalize and marbling of a raw octave sum; without octaves the noise is all zero */
+		float Finish(float value, float amplitude, float marbling)
+		{
+			if(amplitude == 0.0f)
+				return 0.0f;
+
+			value = value / amplitude;
+			if(marbling != 0.0f)
+				value = sinf(PI2 * value * marbling) * 0.5f + 0.5f;
+			return value;
+		}
+
+		/** Field cell, and position inside it, of every window column or row */
+		struct FieldAxis
+		{
+			TrackedVector<int64_t> cells;
+			TrackedVector<float> fractions;
+
+			void Build(int64_t first, int count, int fieldRes, int res)
+			{
+				cells.resize(count);
+				fractions.resize(count);
+				for(int i = 0; i < count; i++)
+					cells[i] = WorldLatticeCell(first + i, fieldRes, res, fractions[i]);
+			}
+		};
+
+		/** The cells of one turbulence field a window samples, normalized and marbled */
+		class TurbulenceField
+		{
+		public:
+			void Build(const NoiseProperties& props, int fieldRes, const FieldAxis& columns, const FieldAxis& rows)
+			{
+				u0 = columns.cells.front();
+				v0 = rows.cells.front();
+				width = (int)(columns.cells.back() + 2 - u0);
+				const int height = (int)(rows.cells.back() + 2 - v0);
+
+				const std::vector<OctaveLayer> layers = BuildOctaveStack(fieldRes, &props);
+				const float amplitude = GetOctaveAmplitude(layers);
+
+				values.resize((size_t)width * height);
+				EvaluateWorld(layers, fieldRes, u0, v0, u0 + width, v0 + height, values.data(), width);
+				for(float& value : values)
+					value = Finish(value, amplitude, props.marbling);
+			}
+
+			/** Bilinear sample at window pixel (column, row), the arithmetic of Sample2D */
+			float Sample(const FieldAxis& columns, const FieldAxis& rows, int column, int row) const
+			{
+				const float xf = columns.fractions[column];
+				const float yf = rows.fractions[row];
+
+				const float* row0 = values.data() + (size_t)(rows.cells[row] - v0) * width + (columns.cells[column] - u0);
+				const float* row1 = row0 + width;
+
+				const float d1 = row0[0] * (1.0f - xf) + row0[1] * xf;
+				const float d2 = row1[0] * (1.0f - xf) + row1[1] * xf;
+
+				return d1 * (1.0f - yf) + d2 * yf;
+			}
+
+		private:
+			int64_t u0 = 0;
+			int64_t v0 = 0;
+			int width = 0;
+			TrackedVector<float> values;
+		};
+	}
+
+	bool GenerateRegion(int res, const NoiseProperties* props, int64_t x0, int64_t y0, int width, int height,
+		float* out, int outStride, const NoiseExecution& exec, std::function<bool(float)> onProgress)
+	{
+		if(!props) return false;
+		if(width == 0 || height == 0) return true;
+		if(!out || res <= 0 || width < 0 || height < 0 || outStride < width)
+		{
+			throw std::invalid_argument("Invalid region");
+		}
+
+		NG_PROFILE_STAGE("GenerateRegion", (int64_t)width * height);
+		NG_PROFILE_COUNTER("GenerateRegion calls", 1);
+
+		// Nothing is stored per octave, a window only needs the lattice rows around it
+		const std::vector<OctaveLayer> layers = BuildOctaveStack(res, props);
+		const float amplitude = GetOctaveAmplitude(layers);
+		const float marbling = props->marbling;
+
+		if(props->turbulence == 0.0f)
+		{
+			return ParallelForRows(height, exec, [&] (int begin, int end)
+				{
+					EvaluateWorld(layers, res, x0, y0 + begin, x0 + width, y0 + end, out + (size_t)begin * outStride, outStride);
+					for(int row = begin; row < end; row++)
+					{
+						float* values = out + (size_t)row * outStride;
+						for(int i = 0; i < width; i++)
+							values[i] = Finish(values[i], amplitude, marbling);
+					}
+				}, onProgress);
+		}
+
+		// === Turbulence fields ===
+		// Same properties and seeds as the FBMNoise2D fields, but only the cells under the window
+		const int fieldRes = 8 << props->turbulence_res;
+		const float turbulenceExp = powf(2.0f, props->turbulence_expshift);
+
+		NoiseProperties fieldProps = MakeTurbulenceProperties(*props);
+
+		FieldAxis columns, rows;
+		columns.Build(x0, width, fieldRes, res);
+		rows.Build(y0, height, fieldRes, res);
+
+		TurbulenceField fieldX, fieldY;
+		fieldProps.seed = props->seed + 100;
+		fieldX.Build(fieldProps, fieldRes, columns, rows);
+		fieldProps.seed = props->seed + 200;
+		fieldY.Build(fieldProps, fieldRes, columns, rows);
+
+		// === Warp targets ===
+		// Source pixel and position inside it for every window pixel. The displacement is the
+		// FBMNoise2D one in pixels; targets are kept in world coordinates, far from the origin too
+		const size_t pixels = (size_t)width * height;
+		TrackedVector<int64_t> sourceX(pixels), sourceY(pixels);
+		TrackedVector<float> fractionX(pixels), fractionY(pixels);
+
+		ParallelForRows(height, exec, [&] (int begin, int end)
+			{
+				for(int row = begin; row < end; row++)
+				{
+					for(int column = 0; column < width; column++)
+					{
+						float x = fieldX.Sample(columns, rows, column, row) * 2.0f - 1.0f;
+						float y = fieldY.Sample(columns, rows, column, row) * 2.0f - 1.0f;
+
+						if(turbulenceExp != 1.0f) {
+							x = powf(fabsf(x), turbulenceExp) * (x >= 0.0f ? 1.0f : -1.0f);
+							y = powf(fabsf(y), turbulenceExp) * (y >= 0.0f ? 1.0f : -1.0f);
+						}
+
+						x += props->turbulence_offset_x;
+						y += props->turbulence_offset_y;
+
+						const double targetX = (double)(x0 + column) + (double)(x * props->turbulence / 64.0f * res);
+						const double targetY = (double)(y0 + row) + (double)(y * props->turbulence / 64.0f * res);
+
+						const size_t k = (size_t)row * width + column;
+						sourceX[k] = (int64_t)floor(targetX);
+						sourceY[k] = (int64_t)floor(targetY);
+						fractionX[k] = (float)(targetX - (double)sourceX[k]);
+						fractionY[k] = (float)(targetY - (double)sourceY[k]);
+					}
+				}
+			});
+
+		// === Source tiles ===
+		// Only the tiles some target samples are evaluated, indexed densely over their bounding box
+		const auto [minX, maxX] = std::minmax_element(sourceX.begin(), sourceX.end());
+		const auto [minY, maxY] = std::minmax_element(sourceY.begin(), sourceY.end());
+		const int64_t tileX0 = SourceTile(*minX), tileY0 = SourceTile(*minY);
+		const int64_t tilesX = SourceTile(*maxX + 1) - tileX0 + 1;
+		const int64_t tilesY = SourceTile(*maxY + 1) - tileY0 + 1;
+
+		TrackedVector<int> tileSlots((size_t)(tilesX * tilesY), -1);
+		auto slotOf = [&] (int64_t x, int64_t y) -> int&
+			{
+				return tileSlots[(size_t)((SourceTile(y) - tileY0) * tilesX + (SourceTile(x) - tileX0))];
+			};
+
+		for(size_t k = 0; k < pixels; k++)
+		{
+			slotOf(sourceX[k], sourceY[k]) = 0;
+			slotOf(sourceX[k] + 1, sourceY[k]) = 0;
+			slotOf(sourceX[k], sourceY[k] + 1) = 0;
+			slotOf(sourceX[k] + 1, sourceY[k] + 1) = 0;
+		}
+
+		std::vector<int64_t> tiles;
+		for(size_t slot = 0; slot < tileSlots.size(); slot++)
+		{
+			if(tileSlots[slot] == 0)
+			{
+				tileSlots[slot] = (int)tiles.size();
+				tiles.push_back((int64_t)slot);
+			}
+		}
+
+		TrackedVector<float> tileValues(tiles.size() * SourceTileArea);
+		const bool bCompleted = ParallelForRows((int)tiles.size(), exec, [&] (int begin, int end)
+			{
+				for(int t = begin; t < end; t++)
+				{
+					const int64_t tx = (tileX0 + tiles[t] % tilesX) * SourceTileSize;
+					const int64_t ty = (tileY0 + tiles[t] / tilesX) * SourceTileSize;
+					EvaluateWorld(layers, res, tx, ty, tx + SourceTileSize, ty + SourceTileSize,
+						tileValues.data() + (size_t)t * SourceTileArea, SourceTileSize);
+				}
+			}, onProgress);
+
+		if(!bCompleted)
+			return false;
+
+		// === Warp + Normalize + Marbling ===
+		auto source = [&] (int64_t x, int64_t y)
+			{
+				const int slot = slotOf(x, y);
+				return tileValues[(size_t)slot * SourceTileArea + (size_t)FloorMod(y, SourceTileSize) * SourceTileSize + (size_t)FloorMod(x, SourceTileSize)];
+			};
+
+		ParallelForRows(height, exec, [&] (int begin, int end)
+			{
+				for(int row = begin; row < end; row++)
+				{
+					for(int column = 0; column < width; column++)
+					{
+						const size_t k = (size_t)row * width + column;
+						const int64_t xi = sourceX[k], yi = sourceY[k];
+						const float xf = fractionX[k], yf = fractionY[k];
+
+						const float d1 = source(xi, yi) * (1.0f - xf) + source(xi + 1, yi) * xf;
+						const float d2 = source(xi, yi + 1) * (1.0f - xf) + source(xi + 1, yi + 1) * xf;
+
+						out[(size_t)row * outStride + column] = Finish(d1 * (1.0f - yf) + d2 * yf, amplitude, marbling);
+					}
+				}
+			});
+
+		return true;
+	}
+
+	uint64_t EstimateRegionBytes(int res, const NoiseProperties* props, int width, int height)
+	{
+		if(!props || res <= 0 || width <= 0 || height <= 0 || props->turbulence == 0.0f) return 0;
+
+		// Warp targets and both fields
+		const uint64_t pixels = (uint64_t)width * height;
+		const uint64_t targets = pixels * (2 * sizeof(int64_t) + 2 * sizeof(float));
+
+		// The field values are in [-1, 1] before the offset, so the targets spread over the window
+		// plus twice the largest displacement. Their bounding box is indexed densely, and at most
+		// four tiles per pixel of it are evaluated
+		const double spread = 2.0 * fabs((double)props->turbulence) / 64.0 * res;
+		const uint64_t spanX = (uint64_t)width + (uint64_t)ceil(spread) + 2;
+		const uint64_t spanY = (uint64_t)height + (uint64_t)ceil(spread) + 2;
+		const uint64_t boxTiles = (spanX / SourceTileSize + 2) * (spanY / SourceTileSize + 2);
+		const uint64_t usedTiles = std::min(boxTiles, 4 * pixels);
+		const uint64_t tiles = boxTiles * sizeof(int) + usedTiles * (sizeof(int64_t) + SourceTileArea * sizeof(float));
+
+		const int fieldRes = 8 << props->turbulence_res;
+		const uint64_t fieldWidth = (uint64_t)width * fieldRes / res + 3;
+		const uint64_t fieldHeight = (uint64_t)height * fieldRes / res + 3;
+		return targets + tiles + 2 * sizeof(float) * fieldWidth * fieldHeight;
+	}
+}
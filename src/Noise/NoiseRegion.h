@@ -0,0 +1,34 @@
+#pragma once
+
+#include "NoiseTypes.h"
+#include <cstdint>
+#include <functional>
+
+namespace NG
+{
+	/**
+	 * Evaluates the FBM pipeline (octaves, turbulence warp, normalize, marbling) for the pixel window
+	 * [x0, x0 + width) x [y0, y0 + height) of the noise plane and writes it to caller memory.
+	 * res sets the scale like the image size of FBMNoise2D does; the window may lie anywhere.
+	 *
+	 * Every pixel only depends on its world coordinates, so windows evaluated separately (on any
+	 * thread, in any order) join bit for bit, and FBMNoise2D with an Unbounded domain equals the
+	 * window (0, 0, res, res). Values are always normalized by the octave amplitude sum; Tiled props
+	 * repeat every res pixels, but are not stretched to [0, 1] like the FBMNoise2D image is.
+	 *
+	 * The turbulence warp samples the source noise wherever the displacement points to, also outside
+	 * the window: source pixels are evaluated in 64 x 64 tiles, only for the tiles actually sampled.
+	 * Scratch memory is about 28 bytes per window pixel with turbulence, and a few lattice rows without.
+	 * Pass a serial exec (the default) when many windows are generated concurrently.
+	 *
+	 * @param out			Destination of pixel (x0, y0)
+	 * @param outStride		Distance in floats between two rows of out
+	 * @param onProgress	Completed fraction, returning false cancels
+	 * @return false if canceled by onProgress; out is then partially written
+	 */
+	bool GenerateRegion(int res, const NoiseProperties* props, int64_t x0, int64_t y0, int width, int height,
+		float* out, int outStride, const NoiseExecution& exec = {}, std::function<bool(float)> onProgress = nullptr);
+
+	/** Estimated scratch memory of one GenerateRegion call, out excluded */
+	uint64_t EstimateRegionBytes(int res, const NoiseProperties* props, int width, int height);
+}
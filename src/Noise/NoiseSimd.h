@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * Internal to the noise kernel sources: x86 intrinsics and the attributes of the functions built
+ * for AVX2 while the rest of the build targets the baseline (SimdLevel picks them at runtime).
+ */
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NG_SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define NG_TARGET_AVX2
+#define NG_TARGET_AVX2_F16C
+#else
+// Only AVX2 is enabled (not FMA): contracted multiply-adds would round differently from the scalar path
+#define NG_TARGET_AVX2 __attribute__((target("avx2")))
+#define NG_TARGET_AVX2_F16C __attribute__((target("avx2,f16c")))
+#endif
+#endif
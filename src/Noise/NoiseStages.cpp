@@ -0,0 +1,171 @@
+#include "NoiseStages.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Noise/OctaveKernel.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/MemoryTracker.h"
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+DEFINE_LOG_CATEGORY(LogNoiseStages);
+
+namespace NG
+{
+	NoiseProperties MakeTurbulenceProperties(const NoiseProperties& props)
+	{
+		NoiseProperties turbulence = props;
+		turbulence.turbulence = 0.0f;
+		turbulence.roughness = props.turbulence_roughness;
+		turbulence.low_freq_skip = props.turbulence_low_freq_skip;
+		turbulence.high_freq_skip = props.turbulence_high_freq_skip;
+		turbulence.marbling = props.turbulence_marbling;
+		return turbulence;
+	}
+
+	NoiseImage SumOctaves2D(int res, const NoiseProperties& props, const NoiseExecution& exec,
+		const std::function<bool(float)>& onProgress, bool& outHasOctaves)
+	{
+		// All enabled octaves are summed per tile by the fused kernel, each pixel is written once.
+		// Lattice rows are hashed per tile band instead of stored: the stored lattices would add 4/3
+		// of the image (the finest one alone is as large) for no measurable speedup
+		std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props, exec);
+		outHasOctaves = !layers.empty();
+
+		if(layers.empty())
+		{
+			if(onProgress && !onProgress(1.0f)) return {};
+
+			NoiseImage data(res, res, 1, true);
+			if(!data)
+			{
+				NGLOG(LogNoiseStages, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
+			}
+			return data;
+		}
+
+		NoiseImage data(res, res);
+		if(!data)
+		{
+			NGLOG(LogNoiseStages, Error, "Out of memory");
+			throw std::runtime_error("Out of memory");
+		}
+
+		const bool bCompleted = ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				EvaluateOctaves2D(layers, res, 0, begin, res, end, data.Data() + begin * res, res);
+			}, onProgress);
+
+		if(!bCompleted)
+			return {};
+		return data;
+	}
+
+	bool GenerateTurbulenceFields(const NoiseProperties& props, const NoiseExecution& exec, NoiseImage& outDx, NoiseImage& outDy)
+	{
+		NoiseProperties prop = MakeTurbulenceProperties(props);
+		const int turbulence_res = 8 << props.turbulence_res;
+
+		prop.seed = props.seed + 100;
+		outDx = FBMNoise2D(turbulence_res, &prop, [] (float) { return true; }, exec);
+		prop.seed = props.seed + 200;
+		outDy = FBMNoise2D(turbulence_res, &prop, [] (float) { return true; }, exec);
+
+		if(!outDx || !outDy)
+		{
+			NGLOG(LogNoiseStages, Error, "Turbulence sub-pass canceled or failed");
+			return false;
+		}
+		return true;
+	}
+
+	bool WarpImage(int res, const float* source, float* out, const NoiseImage& dx, const NoiseImage& dy,
+		const NoiseProperties& props, const NoiseExecution& exec, const std::function<bool(float)>& onProgress)
+	{
+		const int turbulence_res = dx.GetWidth();
+		const float turbulence_exp = powf(2.0f, props.turbulence_expshift);
+
+		return ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				for(int j = begin; j < end; j++)
+				{
+					for(int i = 0; i < res; i++)
+					{
+						float x = Sample2D(dx.Data(), turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+						float y = Sample2D(dy.Data(), turbulence_res, turbulence_res, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+
+						if(turbulence_exp != 1.0f) {
+							x = powf(fabsf(x), turbulence_exp) * (x >= 0.0f ? 1.0f : -1.0f);
+							y = powf(fabsf(y), turbulence_exp) * (y >= 0.0f ? 1.0f : -1.0f);
+						}
+
+						x += props.turbulence_offset_x;
+						y += props.turbulence_offset_y;
+
+						x = x * props.turbulence / 64.0f + (float)i / res;
+						y = y * props.turbulence / 64.0f + (float)j / res;
+
+						out[i + j * res] = Sample2D(source, res, res, x, y);
+					}
+				}
+			}, onProgress);
+	}
+
+	void MeasureRange(int res, const float* data, const NoiseExecution& exec, float& outMin, float& outMax)
+	{
+		// Per-row extrema are merged in row order, which picks the same values as a single serial scan
+		TrackedVector<float> rowMin(res), rowMax(res);
+		ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				for(int j = begin; j < end; j++)
+				{
+					const float* row = data + j * res;
+					float min_v = row[0], max_v = row[0];
+					for(int i = 1; i < res; i++)
+					{
+						if(row[i] < min_v) min_v = row[i];
+						if(row[i] > max_v) max_v = row[i];
+					}
+					rowMin[j] = min_v;
+					rowMax[j] = max_v;
+				}
+			});
+
+		float min_v = rowMin[0], max_v = rowMax[0];
+		for(int j = 1; j < res; j++)
+		{
+			if(rowMin[j] < min_v) min_v = rowMin[j];
+			if(rowMax[j] > max_v) max_v = rowMax[j];
+		}
+
+		outMin = min_v;
+		outMax = max_v;
+	}
+
+	void NormalizeImage(int res, const float* in, float* out, float min_v, float max_v, const NoiseExecution& exec)
+	{
+		ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				for(size_t i = (size_t)begin * res; i < (size_t)end * res; i++)
+				{
+					out[i] = (in[i] - min_v) / (max_v - min_v);
+				}
+			});
+	}
+
+	void MarbleImage(int res, float* data, float marbling, const NoiseExecution& exec)
+	{
+		if(marbling == 0.0f)
+			return;
+
+		ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				for(size_t i = (size_t)begin * res; i < (size_t)end * res; i++)
+				{
+					data[i] = sinf(PI2 * data[i] * marbling) * 0.5f + 0.5f;
+				}
+			});
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "NoiseImage.h"
+#include "NoiseTypes.h"
+#include <functional>
+
+namespace NG
+{
+	/**
+	 * The passes of FBMNoise2D (Tiled domain) as separate steps, shared by the one-shot generator
+	 * and the cached NoisePipeline so both produce the same values bit for bit.
+	 * Images are res x res, row-major. Profiling stages are opened by the callers.
+	 * onProgress receives the completed fraction of the step, returning false cancels it.
+	 */
+
+	/** Properties of the dx / dy fields a turbulence pass warps the image with */
+	NoiseProperties MakeTurbulenceProperties(const NoiseProperties& props);
+
+	/**
+	 * Raw sum of the enabled octaves of props. Without enabled octaves the image is zero filled
+	 * and outHasOctaves false; FBMNoise2D then returns it as is. Empty if canceled.
+	 */
+	NoiseImage SumOctaves2D(int res, const NoiseProperties& props, const NoiseExecution& exec,
+		const std::function<bool(float)>& onProgress, bool& outHasOctaves);
+
+	/** dx / dy fields of the turbulence pass, 8 << props.turbulence_res wide; false if one failed */
+	bool GenerateTurbulenceFields(const NoiseProperties& props, const NoiseExecution& exec, NoiseImage& outDx, NoiseImage& outDy);
+
+	/**
+	 * Displaces source by the turbulence fields into out, which must not overlap source.
+	 * Returns false if canceled; out is then partially written.
+	 */
+	bool WarpImage(int res, const float* source, float* out, const NoiseImage& dx, const NoiseImage& dy,
+		const NoiseProperties& props, const NoiseExecution& exec, const std::function<bool(float)>& onProgress);
+
+	/** Smallest and largest value of data, in the order a serial scan finds them */
+	void MeasureRange(int res, const float* data, const NoiseExecution& exec, float& outMin, float& outMax);
+
+	/** out = (in - min) / (max - min); in and out may be the same image */
+	void NormalizeImage(int res, const float* in, float* out, float min, float max, const NoiseExecution& exec);
+
+	/** data = sin(2 pi data marbling) / 2 + 1/2 in place, nothing for marbling 0 */
+	void MarbleImage(int res, float* data, float marbling, const NoiseExecution& exec);
+}
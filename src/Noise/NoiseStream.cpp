@@ -0,0 +1,416 @@
+#include "NoiseStream.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Noise/NoiseRegion.h"
+#include "Noise/NoiseStages.h"
+#include "Noise/OctaveKernel.h"
+#include "Logger/Logger.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+DEFINE_LOG_CATEGORY(LogNoiseStream);
+
+namespace NG
+{
+	namespace
+	{
+		/** Most source blocks of the turbulence warp kept between strips */
+		constexpr int SourceWindowMaxBlocks = 4;
+
+		/** Source rows of the turbulence warp are evaluated in blocks of two strips, 16 rows at least */
+		int GetSourceBlockRows(int stripRows)
+		{
+			return std::max(16, stripRows * 2);
+		}
+
+		/**
+		 * Source blocks kept between strips: all the blocks one strip warps to when they fit in
+		 * SourceWindowMaxBlocks, so consecutive strips evaluate each source row once. The field
+		 * values are in [-1, 1] before the offset, which moves the targets without spreading them.
+		 */
+		int GetSourceWindowBlocks(int res, int stripRows, const NoiseProperties* props)
+		{
+			const int blockRows = GetSourceBlockRows(stripRows);
+			const double reach = stripRows + 2.0 * fabs((double)props->turbulence) / 64.0 * res;
+			const double blocks = std::min(ceil(reach / blockRows) + 1.0, ceil((double)res / blockRows));
+			return (int)std::clamp(blocks, 1.0, (double)SourceWindowMaxBlocks);
+		}
+
+		/** Peak memory of FBMNoise2DStream: strip buffers and, with turbulence, its fields and warp buffers */
+		uint64_t EstimateStreamBytes(int res, int stripRows, const NoiseProperties* props)
+		{
+			const uint64_t stripBytes = sizeof(float) * (uint64_t)stripRows * res;
+			if(props->domain == NoiseDomain::Unbounded)
+				return stripBytes + EstimateRegionBytes(res, props, res, stripRows);
+			if(props->turbulence == 0.0f)
+				return stripBytes;
+
+			const NoiseProperties prop = MakeTurbulenceProperties(*props);
+
+			const int turbulenceRes = 8 << props->turbulence_res;
+			const uint64_t field = BufferPool::GetBucketBytes(sizeof(float) * (size_t)turbulenceRes * turbulenceRes);
+			const uint64_t blockBytes = sizeof(float) * ((uint64_t)GetSourceBlockRows(stripRows) + 1) * res;
+			const uint64_t windowBytes = blockBytes * GetSourceWindowBlocks(res, stripRows, props);
+
+			// Strip, warp targets (x, y), source window and first row next to both fields
+			const uint64_t render = 3 * stripBytes + windowBytes + sizeof(float) * (uint64_t)res + 2 * field;
+			return std::max(render, stripBytes + field + EstimateFBMNoise2DBytes(turbulenceRes, &prop));
+		}
+
+		/**
+		 * Same arithmetic as Sample2D (clamped coordinates, wrapped +1 neighbours), with pixels
+		 * fetched through pixel(x, y) and int sized images.
+		 */
+		template<typename PixelFn>
+		float SampleBilinear(int res, float x, float y, const PixelFn& pixel)
+		{
+			x = std::clamp(x, 0.0f, 0.999f);
+			y = std::clamp(y, 0.0f, 0.999f);
+
+			const int xi = static_cast<int>(x * res);
+			const int yi = static_cast<int>(y * res);
+
+			const float xf = x * res - xi;
+			const float yf = y * res - yi;
+
+			const int xn = (xi + 1) % res;
+			const int yn = (yi + 1) % res;
+
+			const float d1 = pixel(xi, yi) * (1.0f - xf) + pixel(xn, yi) * xf;
+			const float d2 = pixel(xi, yn) * (1.0f - xf) + pixel(xn, yn) * xf;
+
+			return d1 * (1.0f - yf) + d2 * yf;
+		}
+
+		/** Produces raw (warped, not normalized) FBM rows of a res x res image on demand */
+		class StripRenderer
+		{
+		public:
+			StripRenderer(int res, int stripRows, const NoiseProperties* props, const NoiseExecution& exec, const std::vector<OctaveLayer>& layers)
+				: res(res), props(props), exec(exec), layers(layers)
+				, blockRows(GetSourceBlockRows(stripRows))
+			{
+				if(props->turbulence != 0.0f)
+					window.resize(GetSourceWindowBlocks(res, stripRows, props));
+			}
+
+			/** Generates the turbulence maps. Returns false if a sub-pass failed */
+			bool Prepare()
+			{
+				if(props->turbulence == 0.0f)
+					return true;
+
+				NoiseProperties prop = MakeTurbulenceProperties(*props);
+
+				turbulenceRes = 8 << props->turbulence_res;
+				turbulenceExp = powf(2.0f, props->turbulence_expshift);
+
+				prop.seed = props->seed + 100;
+				dx = FBMNoise2D(turbulenceRes, &prop, [] (float) { return true; }, exec);
+				prop.seed = props->seed + 200;
+				dy = FBMNoise2D(turbulenceRes, &prop, [] (float) { return true; }, exec);
+
+				if(!dx || !dy)
+				{
+					NGLOG(LogNoiseStream, Error, "Turbulence sub-pass canceled or failed");
+					return false;
+				}
+
+				// Warps near the bottom edge wrap to the first row, keep it around
+				firstRow.resize(res);
+				EvaluateOctaves2D(layers, res, 0, 0, res, 1, firstRow.data(), res);
+				return true;
+			}
+
+			void Render(int y0, int rows, float* strip)
+			{
+				if(!dx)
+				{
+					EvaluateRows(y0, rows, strip);
+					return;
+				}
+
+				const size_t pixels = (size_t)rows * res;
+				targetX.resize(pixels);
+				targetY.resize(pixels);
+				rowLow.resize(rows);
+				rowHigh.resize(rows);
+
+				// Warp targets, the same expressions as the FBMNoise2D turbulence pass
+				ParallelForRows(rows, exec, [&] (int begin, int end)
+					{
+						for(int row = begin; row < end; row++)
+						{
+							const int j = y0 + row;
+							int low = res, high = 0;
+
+							for(int i = 0; i < res; i++)
+							{
+								float x = Sample2D(dx.Data(), turbulenceRes, turbulenceRes, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+								float y = Sample2D(dy.Data(), turbulenceRes, turbulenceRes, (float)i / res, (float)j / res) * 2.0f - 1.0f;
+
+								if(turbulenceExp != 1.0f) {
+									x = powf(fabsf(x), turbulenceExp) * (x >= 0.0f ? 1.0f : -1.0f);
+									y = powf(fabsf(y), turbulenceExp) * (y >= 0.0f ? 1.0f : -1.0f);
+								}
+
+								x += props->turbulence_offset_x;
+								y += props->turbulence_offset_y;
+
+								x = x * props->turbulence / 64.0f + (float)i / res;
+								y = y * props->turbulence / 64.0f + (float)j / res;
+
+								const size_t k = (size_t)row * res + i;
+								targetX[k] = x;
+								targetY[k] = y;
+
+								const int yi = SourceRow(y);
+								low = std::min(low, yi);
+								high = std::max(high, yi);
+							}
+
+							rowLow[row] = low;
+							rowHigh[row] = high;
+						}
+					});
+
+				const int firstBlock = *std::min_element(rowLow.begin(), rowLow.end()) / blockRows;
+				const int lastBlock = *std::max_element(rowHigh.begin(), rowHigh.end()) / blockRows;
+
+				// Blocks the previous strips left in the window are sampled before any is evicted
+				std::vector<int> order;
+				for(int block = firstBlock; block <= lastBlock; block++)
+					if(FindBlock(block)) order.push_back(block);
+				for(int block = firstBlock; block <= lastBlock; block++)
+					if(!FindBlock(block)) order.push_back(block);
+
+				// Every pixel is sampled by the block holding its upper tap row, the lower one is
+				// either in the block too or the first row
+				for(int block : order)
+				{
+					const TrackedVector<float>& source = LoadBlock(block, firstBlock, lastBlock);
+					const int blockBegin = block * blockRows;
+					const int blockEnd = blockBegin + blockRows;
+
+					auto pixel = [&] (int x, int y)
+						{
+							return y < blockBegin ? firstRow[x] : source[(size_t)(y - blockBegin) * res + x];
+						};
+
+					ParallelForRows(rows, exec, [&] (int begin, int end)
+						{
+							for(size_t k = (size_t)begin * res; k < (size_t)end * res; k++)
+							{
+								const int yi = SourceRow(targetY[k]);
+								if(yi >= blockBegin && yi < blockEnd)
+									strip[k] = SampleBilinear(res, targetX[k], targetY[k], pixel);
+							}
+						});
+				}
+			}
+
+		private:
+			int SourceRow(float y) const
+			{
+				return static_cast<int>(std::clamp(y, 0.0f, 0.999f) * res);
+			}
+
+			/** Source rows [block * blockRows, +blockRows] of the window, the next block's first row included */
+			struct SourceBlock
+			{
+				int block = -1;
+				TrackedVector<float> rows;
+			};
+
+			const SourceBlock* FindBlock(int block) const
+			{
+				for(const SourceBlock& entry : window)
+					if(entry.block == block) return &entry;
+				return nullptr;
+			}
+
+			/**
+			 * Returns the rows of block, evaluating them if the window does not hold them. A block the
+			 * strip does not need (in [firstBlock, lastBlock]) is evicted first, then the topmost one:
+			 * strips move down the image
+			 */
+			const TrackedVector<float>& LoadBlock(int block, int firstBlock, int lastBlock)
+			{
+				if(const SourceBlock* entry = FindBlock(block))
+					return entry->rows;
+
+				auto isNeeded = [&] (const SourceBlock& entry)
+					{
+						return entry.block >= firstBlock && entry.block <= lastBlock;
+					};
+
+				SourceBlock* slot = &window[0];
+				for(SourceBlock& entry : window)
+				{
+					if(isNeeded(entry) != isNeeded(*slot) ? !isNeeded(entry) : entry.block < slot->block)
+						slot = &entry;
+				}
+
+				const int first = block * blockRows;
+				const int count = std::min(first + blockRows, res - 1) - first + 1;
+				slot->block = block;
+				slot->rows.resize((size_t)count * res);
+				EvaluateRows(first, count, slot->rows.data());
+				return slot->rows;
+			}
+
+			void EvaluateRows(int y0, int rows, float* out)
+			{
+				ParallelForRows(rows, exec, [&] (int begin, int end)
+					{
+						EvaluateOctaves2D(layers, res, 0, y0 + begin, res, y0 + end, out + (size_t)begin * res, res);
+					});
+			}
+
+			const int res;
+			const NoiseProperties* props;
+			const NoiseExecution exec;
+			const std::vector<OctaveLayer>& layers;
+			const int blockRows;
+
+			int turbulenceRes = 0;
+			float turbulenceExp = 1.0f;
+			NoiseImage dx;
+			NoiseImage dy;
+
+			TrackedVector<float> firstRow;
+			std::vector<SourceBlock> window;
+			TrackedVector<float> targetX;
+			TrackedVector<float> targetY;
+			TrackedVector<int> rowLow;
+			TrackedVector<int> rowHigh;
+		};
+	}
+
+	bool FBMNoise2DStream(int res, const NoiseProperties* props, const NoiseStreamOptions& options,
+		const NoiseStripSink& sink, std::function<bool(float)> onProgress)
+	{
+		if(!props || !sink) return false;
+		if(res <= 0)
+		{
+			throw std::invalid_argument("Resolution must be positive");
+		}
+
+		NG_PROFILE_STAGE("FBMNoise2DStream", (int64_t)res * res);
+
+		const int stripRows = std::clamp(options.stripRows, 1, res);
+		MemoryJobScope memoryJob("FBMNoise2DStream", EstimateStreamBytes(res, stripRows, props));
+
+		TrackedVector<float> strip((size_t)stripRows * res);
+
+		// Unbounded noise has a fixed range, every strip is simply a window of the world plane
+		if(props->domain == NoiseDomain::Unbounded)
+		{
+			for(int y0 = 0; y0 < res; y0 += stripRows)
+			{
+				const int rows = std::min(stripRows, res - y0);
+				if(!GenerateRegion(res, props, 0, y0, res, rows, strip.data(), res, options.exec)) return false;
+				if(!sink(y0, rows, res, strip.data())) return false;
+				if(onProgress && !onProgress((float)(y0 + rows) / res)) return false;
+			}
+			return true;
+		}
+
+		// Nothing is stored per octave, the finest lattice alone would be as large as the image
+		std::vector<OctaveLayer> layers = BuildOctaveStack(res, props, options.exec);
+
+		if(layers.empty())
+		{
+			// FBMNoise2D returns an all-zero image in this case
+			for(int y0 = 0; y0 < res; y0 += stripRows)
+			{
+				const int rows = std::min(stripRows, res - y0);
+				if(!sink(y0, rows, res, strip.data())) return false;
+				if(onProgress && !onProgress((float)(y0 + rows) / res)) return false;
+			}
+			return true;
+		}
+
+		StripRenderer renderer(res, stripRows, props, options.exec, layers);
+		if(!renderer.Prepare())
+			return false;
+
+		const int passes = options.bKnownRange ? 1 : 2;
+		auto report = [&] (int pass, int rowsDone)
+			{
+				return !onProgress || onProgress((pass + (float)rowsDone / res) / passes);
+			};
+
+		// === Range pass ===
+		float min_v = options.rangeMin, max_v = options.rangeMax;
+		if(!options.bKnownRange)
+		{
+			min_v = max_v = 0.0f;
+			for(int y0 = 0; y0 < res; y0 += stripRows)
+			{
+				const int rows = std::min(stripRows, res - y0);
+				renderer.Render(y0, rows, strip.data());
+
+				const auto [lo, hi] = std::minmax_element(strip.begin(), strip.begin() + (size_t)rows * res);
+				if(y0 == 0 || *lo < min_v) min_v = *lo;
+				if(y0 == 0 || *hi > max_v) max_v = *hi;
+
+				if(!report(0, y0 + rows)) return false;
+			}
+		}
+
+		// === Output pass: Normalize + Marbling ===
+		const float marbling = props->marbling;
+		for(int y0 = 0; y0 < res; y0 += stripRows)
+		{
+			const int rows = std::min(stripRows, res - y0);
+			renderer.Render(y0, rows, strip.data());
+
+			ParallelForRows(rows, options.exec, [&] (int begin, int end)
+				{
+					for(size_t i = (size_t)begin * res; i < (size_t)end * res; i++)
+					{
+						strip[i] = (strip[i] - min_v) / (max_v - min_v);
+					}
+
+					if(marbling != 0.0f)
+					{
+						for(size_t i = (size_t)begin * res; i < (size_t)end * res; i++)
+						{
+							strip[i] = sinf(PI2 * strip[i] * marbling) * 0.5f + 0.5f;
+						}
+					}
+				});
+
+			if(!sink(y0, rows, res, strip.data())) return false;
+			if(!report(passes - 1, y0 + rows)) return false;
+		}
+
+		return true;
+	}
+
+	NoiseStripSink MakeRawFileSink(const std::string& path)
+	{
+		auto file = std::make_shared<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+		if(!file->is_open())
+		{
+			NGLOG(LogNoiseStream, Error, "Failed to create " + path);
+			throw std::runtime_error("Failed to create " + path);
+		}
+
+		return [file] (int, int rows, int width, const float* strip)
+			{
+				file->write(reinterpret_cast<const char*>(strip), (std::streamsize)rows * width * sizeof(float));
+				return file->good();
+			};
+	}
+}
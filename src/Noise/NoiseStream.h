@@ -0,0 +1,55 @@
+#pragma once
+
+#include "NoiseTypes.h"
+#include <functional>
+#include <string>
+
+namespace NG
+{
+	/**
+	 * Receives the strips of a streamed image in order: rows [y0, y0 + rows) of a width wide image,
+	 * row-major and tightly packed. The strip buffer is reused once the call returns.
+	 * Returning false cancels the generation.
+	 */
+	using NoiseStripSink = std::function<bool(int y0, int rows, int width, const float* strip)>;
+
+	/** Options of the streaming FBM generator */
+	struct NoiseStreamOptions
+	{
+		/** Rows per strip, peak memory is a few strips of stripRows * res floats */
+		int stripRows = 256;
+
+		/**
+		 * Normalizes with [rangeMin, rangeMax] instead of measuring the raw (pre-normalize) range
+		 * in a first pass. Values outside the range are not clamped.
+		 */
+		bool bKnownRange = false;
+		float rangeMin = 0.0f;
+		float rangeMax = 1.0f;
+
+		NoiseExecution exec;
+	};
+
+	/**
+	 * Streaming variant of FBMNoise2D for images that do not fit in memory (16k - 64k and beyond).
+	 * The image is produced in horizontal strips handed to sink, lattices are hashed on demand and
+	 * turbulence reads only the source rows a strip warps to, so memory is bounded by stripRows.
+	 * Source rows stay in a window of up to 8 strips for the next strips, a warp reaching farther
+	 * re-evaluates the rows that fell out of it.
+	 * Without a known range the octaves are evaluated twice: once for min / max, once for output.
+	 * Unbounded props (see NoiseDomain) are streamed as GenerateRegion windows in a single pass,
+	 * the range options do not apply to them.
+	 * For sizes FBMNoise2D can hold the strips are bit-identical to its result.
+	 *
+	 * @param onProgress	Completed fraction over all passes, returning false cancels
+	 * @return false if canceled by onProgress or sink
+	 */
+	bool FBMNoise2DStream(int res, const NoiseProperties* props, const NoiseStreamOptions& options,
+		const NoiseStripSink& sink, std::function<bool(float)> onProgress = nullptr);
+
+	/**
+	 * Returns a sink appending every strip to path as raw native-endian float32, row after row.
+	 * Throws std::runtime_error if the file cannot be created; write failures cancel the stream.
+	 */
+	NoiseStripSink MakeRawFileSink(const std::string& path);
+}
@@ -1,6 +1,35 @@
 
 #pragma once
 
+/**
+ * Output resolutions offered by the GUI, NoiseProperties::res indexes this table.
+ * Lives here rather than in the GUI so tools and benchmarks sweep the same sizes.
+ */
+inline constexpr int NoiseResolutions[] = { 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+inline constexpr int NoiseResolutionCount = sizeof(NoiseResolutions) / sizeof(NoiseResolutions[0]);
+
+/** Coordinate space of the FBM generators */
+enum class NoiseDomain
+{
+	/** The res x res image is one period of the noise, lattices wrap at its edges */
+	Tiled,
+
+	/**
+	 * Infinite plane without repetition: every lattice value is a hash of (octave seed, ix, iy) at
+	 * world lattice coordinates, so any rectangle can be evaluated on its own and adjacent
+	 * rectangles match bit for bit. res only sets the scale (pixels per coarsest octave period),
+	 * and values are normalized by the octave amplitude sum instead of the measured image range.
+	 */
+	Unbounded
+};
+
+/** Generator an image comes from, for batch jobs and the result cache */
+enum class NoiseAlgorithm
+{
+	FBM,
+	Worley
+};
+
 struct NoiseProperties
 {
 	long seed;
@@ -19,4 +48,16 @@ struct NoiseProperties
 	float turbulence_expshift;
 	float turbulence_offset_x;
 	float turbulence_offset_y;
+
+	NoiseDomain domain = NoiseDomain::Tiled;
+};
+
+/**
+ * Scheduling options for the noise generators.
+ * They only control how the work is split across threads and never change the generated values.
+ */
+struct NoiseExecution
+{
+	/** Threads working on one generation: 1 runs serially, 0 uses every hardware thread */
+	int threadCount = 1;
 };
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "OctaveKernel.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Memory/MemoryTracker.h"
+#include "Utils/HashRandom.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace NG
+{
+	namespace
+	{
+		/** Tile of accumulated pixels kept resident while every octave is added (16 KB) */
+		constexpr int TileWidth = 256;
+		constexpr int TileHeight = 16;
+
+		bool IsLevelEnabled(int level, int octaves, const NoiseProperties* props)
+		{
+			return level >= props->low_freq_skip && level <= octaves - props->high_freq_skip;
+		}
+	}
+
+	int GetOctaveCount(int res)
+	{
+		int octaves = 0;
+		while((1 << octaves) < res) octaves++;
+		return octaves;
+	}
+
+	std::vector<OctaveLayer> BuildOctaveStack(int res, const NoiseProperties* props, const NoiseExecution& exec, LatticeStorage storage)
+	{
+		std::vector<OctaveLayer> layers;
+		if(!props || res <= 0) return layers;
+
+		if(props->domain == NoiseDomain::Unbounded)
+			storage = LatticeStorage::OnDemand;
+
+		float scale = 1.0f;
+		int freq = 2;
+		const int octaves = GetOctaveCount(res);
+
+		for(int level = 0; level < octaves; level++)
+		{
+			if(IsLevelEnabled(level, octaves, props))
+			{
+				OctaveLayer layer;
+				layer.level = level;
+				layer.freq = freq;
+				layer.scale = scale;
+				layer.seed = props->seed + level * 31;
+				layer.domain = props->domain;
+
+				if(storage == LatticeStorage::Stored)
+				{
+					layer.lattice.Resize(freq);
+
+					ParallelForRows(freq, exec, [&] (int rowBegin, int rowEnd)
+						{
+							for(int y = rowBegin; y < rowEnd; y++)
+								HashRandom::FillRow(layer.seed, y, freq, layer.lattice.Row(y));
+						});
+					layer.lattice.WrapBorders();
+				}
+
+				layers.push_back(std::move(layer));
+			}
+
+			freq *= 2;
+			scale *= props->roughness;
+		}
+
+		return layers;
+	}
+
+	uint64_t EstimateOctaveStackBytes(int res, const NoiseProperties* props, LatticeStorage storage)
+	{
+		if(!props || res <= 0) return 0;
+
+		// Unbounded stacks never store their lattices
+		const bool bOnDemand = storage == LatticeStorage::OnDemand;
+		if(!bOnDemand && props->domain == NoiseDomain::Unbounded) return 0;
+
+		uint64_t bytes = 0;
+		const int octaves = GetOctaveCount(res);
+		for(int level = 0, freq = 2; level < octaves; level++, freq *= 2)
+		{
+			if(IsLevelEnabled(level, octaves, props))
+			{
+				// A band spans the cells under TileHeight rows and the three taps around them
+				const uint64_t stride = PaddedLattice2D::PadBefore + freq + PaddedLattice2D::PadAfter;
+				const uint64_t rows = bOnDemand ? (uint64_t)TileHeight * freq / res + 5 : stride;
+				bytes += sizeof(float) * stride * rows;
+			}
+		}
+
+		if(bOnDemand)
+		{
+			NoiseExecution all;
+			all.threadCount = 0;
+			bytes *= ResolveThreadCount(all);
+		}
+		return bytes;
+	}
+
+	float GetOctaveAmplitude(const std::vector<OctaveLayer>& layers)
+	{
+		float amplitude = 0.0f;
+		for(const OctaveLayer& layer : layers)
+			amplitude += layer.scale;
+		return amplitude;
+	}
+
+	void EvaluateOctaves2D(const std::vector<OctaveLayer>& layers, int res, int64_t x0, int64_t y0, int64_t x1, int64_t y1, float* out, int stride)
+	{
+		float tile[TileWidth * TileHeight];
+
+		// Tap indices and weights only depend on x, build them once per octave for the whole rectangle.
+		// Taps index the padded lattice rows directly, nothing is wrapped per tile. Unbounded taps
+		// index the band rows hashed below, which span the columns of the rectangle only
+		std::vector<BSplineColumns> columns(layers.size());
+		for(size_t i = 0; i < layers.size(); i++)
+		{
+			if(layers[i].domain == NoiseDomain::Unbounded)
+				columns[i].BuildUnbounded(x0, (int)(x1 - x0), layers[i].freq, res);
+			else
+				columns[i].Build((int)x0, (int)(x1 - x0), layers[i].freq, res, true);
+		}
+
+		const SimdLevel simd = GetSimdLevel();
+
+		// Separable evaluation: the lattice rows a tile touches are interpolated along x once,
+		// then every output row only combines four of them along y
+		std::vector<float> interpolatedRows;
+
+		// Padded lattice rows hashed for the current tile band, per on-demand layer
+		std::vector<TrackedVector<float>> bandLattices(layers.size());
+		std::vector<int64_t> firstRows(layers.size());
+		std::vector<int> rowCounts(layers.size());
+
+		// Lattice row r of the current band starts at rowBases[i] + r * rowStrides[i], whichever storage backs it
+		std::vector<const float*> rowBases(layers.size());
+		std::vector<size_t> rowStrides(layers.size());
+
+		for(int64_t ty = y0; ty < y1; ty += TileHeight)
+		{
+			const int tileRows = (int)std::min<int64_t>(TileHeight, y1 - ty);
+
+			for(size_t i = 0; i < layers.size(); i++)
+			{
+				const OctaveLayer& layer = layers[i];
+				const int freq = layer.freq;
+
+				if(layer.domain == NoiseDomain::Unbounded)
+				{
+					// World cell indices wrap at 2^32 in the hash, far beyond any reachable coordinate
+					float fraction = 0.0f;
+					firstRows[i] = WorldLatticeCell(ty, freq, res, fraction) - 1;
+					rowCounts[i] = (int)(WorldLatticeCell(ty + tileRows - 1, freq, res, fraction) - 1 + 4 - firstRows[i]);
+
+					const BSplineColumns& layerColumns = columns[i];
+					TrackedVector<float>& band = bandLattices[i];
+					band.resize((size_t)rowCounts[i] * layerColumns.tapCount);
+
+					for(int row = 0; row < rowCounts[i]; row++)
+					{
+						HashRandom::FillRowSpan(layer.seed, (uint32_t)(firstRows[i] + row), (uint32_t)layerColumns.firstTap,
+							layerColumns.tapCount, band.data() + (size_t)row * layerColumns.tapCount);
+					}
+					rowBases[i] = band.data();
+					rowStrides[i] = layerColumns.tapCount;
+					continue;
+				}
+
+				firstRows[i] = LatticeCell((int)ty, freq, res) - 1;
+				rowCounts[i] = LatticeCell((int)ty + tileRows - 1, freq, res) - 1 + 4 - firstRows[i];
+
+				if(!layer.IsOnDemand())
+				{
+					rowBases[i] = layer.lattice.Row((int)firstRows[i]);
+					rowStrides[i] = layer.lattice.stride;
+					continue;
+				}
+
+				const int rowStride = PaddedLattice2D::PadBefore + freq + PaddedLattice2D::PadAfter;
+				TrackedVector<float>& band = bandLattices[i];
+				band.resize((size_t)rowCounts[i] * rowStride);
+
+				for(int row = 0; row < rowCounts[i]; row++)
+				{
+					float* values = band.data() + (size_t)row * rowStride + PaddedLattice2D::PadBefore;
+					HashRandom::FillRow(layer.seed, WrapIndex((int)firstRows[i] + row, freq), freq, values);
+					PaddedLattice2D::WrapRow(values, freq);
+				}
+				rowBases[i] = band.data() + PaddedLattice2D::PadBefore;
+				rowStrides[i] = rowStride;
+			}
+
+			for(int64_t tx = x0; tx < x1; tx += TileWidth)
+			{
+				const int tileCols = (int)std::min<int64_t>(TileWidth, x1 - tx);
+				std::fill(tile, tile + TileWidth * tileRows, 0.0f);
+
+				// Octaves are added in stack order, exactly like the former one-pass-per-octave loop
+				for(size_t i = 0; i < layers.size(); i++)
+				{
+					const OctaveLayer& layer = layers[i];
+					const int freq = layer.freq;
+					const int64_t firstRow = firstRows[i];
+					const int rowCount = rowCounts[i];
+
+					if(interpolatedRows.size() < (size_t)rowCount * TileWidth)
+						interpolatedRows.resize((size_t)rowCount * TileWidth);
+
+					for(int row = 0; row < rowCount; row++)
+					{
+						InterpolateBSplineX(simd, rowBases[i] + (size_t)row * rowStrides[i], columns[i], (int)(tx - x0), tileCols, interpolatedRows.data() + row * TileWidth);
+					}
+
+					for(int64_t y = ty; y < ty + tileRows; y++)
+					{
+						int64_t y3;
+						float yf;
+						if(layer.domain == NoiseDomain::Unbounded)
+						{
+							y3 = WorldLatticeCell(y, freq, res, yf) - 1;
+						}
+						else
+						{
+							y3 = LatticeCell((int)y, freq, res) - 1;
+							yf = (float)(y * freq) / res;
+							yf -= floorf(yf);
+						}
+
+						float wy[4];
+						BSplineWeights(yf, wy);
+
+						const float* rows[4];
+						for(int r = 0; r < 4; r++)
+							rows[r] = interpolatedRows.data() + (y3 + r - firstRow) * TileWidth;
+
+						AccumulateBSplineY(simd, rows, wy, tileCols, layer.scale, tile + (y - ty) * TileWidth);
+					}
+				}
+
+				for(int row = 0; row < tileRows; row++)
+				{
+					memcpy(out + (size_t)(ty - y0 + row) * stride + (tx - x0), tile + row * TileWidth, tileCols * sizeof(float));
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "NoiseTypes.h"
+#include "Noise/NoiseMath.h"
+#include <cstdint>
+#include <vector>
+
+namespace NG
+{
+	/**
+	 * One enabled octave of an FBM stack: its lattice frequency, amplitude and lattice values.
+	 */
+	struct OctaveLayer
+	{
+		/** Octave index inside the stack, before frequency skips are applied */
+		int level = 0;
+
+		/** Lattice cells per image side */
+		int freq = 0;
+
+		/** Amplitude the octave is added with (roughness ^ level) */
+		float scale = 0.0f;
+
+		/** Seed of the lattice; value (x, y) is HashRandom::Float(seed, x, y) */
+		unsigned int seed = 0;
+
+		/** Tiled lattices wrap every freq cells, unbounded ones are hashed at world cell indices */
+		NoiseDomain domain = NoiseDomain::Tiled;
+
+		/**
+		 * freq * freq lattice values with a wrapped border, so the kernel never wraps taps.
+		 * Empty for LatticeStorage::OnDemand layers.
+		 */
+		PaddedLattice2D lattice;
+
+		/** True when the lattice is hashed by the kernel instead of stored */
+		bool IsOnDemand() const { return lattice.freq == 0; }
+	};
+
+	/** Whether BuildOctaveStack stores every lattice or leaves them to be hashed while evaluating */
+	enum class LatticeStorage
+	{
+		/** freq * freq floats per layer, the finest lattice is as large as the image. Reference path for tests */
+		Stored,
+		/** Nothing stored, the kernel hashes the lattice rows each tile band needs */
+		OnDemand
+	};
+
+	/**
+	 * Builds the octaves FBMNoise2D sums for an image of res pixels, honouring
+	 * low_freq_skip / high_freq_skip and the roughness scaling. Skipped octaves are not stored.
+	 * Stored lattice rows are filled in parallel according to exec.
+	 * Unbounded stacks (props->domain) are always OnDemand, there is no finite lattice to store.
+	 */
+	std::vector<OctaveLayer> BuildOctaveStack(int res, const NoiseProperties* props, const NoiseExecution& exec = {},
+		LatticeStorage storage = LatticeStorage::OnDemand);
+
+	/**
+	 * Bytes of the lattices BuildOctaveStack stores for res and props. For OnDemand, bytes of the
+	 * lattice rows EvaluateOctaves2D hashes per tile band, on every hardware thread at once.
+	 */
+	uint64_t EstimateOctaveStackBytes(int res, const NoiseProperties* props, LatticeStorage storage = LatticeStorage::OnDemand);
+
+	/** Sum of the layer amplitudes, the largest value EvaluateOctaves2D can produce */
+	float GetOctaveAmplitude(const std::vector<OctaveLayer>& layers);
+
+	/** Number of octaves FBMNoise2D walks through for res (skipped ones included) */
+	int GetOctaveCount(int res);
+
+	/**
+	 * Fused octave kernel: evaluates the sum of every layer for the pixel rectangle
+	 * [x0, x1) x [y0, y1) of a res x res image and writes each pixel exactly once.
+	 * The rectangle is processed in cache sized tiles, all octaves are accumulated
+	 * while a tile is resident. Results are bit-identical to adding the octaves one
+	 * StupidNoise2D pass at a time.
+	 * For unbounded layers the rectangle may lie anywhere in the world (negative coordinates
+	 * included) and every pixel only depends on its own coordinates, so separately evaluated
+	 * rectangles join without seams.
+	 *
+	 * @param out		Destination of pixel (x0, y0)
+	 * @param stride	Distance in floats between two rows of out
+	 */
+	void EvaluateOctaves2D(const std::vector<OctaveLayer>& layers, int res, int64_t x0, int64_t y0, int64_t x1, int64_t y1, float* out, int stride);
+}
@@ -0,0 +1,296 @@
+#include "OctaveLayerCache.h"
+#include "Noise/NoiseMath.h"
+#include "Noise/NoiseParallel.h"
+#include "Noise/NoiseStages.h"
+#include "Noise/OctaveKernel.h"
+#include "Logger/LoggerMacro.h"
+#include "Memory/BufferPool.h"
+#include "Profiling/Profiler.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+DEFINE_LOG_CATEGORY(LogOctaveLayerCache);
+
+namespace NG
+{
+	namespace
+	{
+		/** Rows evaluated and summed together, so the layer rows are still in cache when they are added */
+		constexpr int ChunkRows = 16;
+
+		uint64_t GetLayerBytes(int res, OctaveLayerCache::Precision precision)
+		{
+			const size_t count = (size_t)res * res;
+			if(precision == OctaveLayerCache::Precision::Float16)
+				return count * sizeof(uint16_t);
+			return BufferPool::GetBucketBytes(count * sizeof(float));
+		}
+	}
+
+	OctaveLayerCache::OctaveLayerCache(uint64_t capacity, Precision precision)
+		: capacity(capacity), precision(precision)
+	{
+		reclaimerId = MemoryTracker::Get().AddReclaimer([this] (uint64_t wanted) { return Reclaim(wanted); });
+	}
+
+	OctaveLayerCache::~OctaveLayerCache()
+	{
+		MemoryTracker::Get().RemoveReclaimer(reclaimerId);
+	}
+
+	NoiseImage OctaveLayerCache::SumOctaves(int res, const NoiseProperties& props, const NoiseExecution& exec,
+		const std::function<bool(float)>& onProgress, bool& outHasOctaves)
+	{
+		// Lattices are hashed while evaluating, cached layers never need theirs
+		std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props, exec);
+		outHasOctaves = !layers.empty();
+
+		if(layers.empty())
+		{
+			if(onProgress && !onProgress(1.0f)) return {};
+
+			NoiseImage data(res, res, 1, true);
+			if(!data)
+			{
+				NGLOG(LogOctaveLayerCache, Error, "Out of memory");
+				throw std::runtime_error("Out of memory");
+			}
+			return data;
+		}
+
+		std::vector<std::shared_ptr<const Layer>> found(layers.size());
+		std::vector<size_t> missing;
+		Precision storage = Precision::Float32;
+		bool bFits = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			storage = precision;
+
+			// A stack larger than the capacity would evict its own layers on every edit
+			bFits = layers.size() * GetLayerBytes(res, storage) <= capacity;
+			for(size_t i = 0; bFits && i < layers.size(); i++)
+			{
+				auto entry = index.find(LayerKey(res, layers[i].freq, layers[i].seed));
+				if(entry != index.end())
+				{
+					entries.splice(entries.begin(), entries, entry->second);
+					found[i] = entry->second->layer;
+					++hits;
+				}
+				else
+				{
+					missing.push_back(i);
+					++misses;
+				}
+			}
+		}
+		if(!bFits)
+		{
+			NG_PROFILE_COUNTER("OctaveLayerCache bypassed", 1);
+			return SumOctaves2D(res, props, exec, onProgress, outHasOctaves);
+		}
+
+		NG_PROFILE_COUNTER("OctaveLayerCache hits", (int64_t)(layers.size() - missing.size()));
+		NG_PROFILE_COUNTER("OctaveLayerCache misses", (int64_t)missing.size());
+
+		// Missing layers are evaluated alone at amplitude 1: 0 + v * 1 is v itself
+		std::vector<std::vector<OctaveLayer>> singles(missing.size());
+		std::vector<std::shared_ptr<Layer>> created(missing.size());
+		for(size_t m = 0; m < missing.size(); m++)
+		{
+			singles[m].push_back(layers[missing[m]]);
+			singles[m][0].scale = 1.0f;
+
+			auto layer = std::make_shared<Layer>();
+			if(storage == Precision::Float16)
+			{
+				layer->halves.resize((size_t)res * res);
+			}
+			else
+			{
+				layer->values = NoiseImage(res, res);
+				if(!layer->values)
+				{
+					NGLOG(LogOctaveLayerCache, Error, "Out of memory");
+					throw std::runtime_error("Out of memory");
+				}
+			}
+			created[m] = layer;
+			found[missing[m]] = layer;
+		}
+
+		NoiseImage data(res, res);
+		if(!data)
+		{
+			NGLOG(LogOctaveLayerCache, Error, "Out of memory");
+			throw std::runtime_error("Out of memory");
+		}
+
+		const SimdLevel simd = GetSimdLevel();
+		const bool bCompleted = ParallelForRows(res, exec, [&] (int begin, int end)
+			{
+				TrackedVector<float> chunk;
+				if(storage == Precision::Float16)
+					chunk.resize((size_t)ChunkRows * res);
+
+				for(int y0 = begin; y0 < end; y0 += ChunkRows)
+				{
+					const int y1 = std::min(y0 + ChunkRows, end);
+					const size_t first = (size_t)y0 * res;
+					const size_t count = (size_t)(y1 - y0) * res;
+
+					for(size_t m = 0; m < missing.size(); m++)
+					{
+						if(storage == Precision::Float32)
+						{
+							EvaluateOctaves2D(singles[m], res, 0, y0, res, y1, created[m]->values.Data() + first, res);
+							continue;
+						}
+
+						EvaluateOctaves2D(singles[m], res, 0, y0, res, y1, chunk.data(), res);
+						ConvertToHalf(simd, chunk.data(), (int)count, created[m]->halves.data() + first);
+					}
+
+					// Octaves are added in stack order, exactly like the fused kernel
+					float* out = data.Data() + first;
+					std::fill(out, out + count, 0.0f);
+					for(size_t i = 0; i < layers.size(); i++)
+					{
+						const Layer& layer = *found[i];
+						if(storage == Precision::Float32)
+							AccumulateScaled(simd, layer.values.Data() + first, (int)count, layers[i].scale, out);
+						else
+							AccumulateScaledHalf(simd, layer.halves.data() + first, (int)count, layers[i].scale, out);
+					}
+				}
+			}, onProgress);
+
+		if(!bCompleted)
+			return {};
+
+		// Every layer of the stack is moved to the front before trimming, so only layers of other
+		// stacks are evicted for it. The capacity may have been lowered since the lookup
+		std::lock_guard<std::mutex> lock(mutex);
+		if(precision == storage && layers.size() * GetLayerBytes(res, storage) <= capacity)
+		{
+			for(size_t i = 0; i < layers.size(); i++)
+			{
+				const LayerKey key(res, layers[i].freq, layers[i].seed);
+				auto entry = index.find(key);
+				if(entry != index.end())
+				{
+					entries.splice(entries.begin(), entries, entry->second);
+					continue;
+				}
+
+				entries.push_front(Entry{ key, found[i] });
+				index[key] = entries.begin();
+				bytes += found[i]->GetBytes();
+			}
+			TrimTo(capacity);
+		}
+		return data;
+	}
+
+	uint64_t OctaveLayerCache::EstimateBytes(int res, const NoiseProperties& props) const
+	{
+		const std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props);
+
+		// Stacks that do not fit are summed without layers
+		std::lock_guard<std::mutex> lock(mutex);
+		if(layers.size() * GetLayerBytes(res, precision) > capacity)
+			return 0;
+
+		uint64_t estimate = 0;
+		for(const OctaveLayer& layer : layers)
+		{
+			if(!index.count(LayerKey(res, layer.freq, layer.seed)))
+				estimate += GetLayerBytes(res, precision);
+		}
+		return estimate;
+	}
+
+	void OctaveLayerCache::SetCapacity(uint64_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		capacity = bytes;
+		TrimTo(capacity);
+	}
+
+	uint64_t OctaveLayerCache::GetCapacity() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return capacity;
+	}
+
+	void OctaveLayerCache::SetPrecision(Precision precision)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(this->precision == precision)
+			return;
+
+		this->precision = precision;
+		TrimTo(0);
+	}
+
+	OctaveLayerCache::Precision OctaveLayerCache::GetPrecision() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return precision;
+	}
+
+	void OctaveLayerCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		TrimTo(0);
+	}
+
+	uint64_t OctaveLayerCache::Reclaim(uint64_t wanted)
+	{
+		// Called by the MemoryTracker from any thread, a SumOctaves storing its layers is not waited for
+		std::unique_lock<std::mutex> lock(mutex, std::try_to_lock);
+		if(!lock.owns_lock())
+			return 0;
+
+		const uint64_t before = bytes;
+		TrimTo(bytes > wanted ? bytes - wanted : 0);
+		if(before != bytes)
+			NGLOG(LogOctaveLayerCache, Info, "Evicted " + std::to_string(before - bytes) + " bytes of octave layers under memory pressure");
+		return before - bytes;
+	}
+
+	uint64_t OctaveLayerCache::GetBytes() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return bytes;
+	}
+
+	size_t OctaveLayerCache::GetLayerCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return entries.size();
+	}
+
+	uint64_t OctaveLayerCache::GetHitCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return hits;
+	}
+
+	uint64_t OctaveLayerCache::GetMissCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return misses;
+	}
+
+	void OctaveLayerCache::TrimTo(uint64_t limit)
+	{
+		while(bytes > limit && !entries.empty())
+		{
+			bytes -= entries.back().layer->GetBytes();
+			index.erase(entries.back().key);
+			entries.pop_back();
+		}
+	}
+}
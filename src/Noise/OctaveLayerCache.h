@@ -0,0 +1,119 @@
+#pragma once
+
+#include "NoiseImage.h"
+#include "NoiseTypes.h"
+#include "Memory/MemoryTracker.h"
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
+namespace NG
+{
+	/**
+	 * Keeps the octaves of FBM maps individually and unscaled, so the octave sum of an edit that
+	 * only changes roughness or the frequency skips is a weighted sum of cached layers instead of
+	 * a new synthesis. A layer only depends on the resolution, its seed (seed + level * 31) and
+	 * its lattice frequency; roughness decides the weight it is added with, the skips whether.
+	 *
+	 * Float32 layers reproduce SumOctaves2D bit for bit. Float16 layers take half the memory and
+	 * round each octave to 11 significant bits, the sum then differs from SumOctaves2D by about
+	 * 1e-3 of its amplitude (identical between runs, cached or not).
+	 *
+	 * Every layer is a full res x res image. The least recently used ones are evicted beyond the
+	 * capacity, never those of the stack being summed, and the cache registers with the
+	 * MemoryTracker so they are also dropped under memory pressure. A stack larger than the whole
+	 * capacity is summed by SumOctaves2D without storing anything. Tiled domain only; unbounded
+	 * octaves are not images of a fixed size.
+	 */
+	class OctaveLayerCache
+	{
+	public:
+		/** Holds the 12 float32 layers of a 4096^2 map, the largest GUI resolution */
+		static constexpr uint64_t DefaultCapacity = 768ull << 20;
+
+		/** Storage of the layer values */
+		enum class Precision
+		{
+			Float32,
+			Float16
+		};
+
+		explicit OctaveLayerCache(uint64_t capacity = DefaultCapacity, Precision precision = Precision::Float32);
+		~OctaveLayerCache();
+
+		OctaveLayerCache(const OctaveLayerCache&) = delete;
+		OctaveLayerCache& operator=(const OctaveLayerCache&) = delete;
+
+		/**
+		 * Raw sum of the enabled octaves of props, like SumOctaves2D; layers that are not cached
+		 * are evaluated and added to the cache. Empty if canceled.
+		 */
+		NoiseImage SumOctaves(int res, const NoiseProperties& props, const NoiseExecution& exec,
+			const std::function<bool(float)>& onProgress, bool& outHasOctaves);
+
+		/** Bytes SumOctaves allocates for the layers of res and props that are not cached */
+		uint64_t EstimateBytes(int res, const NoiseProperties& props) const;
+
+		/** Limits the bytes of the cached layers; lowering it evicts right away */
+		void SetCapacity(uint64_t bytes);
+		uint64_t GetCapacity() const;
+
+		/** Changing the precision drops every layer */
+		void SetPrecision(Precision precision);
+		Precision GetPrecision() const;
+
+		/** Drops every layer */
+		void Clear();
+
+		/** Evicts least recently used layers until bytes are freed; returns the bytes freed */
+		uint64_t Reclaim(uint64_t bytes);
+
+		/** Bytes and number of the cached layers */
+		uint64_t GetBytes() const;
+		size_t GetLayerCount() const;
+
+		/** Layers SumOctaves found in the cache / had to evaluate */
+		uint64_t GetHitCount() const;
+		uint64_t GetMissCount() const;
+
+	private:
+		/** Resolution, lattice frequency and seed of a layer */
+		using LayerKey = std::tuple<int, int, unsigned int>;
+
+		/** Values of one octave, in values (Float32) or halves (Float16) */
+		struct Layer
+		{
+			NoiseImage values;
+			TrackedVector<uint16_t> halves;
+
+			uint64_t GetBytes() const { return values.GetBytes() + halves.size() * sizeof(uint16_t); }
+		};
+
+		struct Entry
+		{
+			LayerKey key;
+			std::shared_ptr<const Layer> layer;
+		};
+
+		/** Evicts until at most bytes are held; mutex must be held */
+		void TrimTo(uint64_t bytes);
+
+		mutable std::mutex mutex;
+
+		/** Most recently used first */
+		std::list<Entry> entries;
+		std::map<LayerKey, std::list<Entry>::iterator> index;
+
+		uint64_t capacity = DefaultCapacity;
+		Precision precision = Precision::Float32;
+		uint64_t bytes = 0;
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+
+		uint64_t reclaimerId = 0;
+	};
+}
@@ -0,0 +1,126 @@
+#include "WorleyGrid.h"
+#include "Noise/NoiseMath.h"
+#include "Utils/HashRandom.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace NG
+{
+	namespace
+	{
+		/**
+		 * Slack added before a ring search stops, so float rounding of the ring bound
+		 * can never drop a point whose computed distance ties with the current result
+		 */
+		constexpr float SearchMargin = 1e-5f;
+	}
+
+	void WorleyGrid::Build(const std::vector<std::pair<float, float>>& points)
+	{
+		const int cellsPerAxis = std::max(1, static_cast<int>(std::sqrt(static_cast<float>(points.size()))));
+		Bin(points, cellsPerAxis);
+	}
+
+	void WorleyGrid::BuildJittered(int cellsPerAxis, unsigned int seed)
+	{
+		cellsPerAxis = std::max(1, cellsPerAxis);
+
+		std::vector<std::pair<float, float>> points;
+		points.reserve((size_t)cellsPerAxis * cellsPerAxis);
+
+		for(int cy = 0; cy < cellsPerAxis; ++cy)
+		{
+			for(int cx = 0; cx < cellsPerAxis; ++cx)
+			{
+				const uint32_t cell = static_cast<uint32_t>(cx + cy * cellsPerAxis);
+				const float jx = HashRandom::Float(seed, 2 * cell);
+				const float jy = HashRandom::Float(seed, 2 * cell + 1);
+				points.emplace_back((cx + jx) / cellsPerAxis, (cy + jy) / cellsPerAxis);
+			}
+		}
+
+		Bin(points, cellsPerAxis);
+	}
+
+	void WorleyGrid::Bin(const std::vector<std::pair<float, float>>& points, int cellsPerAxis)
+	{
+		cells = cellsPerAxis;
+		cellStart.assign((size_t)cells * cells + 1, 0);
+
+		for(const auto& [px, py] : points)
+			cellStart[CellOf(px) + CellOf(py) * cells + 1]++;
+
+		for(size_t i = 1; i < cellStart.size(); ++i)
+			cellStart[i] += cellStart[i - 1];
+
+		pointX.resize(points.size());
+		pointY.resize(points.size());
+
+		std::vector<int> cursor(cellStart.begin(), cellStart.end() - 1);
+		for(const auto& [px, py] : points)
+		{
+			const int slot = cursor[CellOf(px) + CellOf(py) * cells]++;
+			pointX[slot] = px;
+			pointY[slot] = py;
+		}
+	}
+
+	int WorleyGrid::CellOf(float v) const
+	{
+		return std::clamp(static_cast<int>(floorf(v * cells)), 0, cells - 1);
+	}
+
+	void WorleyGrid::Query(float x, float y, float& f1, float& f2) const
+	{
+		f1 = std::numeric_limits<float>::max();
+		f2 = std::numeric_limits<float>::max();
+		if(cells == 0) return;
+
+		const int cx = CellOf(x);
+		const int cy = CellOf(y);
+		const float gx = x * cells;
+		const float gy = y * cells;
+
+		for(int ring = 0; ; ++ring)
+		{
+			const int x0 = cx - ring, x1 = cx + ring;
+			const int y0 = cy - ring, y1 = cy + ring;
+
+			for(int j = std::max(y0, 0); j <= std::min(y1, cells - 1); ++j)
+			{
+				// Inner rows of the ring only contribute their two side cells
+				const bool bEdgeRow = (j == y0 || j == y1);
+				const int step = bEdgeRow ? 1 : std::max(1, x1 - x0);
+
+				for(int i = x0; i <= x1; i += step)
+				{
+					if(i < 0 || i >= cells) continue;
+
+					const int cell = i + j * cells;
+					for(int p = cellStart[cell]; p < cellStart[cell + 1]; ++p)
+					{
+						const float d = Distance(x, y, pointX[p], pointY[p]);
+						if(d < f1)
+						{
+							f2 = f1;
+							f1 = d;
+						}
+						else if(d < f2)
+						{
+							f2 = d;
+						}
+					}
+				}
+			}
+
+			if(x0 <= 0 && y0 <= 0 && x1 >= cells - 1 && y1 >= cells - 1)
+				break;
+
+			// Every point outside the searched block is at least this far away
+			const float bound = std::min(std::min(gx - x0, (x1 + 1) - gx), std::min(gy - y0, (y1 + 1) - gy)) / cells;
+			if(bound > f2 + SearchMargin)
+				break;
+		}
+	}
+}
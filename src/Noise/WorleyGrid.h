@@ -0,0 +1,61 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace NG
+{
+	/** Distance feature written per pixel by WorleyNoise2D */
+	enum class WorleyFeature
+	{
+		/** Distance to the nearest feature point */
+		F1,
+		/** Distance to the second nearest feature point */
+		F2,
+		/** F2 - F1, bright along cell borders */
+		F2MinusF1
+	};
+
+	/**
+	 * WorleyGrid bins feature points of the unit square into a uniform cell grid,
+	 * so a nearest-feature query only visits the cells around the query point
+	 * instead of every point. Distances are computed with NG::Distance, so F1 is
+	 * identical to a brute force scan over the same points.
+	 */
+	class WorleyGrid
+	{
+	public:
+		/** Bins arbitrary points in [0, 1]^2, sized for about one point per cell */
+		void Build(const std::vector<std::pair<float, float>>& points);
+
+		/** Places one jittered point in every cell of a cellsPerAxis x cellsPerAxis grid */
+		void BuildJittered(int cellsPerAxis, unsigned int seed);
+
+		/**
+		 * Returns the nearest (f1) and second nearest (f2) feature distance from (x, y).
+		 * f2 stays at the float maximum when the grid holds a single point.
+		 */
+		void Query(float x, float y, float& f1, float& f2) const;
+
+		/** Number of binned feature points */
+		int GetPointCount() const { return static_cast<int>(pointX.size()); }
+
+		/** Grid cells per axis */
+		int GetCellsPerAxis() const { return cells; }
+
+	private:
+		/** Sorts points into cells (counting sort into cellStart / pointX / pointY) */
+		void Bin(const std::vector<std::pair<float, float>>& points, int cellsPerAxis);
+
+		int CellOf(float v) const;
+
+		int cells = 0;
+
+		/** cells * cells + 1 offsets into pointX / pointY, row-major */
+		std::vector<int> cellStart;
+
+		/** Point coordinates grouped by cell */
+		std::vector<float> pointX;
+		std::vector<float> pointY;
+	};
+}
@@ -0,0 +1,113 @@
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include <algorithm>
+
+namespace
+{
+	/** Innermost running stage of each thread */
+	thread_local ScopedStageTimer* currentTimer = nullptr;
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler instance;
+	return instance;
+}
+
+void Profiler::RecordStage(const std::string& name, double milliseconds, int64_t pixels, uint64_t bytesAllocated)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+
+	auto found = std::find_if(stages.begin(), stages.end(),
+		[&] (const ProfileStageStats& stage) { return stage.name == name; });
+	if(found == stages.end())
+	{
+		stages.emplace_back();
+		stages.back().name = name;
+		found = stages.end() - 1;
+	}
+
+	ProfileStageStats& stage = *found;
+	stage.calls++;
+	stage.totalMilliseconds += milliseconds;
+
+	int index;
+	if(stage.historyCount < ProfileStageStats::HistoryLength)
+	{
+		index = stage.historyCount++;
+	}
+	else
+	{
+		index = stage.historyOffset;
+		stage.historyOffset = (stage.historyOffset + 1) % ProfileStageStats::HistoryLength;
+	}
+
+	stage.milliseconds[index] = static_cast<float>(milliseconds);
+	stage.megapixelsPerSecond[index] = milliseconds > 0.0 ? static_cast<float>(pixels / 1.0e3 / milliseconds) : 0.0f;
+	stage.megabytesAllocated[index] = static_cast<float>(bytesAllocated / (1024.0 * 1024.0));
+}
+
+void Profiler::AddCounter(const char* name, int64_t delta)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	counters[name] += delta;
+}
+
+std::vector<ProfileStageStats> Profiler::GetStages() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return stages;
+}
+
+std::map<std::string, int64_t> Profiler::GetCounters() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return counters;
+}
+
+void Profiler::Reset()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	stages.clear();
+	counters.clear();
+}
+
+ScopedStageTimer::ScopedStageTimer(const char* name, int64_t inPixels)
+	: name(name)
+	, pixels(inPixels)
+	, parent(currentTimer)
+	, bTrace(TraceRecorder::Get().IsRecording())
+{
+	path = parent ? parent->path + "/" + name : std::string(name);
+	currentTimer = this;
+	start = std::chrono::steady_clock::now();
+}
+
+ScopedStageTimer::~ScopedStageTimer()
+{
+	const auto end = std::chrono::steady_clock::now();
+	const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	currentTimer = parent;
+	if(parent)
+		parent->bytesAllocated += bytesAllocated;
+
+	Profiler::Get().RecordStage(path, milliseconds, pixels, bytesAllocated);
+
+	if(bTrace)
+	{
+		TraceRecorder::Get().AddComplete(name, "stage", start, end, "{\"path\":\"" + path + "\",\"pixels\":"
+			+ std::to_string(pixels) + ",\"bytes\":" + std::to_string(bytesAllocated) + "}");
+	}
+}
+
+const std::string* ScopedStageTimer::CurrentPath()
+{
+	return currentTimer ? &currentTimer->path : nullptr;
+}
+
+void ScopedStageTimer::AddAllocatedBytes(uint64_t bytes)
+{
+	if(currentTimer)
+		currentTimer->bytesAllocated += bytes;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Stage instrumentation for the noise engine.
+ *
+ * Code marks stages with NG_PROFILE_STAGE, allocations with NG_PROFILE_ALLOC and events with
+ * NG_PROFILE_COUNTER. When NG_ENABLE_PROFILING is 0 (CMake option NOISE_ENABLE_PROFILING=OFF)
+ * the macros expand to nothing and their arguments are not evaluated.
+ */
+#ifndef NG_ENABLE_PROFILING
+#define NG_ENABLE_PROFILING 0
+#endif
+
+/** Rolling statistics of one stage, identified by its nesting path ("FBMNoise2D/Warp") */
+struct ProfileStageStats
+{
+	static constexpr int HistoryLength = 120;
+
+	std::string name;
+	uint64_t calls = 0;
+	double totalMilliseconds = 0.0;
+
+	/** Ring buffers of the last HistoryLength calls, historyOffset is the oldest entry */
+	float milliseconds[HistoryLength] = {};
+	float megapixelsPerSecond[HistoryLength] = {};
+	float megabytesAllocated[HistoryLength] = {};
+	int historyCount = 0;
+	int historyOffset = 0;
+
+	/** Index of the most recent entry */
+	int Latest() const { return (historyOffset + historyCount - 1) % HistoryLength; }
+};
+
+class Profiler
+{
+public:
+	static constexpr bool bEnabled = NG_ENABLE_PROFILING != 0;
+
+	static Profiler& Get();
+
+	/** Adds one finished stage; pixels may be 0 for stages without an output size */
+	void RecordStage(const std::string& name, double milliseconds, int64_t pixels, uint64_t bytesAllocated);
+
+	void AddCounter(const char* name, int64_t delta);
+
+	/** Copies of the current statistics, stages in the order they were first recorded */
+	std::vector<ProfileStageStats> GetStages() const;
+	std::map<std::string, int64_t> GetCounters() const;
+
+	void Reset();
+
+private:
+	Profiler() = default;
+
+	mutable std::mutex mutex;
+	std::vector<ProfileStageStats> stages;
+	std::map<std::string, int64_t> counters;
+};
+
+/**
+ * Times the enclosing scope as one stage. Timers nest per thread: a stage opened inside another
+ * one is recorded as "Parent/Child", and bytes allocated by a child also count for its parent.
+ * While a TraceRecorder recording runs, each stage is also written as a slice on the timeline.
+ */
+class ScopedStageTimer
+{
+public:
+	explicit ScopedStageTimer(const char* name, int64_t pixels = 0);
+	~ScopedStageTimer();
+
+	ScopedStageTimer(const ScopedStageTimer&) = delete;
+	ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+	/** Charges bytes to the innermost stage running on this thread, if any */
+	static void AddAllocatedBytes(uint64_t bytes);
+
+	/** Path of the innermost stage running on this thread, nullptr outside of any stage */
+	static const std::string* CurrentPath();
+
+private:
+	const char* name;
+	std::string path;
+	int64_t pixels = 0;
+	uint64_t bytesAllocated = 0;
+	std::chrono::steady_clock::time_point start;
+	ScopedStageTimer* parent = nullptr;
+
+	/** Also emit a trace slice, decided when the stage starts */
+	bool bTrace = false;
+};
+
+#if NG_ENABLE_PROFILING
+#define NG_PROFILE_CONCAT_INNER(A, B) A##B
+#define NG_PROFILE_CONCAT(A, B) NG_PROFILE_CONCAT_INNER(A, B)
+#define NG_PROFILE_STAGE(Name, Pixels) ScopedStageTimer NG_PROFILE_CONCAT(ngStageTimer, __LINE__)(Name, Pixels)
+#define NG_PROFILE_ALLOC(Bytes) ScopedStageTimer::AddAllocatedBytes(Bytes)
+#define NG_PROFILE_COUNTER(Name, Delta) Profiler::Get().AddCounter(Name, Delta)
+#else
+#define NG_PROFILE_STAGE(Name, Pixels) ((void)0)
+#define NG_PROFILE_ALLOC(Bytes) ((void)0)
+#define NG_PROFILE_COUNTER(Name, Delta) ((void)0)
+#endif
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "Profiler.h"
+#include "TraceRecorder.h"
+#include "Logger/Logger.h"
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "imgui.h"
+#include "GUI/IconRegistry.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+
+/** Draws the per-stage statistics collected by Profiler; call between ImGui::Begin/End */
+inline void DrawProfilerWindow()
+{
+	if(!Profiler::bEnabled)
+	{
+		ImGui::TextDisabled("Profiling is compiled out (NOISE_ENABLE_PROFILING=OFF)");
+		return;
+	}
+
+	enum class PlotMetric { Milliseconds, Megapixels, Megabytes };
+	static int metric = 0;
+	static const char* metricOptions[] = { "Time (ms)", "Throughput (MP/s)", "Allocated (MB)" };
+
+	ImGui::Text("Histogram:");
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(160);
+	ImGui::Combo("##ProfilerMetric", &metric, metricOptions, IM_ARRAYSIZE(metricOptions));
+	ImGui::SameLine();
+	if(ImGui::Button(WITH_ICON("Trash", "Reset")))
+	{
+		Profiler::Get().Reset();
+	}
+
+	// Timeline capture for chrome://tracing / Perfetto
+	ImGui::SameLine();
+	TraceRecorder& recorder = TraceRecorder::Get();
+	if(!recorder.IsRecording())
+	{
+		if(ImGui::Button(WITH_ICON("DotCircle", "Record Trace")))
+		{
+			recorder.Start();
+		}
+	}
+	else
+	{
+		if(ImGui::Button(WITH_ICON("Stop", "Save Trace")))
+		{
+			recorder.Stop();
+			if(recorder.WriteChromeTrace(TraceRecorder::filePath))
+				Logger::Log("Profiler", LogVerbosity::Info, "Trace saved to " + TraceRecorder::filePath);
+			else
+				Logger::Log("Profiler", LogVerbosity::Error, "Failed to write trace: " + TraceRecorder::filePath);
+		}
+		ImGui::SameLine();
+		ImGui::TextDisabled("%zu events", recorder.GetEventCount());
+	}
+
+	const std::vector<ProfileStageStats> stages = Profiler::Get().GetStages();
+	const std::map<std::string, int64_t> counters = Profiler::Get().GetCounters();
+
+	ImGui::BeginChild("ProfilerScrollRegion", ImVec2(0, 0), true);
+
+	const ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV |
+		ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_Resizable;
+	if(ImGui::BeginTable("##ProfilerStages", 6, tableFlags))
+	{
+		ImGui::TableSetupColumn("Stage", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+		ImGui::TableSetupColumn("Calls");
+		ImGui::TableSetupColumn("Last ms");
+		ImGui::TableSetupColumn("MP/s");
+		ImGui::TableSetupColumn("MB");
+		ImGui::TableSetupColumn("History", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+		ImGui::TableHeadersRow();
+
+		for(const ProfileStageStats& stage : stages)
+		{
+			const int latest = stage.Latest();
+			const float* values = stage.milliseconds;
+			if(static_cast<PlotMetric>(metric) == PlotMetric::Megapixels) values = stage.megapixelsPerSecond;
+			if(static_cast<PlotMetric>(metric) == PlotMetric::Megabytes) values = stage.megabytesAllocated;
+
+			// Nested stages are indented by their depth and show only their own name
+			const size_t depth = std::count(stage.name.begin(), stage.name.end(), '/');
+			const size_t slash = stage.name.find_last_of('/');
+			const char* label = stage.name.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			if(depth > 0) ImGui::Indent(depth * 12.0f);
+			ImGui::TextUnformatted(label);
+			if(ImGui::IsItemHovered()) ImGui::SetTooltip("%s", stage.name.c_str());
+			if(depth > 0) ImGui::Unindent(depth * 12.0f);
+
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(stage.calls));
+			ImGui::TableNextColumn();
+			ImGui::Text("%.2f", stage.milliseconds[latest]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", stage.megapixelsPerSecond[latest]);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", stage.megabytesAllocated[latest]);
+
+			ImGui::TableNextColumn();
+			char overlay[48];
+			snprintf(overlay, sizeof(overlay), "avg %.2f ms", stage.calls ? stage.totalMilliseconds / stage.calls : 0.0);
+			ImGui::PushID(stage.name.c_str());
+			ImGui::PlotHistogram("##History", values, stage.historyCount, stage.historyOffset,
+				metric == 0 ? overlay : nullptr, 0.0f, FLT_MAX, ImVec2(-FLT_MIN, 28.0f));
+			ImGui::PopID();
+		}
+		ImGui::EndTable();
+	}
+
+	if(!counters.empty())
+	{
+		ImGui::SeparatorText("Counters");
+		for(const auto& [name, value] : counters)
+		{
+			ImGui::Text("%-28s %lld", name.c_str(), static_cast<long long>(value));
+		}
+	}
+
+	if(stages.empty())
+	{
+		ImGui::TextDisabled("Generate noise to collect timings");
+	}
+
+	constexpr double Megabyte = 1024.0 * 1024.0;
+	const MemoryTracker& memory = MemoryTracker::Get();
+	ImGui::SeparatorText("Memory");
+	ImGui::Text("Current %.1f MB   Peak %.1f MB   Reserved %.1f MB", memory.GetCurrentBytes() / Megabyte,
+		memory.GetPeakBytes() / Megabyte, memory.GetReservedBytes() / Megabyte);
+	if(memory.GetBudget() > 0)
+	{
+		ImGui::SameLine();
+		ImGui::Text("  Budget %.0f MB (%s)", memory.GetBudget() / Megabyte,
+			memory.GetBudgetPolicy() == MemoryBudgetPolicy::Queue ? "queue" : "refuse");
+	}
+
+	const BufferPool& pool = BufferPool::Get();
+	ImGui::Text("Buffer pool %.1f MB idle   %llu reused   %llu allocated", pool.GetPooledBytes() / Megabyte,
+		static_cast<unsigned long long>(pool.GetHitCount()), static_cast<unsigned long long>(pool.GetMissCount()));
+
+	const std::vector<MemoryJobReport> jobs = memory.GetRecentJobs();
+	if(!jobs.empty() && ImGui::BeginTable("##MemoryJobs", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV))
+	{
+		ImGui::TableSetupColumn("Job", ImGuiTableColumnFlags_WidthStretch);
+		ImGui::TableSetupColumn("Reserved MB");
+		ImGui::TableSetupColumn("Peak MB");
+		ImGui::TableHeadersRow();
+
+		// Most recent first
+		for(auto it = jobs.rbegin(); it != jobs.rend(); ++it)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(it->name.c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", it->reservedBytes / Megabyte);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", it->peakBytes / Megabyte);
+		}
+		ImGui::EndTable();
+	}
+
+	ImGui::EndChild();
+}
@@ -0,0 +1,208 @@
+#include "TraceRecorder.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+	thread_local int threadId = 0;
+	thread_local const char* threadName = nullptr;
+
+	void AppendEscaped(std::string& out, const std::string& text)
+	{
+		for(char c : text)
+		{
+			switch(c)
+			{
+				case '"': out += "\\\""; break;
+				case '\\': out += "\\\\"; break;
+				case '\n': out += "\\n"; break;
+				case '\t': out += "\\t"; break;
+				default:
+					if(static_cast<unsigned char>(c) < 0x20)
+					{
+						char buffer[8];
+						snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+						out += buffer;
+					}
+					else
+					{
+						out += c;
+					}
+			}
+		}
+	}
+}
+
+std::string TraceRecorder::filePath = "trace.json";
+
+TraceRecorder& TraceRecorder::Get()
+{
+	static TraceRecorder instance;
+	return instance;
+}
+
+void TraceRecorder::Start()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	events.clear();
+	origin = Clock::now();
+	bRecording = true;
+}
+
+void TraceRecorder::Stop()
+{
+	bRecording = false;
+}
+
+int TraceRecorder::GetThreadId()
+{
+	if(threadId == 0)
+		threadId = nextThreadId.fetch_add(1);
+	return threadId;
+}
+
+double TraceRecorder::ToMicroseconds(Clock::time_point time) const
+{
+	return std::chrono::duration<double, std::micro>(time - origin).count();
+}
+
+void TraceRecorder::SetThreadName(const char* name)
+{
+	if(threadName == name)
+		return;
+
+	threadName = name;
+	const int id = GetThreadId();
+	std::lock_guard<std::mutex> lock(mutex);
+	threadNames[id] = name;
+}
+
+void TraceRecorder::AddComplete(std::string name, const char* category, Clock::time_point start, Clock::time_point end, std::string args)
+{
+	if(!IsRecording())
+		return;
+
+	Event event;
+	event.name = std::move(name);
+	event.category = category;
+	event.phase = 'X';
+	event.threadId = GetThreadId();
+	event.args = std::move(args);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	// Slices opened before Start() are clipped to the beginning of the recording
+	event.timestampMicroseconds = std::max(0.0, ToMicroseconds(start));
+	event.durationMicroseconds = std::max(0.0, ToMicroseconds(end) - event.timestampMicroseconds);
+	events.push_back(std::move(event));
+}
+
+void TraceRecorder::AddInstant(std::string name, const char* category)
+{
+	if(!IsRecording())
+		return;
+
+	Event event;
+	event.name = std::move(name);
+	event.category = category;
+	event.phase = 'i';
+	event.threadId = GetThreadId();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	event.timestampMicroseconds = ToMicroseconds(Clock::now());
+	events.push_back(std::move(event));
+}
+
+uint64_t TraceRecorder::BeginFlow(const char* name)
+{
+	const uint64_t id = nextFlowId.fetch_add(1);
+	if(!IsRecording())
+		return id;
+
+	Event event;
+	event.name = name;
+	event.category = "flow";
+	event.phase = 's';
+	event.threadId = GetThreadId();
+	event.flowId = id;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	event.timestampMicroseconds = ToMicroseconds(Clock::now());
+	events.push_back(std::move(event));
+	return id;
+}
+
+void TraceRecorder::EndFlow(const char* name, uint64_t flowId)
+{
+	if(!IsRecording())
+		return;
+
+	Event event;
+	event.name = name;
+	event.category = "flow";
+	event.phase = 'f';
+	event.threadId = GetThreadId();
+	event.flowId = flowId;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	event.timestampMicroseconds = ToMicroseconds(Clock::now());
+	events.push_back(std::move(event));
+}
+
+size_t TraceRecorder::GetEventCount() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return events.size();
+}
+
+bool TraceRecorder::WriteChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::trunc);
+	if(!file.is_open())
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"NoiseGenerator\"}}";
+	for(const auto& [id, name] : threadNames)
+	{
+		json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" + std::to_string(id) + ",\"args\":{\"name\":\"";
+		AppendEscaped(json, name);
+		json += "\"}}";
+	}
+
+	char buffer[128];
+	for(const Event& event : events)
+	{
+		json += ",\n{\"name\":\"";
+		AppendEscaped(json, event.name);
+		snprintf(buffer, sizeof(buffer), "\",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+			event.category, event.phase, event.threadId, event.timestampMicroseconds);
+		json += buffer;
+
+		switch(event.phase)
+		{
+			case 'X':
+				snprintf(buffer, sizeof(buffer), ",\"dur\":%.3f", event.durationMicroseconds);
+				json += buffer;
+				break;
+			case 'i':
+				json += ",\"s\":\"t\"";
+				break;
+			case 's':
+			case 'f':
+				// "bp":"e" binds the arrow end to the enclosing slice instead of the next one
+				json += ",\"id\":" + std::to_string(event.flowId) + (event.phase == 'f' ? ",\"bp\":\"e\"" : "");
+				break;
+		}
+
+		if(!event.args.empty())
+			json += ",\"args\":" + event.args;
+		json += "}";
+	}
+	json += "\n]}\n";
+
+	file << json;
+	return file.good();
+}
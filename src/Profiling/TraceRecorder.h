@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Records a timeline of begin/end events per thread and writes it in the Chrome trace event
+ * format, which chrome://tracing and https://ui.perfetto.dev open directly.
+ *
+ * Recording is off until Start() is called. While it is on, every NG_PROFILE_STAGE also becomes a
+ * slice on the timeline; NG_TRACE_SCOPE adds slices that are not profiler stages (threads, UI
+ * tasks, worker bands). With NG_ENABLE_PROFILING set to 0 the macros compile to nothing.
+ */
+class TraceRecorder
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	/** One "X" (complete), "s"/"f" (flow) or "i" (instant) event */
+	struct Event
+	{
+		std::string name;
+		const char* category = "";
+		char phase = 'X';
+		int threadId = 0;
+		double timestampMicroseconds = 0.0;
+		double durationMicroseconds = 0.0;
+		uint64_t flowId = 0;
+
+		/** Preformatted JSON object with the event arguments, empty for none */
+		std::string args;
+	};
+
+	static TraceRecorder& Get();
+
+	/** Drops the previous recording and starts a new one */
+	void Start();
+	void Stop();
+
+	bool IsRecording() const { return bRecording.load(std::memory_order_relaxed); }
+
+	/** Names the calling thread in the trace ("Generation", "Engine worker"); cheap after the first call */
+	void SetThreadName(const char* name);
+
+	/** Adds a slice on the calling thread; ignored when not recording */
+	void AddComplete(std::string name, const char* category, Clock::time_point start, Clock::time_point end, std::string args = {});
+
+	void AddInstant(std::string name, const char* category);
+
+	/** Starts an arrow from the innermost slice of the calling thread; returns the id for EndFlow */
+	uint64_t BeginFlow(const char* name);
+
+	/** Ends the arrow at the slice that is open on the calling thread */
+	void EndFlow(const char* name, uint64_t flowId);
+
+	size_t GetEventCount() const;
+
+	/** Writes the recorded events as Chrome trace JSON, returns false if the file cannot be written */
+	bool WriteChromeTrace(const std::string& path) const;
+
+	/** Default output of the GUI's trace button */
+	static std::string filePath;
+
+private:
+	TraceRecorder() = default;
+
+	/** Small stable id of the calling thread, the first thread to ask gets 1 */
+	int GetThreadId();
+
+	double ToMicroseconds(Clock::time_point time) const;
+
+	std::atomic<bool> bRecording{ false };
+	std::atomic<int> nextThreadId{ 1 };
+	std::atomic<uint64_t> nextFlowId{ 1 };
+	Clock::time_point origin = Clock::now();
+
+	mutable std::mutex mutex;
+	std::vector<Event> events;
+	std::map<int, std::string> threadNames;
+};
+
+/** Records the enclosing scope as one slice, if a recording was running when it started */
+class ScopedTraceEvent
+{
+public:
+	explicit ScopedTraceEvent(const char* name, const char* category = "engine")
+		: name(name)
+		, category(category)
+		, bActive(TraceRecorder::Get().IsRecording())
+	{
+		if(bActive)
+			start = TraceRecorder::Clock::now();
+	}
+
+	~ScopedTraceEvent()
+	{
+		if(bActive)
+			TraceRecorder::Get().AddComplete(name, category, start, TraceRecorder::Clock::now());
+	}
+
+	ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+	ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+
+private:
+	const char* name;
+	const char* category;
+	bool bActive;
+	TraceRecorder::Clock::time_point start;
+};
+
+#if NG_ENABLE_PROFILING
+#define NG_TRACE_SCOPE(Name) ScopedTraceEvent NG_PROFILE_CONCAT(ngTraceEvent, __LINE__)(Name)
+#define NG_TRACE_THREAD_NAME(Name) TraceRecorder::Get().SetThreadName(Name)
+#else
+#define NG_TRACE_SCOPE(Name) ((void)0)
+#define NG_TRACE_THREAD_NAME(Name) ((void)0)
+#endif
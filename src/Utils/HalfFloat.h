@@ -0,0 +1,68 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * IEEE 754 binary16 conversions, used where float noise is stored at half size.
+ * Rounding is to nearest even, out of range values become infinity.
+ */
+namespace HalfFloat
+{
+	inline uint16_t FromFloat(float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+		const uint32_t magnitude = bits & 0x7FFFFFFFu;
+
+		// Inf / NaN
+		if(magnitude >= 0x7F800000u)
+			return sign | (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u);
+
+		// Rounds to 65520 or more
+		if(magnitude >= 0x477FF000u)
+			return sign | 0x7C00u;
+
+		// Below the smallest normal half (2^-14): the subnormal mantissa is value * 2^24
+		if(magnitude < 0x38800000u)
+		{
+			float absolute;
+			memcpy(&absolute, &magnitude, sizeof(absolute));
+			return sign | static_cast<uint16_t>(std::nearbyint(absolute * 16777216.0f));
+		}
+
+		// Rebias the exponent (127 -> 15) and round the mantissa from 23 to 10 bits
+		uint32_t half = magnitude - 0x38000000u;
+		half += 0x0FFFu + ((half >> 13) & 1u);
+		return sign | static_cast<uint16_t>(half >> 13);
+	}
+
+	inline float ToFloat(uint16_t half)
+	{
+		const uint32_t sign = static_cast<uint32_t>(half & 0x8000u) << 16;
+		const uint32_t exponent = (half >> 10) & 0x1Fu;
+		const uint32_t mantissa = half & 0x3FFu;
+
+		uint32_t bits;
+		if(exponent == 0)
+		{
+			const float subnormal = static_cast<float>(mantissa) * (1.0f / 16777216.0f);
+			memcpy(&bits, &subnormal, sizeof(bits));
+			bits |= sign;
+		}
+		else if(exponent == 31)
+		{
+			bits = sign | 0x7F800000u | (mantissa << 13);
+		}
+		else
+		{
+			bits = sign | ((exponent + 112u) << 23) | (mantissa << 13);
+		}
+
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
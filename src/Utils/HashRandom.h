@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+
+/**
+ * HashRandom is a stateless counter-based generator: every value is a hash of
+ * (seed, index), so there is no shared state to lock, draws can happen in any
+ * order or on any thread, and results are identical on every platform.
+ */
+namespace HashRandom
+{
+	/** PCG output permutation used as an integer hash (Jarzynski & Olano) */
+	inline uint32_t Permute(uint32_t value)
+	{
+		const uint32_t state = value * 747796405u + 2891336453u;
+		const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+		return (word >> 22u) ^ word;
+	}
+
+	/** Returns the random bits drawn at index of the stream identified by seed */
+	inline uint32_t Hash(uint32_t seed, uint32_t index)
+	{
+		return Permute(index ^ Permute(seed));
+	}
+
+	/** Returns the random bits at lattice point (x, y) of the field identified by seed */
+	inline uint32_t Hash(uint32_t seed, uint32_t x, uint32_t y)
+	{
+		return Permute(x ^ Permute(y ^ Permute(seed)));
+	}
+
+	/** Returns the random bits at lattice point (x, y, z) of the field identified by seed */
+	inline uint32_t Hash(uint32_t seed, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return Permute(x ^ Permute(y ^ Permute(z ^ Permute(seed))));
+	}
+
+	/** Maps the top 24 bits of a hash to a float in the range [0, 1) */
+	inline float ToFloat(uint32_t bits)
+	{
+		return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+	}
+
+	/** Returns a random float in the range [0, 1) drawn at index of the stream identified by seed */
+	inline float Float(uint32_t seed, uint32_t index)
+	{
+		return ToFloat(Hash(seed, index));
+	}
+
+	/** Returns a random float in the range [0, 1) at lattice point (x, y) */
+	inline float Float(uint32_t seed, uint32_t x, uint32_t y)
+	{
+		return ToFloat(Hash(seed, x, y));
+	}
+
+	/** Returns a random float in the range [0, 1) at lattice point (x, y, z) */
+	inline float Float(uint32_t seed, uint32_t x, uint32_t y, uint32_t z)
+	{
+		return ToFloat(Hash(seed, x, y, z));
+	}
+
+	/**
+	 * Writes the values of lattice points (0..count-1, y) to out, equal to Float(seed, x, y).
+	 * The row prefix is hashed once and the loop has no dependencies, so it vectorizes.
+	 */
+	inline void FillRow(uint32_t seed, uint32_t y, int count, float* out)
+	{
+		const uint32_t prefix = Permute(y ^ Permute(seed));
+		for(int x = 0; x < count; ++x)
+			out[x] = ToFloat(Permute(static_cast<uint32_t>(x) ^ prefix));
+	}
+
+	/** Writes the values of lattice points (x0..x0+count-1, y) to out; x wraps around at 2^32 */
+	inline void FillRowSpan(uint32_t seed, uint32_t y, uint32_t x0, int count, float* out)
+	{
+		const uint32_t prefix = Permute(y ^ Permute(seed));
+		for(int x = 0; x < count; ++x)
+			out[x] = ToFloat(Permute((x0 + static_cast<uint32_t>(x)) ^ prefix));
+	}
+
+	/** Writes the values of lattice points (0..count-1, y, z) to out, equal to Float(seed, x, y, z) */
+	inline void FillRow(uint32_t seed, uint32_t y, uint32_t z, int count, float* out)
+	{
+		const uint32_t prefix = Permute(y ^ Permute(z ^ Permute(seed)));
+		for(int x = 0; x < count; ++x)
+			out[x] = ToFloat(Permute(static_cast<uint32_t>(x) ^ prefix));
+	}
+}
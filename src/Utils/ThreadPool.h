@@ -0,0 +1,91 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * ThreadPool is a fixed-size pool of worker threads consuming a FIFO task queue.
+ * Tasks are fire-and-forget; callers synchronize on their own state.
+ */
+class ThreadPool
+{
+public:
+	/** Starts threadCount workers (at least one) */
+	explicit ThreadPool(unsigned int threadCount = std::thread::hardware_concurrency())
+	{
+		if(threadCount == 0) threadCount = 1;
+
+		workers.reserve(threadCount);
+		for(unsigned int i = 0; i < threadCount; ++i)
+		{
+			workers.emplace_back([this] { WorkerLoop(); });
+		}
+	}
+
+	/** Finishes the queued tasks and joins every worker */
+	~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bStopping = true;
+		}
+		condition.notify_all();
+
+		for(std::thread& worker : workers)
+		{
+			if(worker.joinable())
+				worker.join();
+		}
+	}
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/** Queues a task to be run by the next free worker */
+	void Enqueue(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			tasks.push(std::move(task));
+		}
+		condition.notify_one();
+	}
+
+	/** Returns the number of worker threads */
+	unsigned int GetThreadCount() const
+	{
+		return static_cast<unsigned int>(workers.size());
+	}
+
+private:
+	void WorkerLoop()
+	{
+		for(;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				condition.wait(lock, [this] { return bStopping || !tasks.empty(); });
+				if(tasks.empty())
+					return;
+
+				task = std::move(tasks.front());
+				tasks.pop();
+			}
+			task();
+		}
+	}
+
+	/** Worker threads owned by the pool */
+	std::vector<std::thread> workers;
+
+	/** Pending tasks, guarded by mutex */
+	std::queue<std::function<void()>> tasks;
+
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool bStopping = false;
+};
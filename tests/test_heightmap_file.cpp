@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+#include "Export/HeightmapFile.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseStream.h"
+#include "Utils/HalfFloat.h"
+
+namespace
+{
+	std::string TempPath(const char* name)
+	{
+		return (std::filesystem::temp_directory_path() / name).string();
+	}
+
+	std::vector<float> MakeRamp(int width, int height)
+	{
+		std::vector<float> data((size_t)width * height);
+		for(size_t i = 0; i < data.size(); ++i)
+			data[i] = (float)i / (float)(data.size() - 1);
+		return data;
+	}
+}
+
+TEST(HalfFloatTest, RoundTripsRepresentableValues)
+{
+	for(float value : { 0.0f, -0.0f, 1.0f, -2.5f, 0.333251953125f, 65504.0f, 6.103515625e-05f, 5.9604644775390625e-08f })
+		EXPECT_EQ(HalfFloat::ToFloat(HalfFloat::FromFloat(value)), value);
+
+	EXPECT_EQ(HalfFloat::FromFloat(1.0f), 0x3C00);
+	EXPECT_EQ(HalfFloat::FromFloat(100000.0f), 0x7C00);
+	EXPECT_TRUE(std::isnan(HalfFloat::ToFloat(HalfFloat::FromFloat(NAN))));
+}
+
+TEST(HeightmapFileTest, Float32RoundTripIsExactAndInPlace)
+{
+	const std::string path = TempPath("ng_test_float32.ngh");
+	const int width = 37, height = 21;
+	std::vector<float> data = MakeRamp(width, height);
+
+	NoiseProperties props{};
+	props.seed = -123456789;
+	props.roughness = 0.65f;
+	props.turbulence_offset_y = -0.25f;
+
+	ASSERT_TRUE(HeightmapFile::Save(path, data.data(), width, height, HeightmapFormat::Float32, &props));
+
+	HeightmapFile file;
+	ASSERT_TRUE(file.Open(path));
+	const HeightmapHeader& header = file.GetHeader();
+	EXPECT_EQ(header.width, width);
+	EXPECT_EQ(header.height, height);
+	EXPECT_EQ(header.format, HeightmapFormat::Float32);
+	EXPECT_TRUE(header.bHasProperties);
+	EXPECT_EQ(header.properties.seed, props.seed);
+	EXPECT_EQ(header.properties.roughness, props.roughness);
+	EXPECT_EQ(header.properties.turbulence_offset_y, props.turbulence_offset_y);
+
+	const float* pixels = file.GetFloatPixels();
+	ASSERT_NE(pixels, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(pixels) % 64, 0u);
+	EXPECT_EQ(memcmp(pixels, data.data(), data.size() * sizeof(float)), 0);
+	EXPECT_EQ(file.GetValue(5, 3), data[5 + 3 * width]);
+
+	file.Close();
+	std::remove(path.c_str());
+}
+
+TEST(HeightmapFileTest, PropertiesKeepTheNoiseDomain)
+{
+	const std::string path = TempPath("ng_test_domain.ngh");
+	const int res = 32;
+
+	NoiseProperties props{};
+	props.seed = 77;
+	props.roughness = 0.5f;
+	props.domain = NoiseDomain::Unbounded;
+	NoiseImage image = NG::FBMNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(image);
+	ASSERT_TRUE(HeightmapFile::Save(path, image.Data(), res, res, HeightmapFormat::Float32, &props));
+
+	HeightmapFile file;
+	ASSERT_TRUE(file.Open(path));
+	const NoiseProperties& loaded = file.GetHeader().properties;
+	EXPECT_EQ(loaded.domain, NoiseDomain::Unbounded);
+
+	// Regenerating from the stored settings reproduces the stored map
+	NoiseImage regenerated = NG::FBMNoise2D(res, &loaded, nullptr);
+	ASSERT_TRUE(regenerated);
+	EXPECT_EQ(memcmp(regenerated.Data(), file.GetFloatPixels(), regenerated.GetBytes()), 0);
+
+	file.Close();
+	std::remove(path.c_str());
+}
+
+TEST(HeightmapFileTest, SixteenBitFormatsDecodeWithinPrecision)
+{
+	const int width = 64, height = 16;
+	std::vector<float> data = MakeRamp(width, height);
+
+	for(HeightmapFormat format : { HeightmapFormat::Float16, HeightmapFormat::UInt16 })
+	{
+		const std::string path = TempPath("ng_test_16bit.ngh");
+		ASSERT_TRUE(HeightmapFile::Save(path, data.data(), width, height, format));
+
+		HeightmapFile file;
+		ASSERT_TRUE(file.Open(path));
+		EXPECT_EQ(file.GetHeader().format, format);
+		EXPECT_FALSE(file.GetHeader().bHasProperties);
+		EXPECT_EQ(file.GetFloatPixels(), nullptr);
+
+		std::vector<float> decoded(data.size());
+		file.ReadRows(0, height, decoded.data());
+		for(size_t i = 0; i < data.size(); ++i)
+			ASSERT_NEAR(decoded[i], data[i], format == HeightmapFormat::Float16 ? 1e-3f : 1e-5f);
+
+		file.Close();
+		std::remove(path.c_str());
+	}
+}
+
+TEST(HeightmapFileTest, WriterAcceptsStreamedStrips)
+{
+	const std::string path = TempPath("ng_test_stream.ngh");
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 9;
+	props.roughness = 0.5f;
+
+	HeightmapWriter writer;
+	ASSERT_TRUE(writer.Create(path, res, res, HeightmapFormat::Float32, &props));
+
+	NG::NoiseStreamOptions options;
+	options.stripRows = 10;
+	ASSERT_TRUE(NG::FBMNoise2DStream(res, &props, options, [&] (int y0, int rows, int, const float* strip)
+		{
+			return writer.WriteRows(y0, rows, strip);
+		}));
+	writer.Close();
+
+	HeightmapFile file;
+	ASSERT_TRUE(file.Open(path));
+	NoiseImage reference = NG::FBMNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(reference);
+	EXPECT_EQ(memcmp(file.GetFloatPixels(), reference.Data(), res * res * sizeof(float)), 0);
+
+	file.Close();
+	std::remove(path.c_str());
+}
+
+TEST(HeightmapFileTest, RejectsForeignFiles)
+{
+	const std::string path = TempPath("ng_test_invalid.ngh");
+	FILE* handle = fopen(path.c_str(), "wb");
+	ASSERT_NE(handle, nullptr);
+	const char junk[256] = "not a heightmap";
+	fwrite(junk, 1, sizeof(junk), handle);
+	fclose(handle);
+
+	HeightmapFile file;
+	EXPECT_FALSE(file.Open(path));
+	EXPECT_FALSE(file.IsOpen());
+	EXPECT_FALSE(file.Open(TempPath("ng_test_missing.ngh")));
+
+	std::remove(path.c_str());
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include "CLI/JobManifest.h"
+
+TEST(JobManifestTest, ParsesJobsWithDefaults)
+{
+	std::istringstream input(
+		"; farm batch\n"
+		"[defaults]\n"
+		"roughness = 0.7\n"
+		"seed = 11\n"
+		"\n"
+		"[mountains]\n"
+		"resolution = 2048\n"
+		"turbulence = 0.25   # trailing comment\n"
+		"output = out/mountains.ngh\n"
+		"format = uint16\n"
+		"domain = Unbounded\n"
+		"\n"
+		"[cells]\n"
+		"algorithm = Worley\n"
+		"feature = f2-f1\n"
+		"seed = 3\n"
+		"output = cells.png\n");
+
+	JobManifest manifest;
+	ASSERT_TRUE(manifest.Parse(input)) << manifest.GetError();
+	ASSERT_EQ(manifest.GetJobs().size(), 2u);
+
+	const NoiseJob& mountains = manifest.GetJobs()[0];
+	EXPECT_EQ(mountains.name, "mountains");
+	EXPECT_EQ(mountains.algorithm, NoiseAlgorithm::FBM);
+	EXPECT_EQ(mountains.resolution, 2048);
+	EXPECT_EQ(mountains.props.res, 8);
+	EXPECT_EQ(mountains.props.seed, 11);
+	EXPECT_FLOAT_EQ(mountains.props.roughness, 0.7f);
+	EXPECT_FLOAT_EQ(mountains.props.turbulence, 0.25f);
+	EXPECT_EQ(mountains.heightmapFormat, HeightmapFormat::UInt16);
+	EXPECT_EQ(mountains.props.domain, NoiseDomain::Unbounded);
+	EXPECT_EQ(mountains.output, "out/mountains.ngh");
+
+	const NoiseJob& cells = manifest.GetJobs()[1];
+	EXPECT_EQ(cells.algorithm, NoiseAlgorithm::Worley);
+	EXPECT_EQ(cells.worleyFeature, NG::WorleyFeature::F2MinusF1);
+	EXPECT_EQ(cells.resolution, 512);
+	EXPECT_EQ(cells.props.seed, 3);
+	EXPECT_FLOAT_EQ(cells.props.roughness, 0.7f);
+	EXPECT_EQ(cells.props.domain, NoiseDomain::Tiled);
+}
+
+TEST(JobManifestTest, ReportsErrorsWithLineNumbers)
+{
+	const struct { const char* text; const char* expected; } cases[] =
+	{
+		{ "[a]\nresolution = 1000\noutput = a.png\n", "power of two" },
+		{ "[a]\nroughness = 0.5x\noutput = a.png\n", "test:2: invalid value" },
+		{ "[a]\ncolour = red\n", "test:2: unknown key" },
+		{ "[a]\ndomain = infinite\n", "test:2: unknown domain" },
+		{ "[a]\noutput = a.png\n[a]\noutput = b.png\n", "duplicate job" },
+		{ "[a]\noutput = a.jpg\n", "output must end in" },
+		{ "[a]\nturbulence_res = 30\noutput = a.png\n", "test:3: job 'a': turbulence_res must be in" },
+		{ "[a]\nturbulence_res = -1\noutput = a.png\n", "turbulence_res must be in" },
+		{ "[a]\nlow_freq_skip = -2\noutput = a.png\n[b]\n", "test:4: job 'a': frequency skips" },
+		{ "[a]\nturbulence_high_freq_skip = -1\noutput = a.png\n", "frequency skips must not be negative" },
+		{ "seed = 1\n", "outside of a job section" },
+		{ "[defaults]\nseed = 1\n", "no jobs" },
+	};
+
+	for(const auto& test : cases)
+	{
+		std::istringstream input(test.text);
+		JobManifest manifest;
+		EXPECT_FALSE(manifest.Parse(input, "test")) << test.text;
+		EXPECT_NE(manifest.GetError().find(test.expected), std::string::npos) << manifest.GetError();
+	}
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "Memory/MemoryTracker.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseRegion.h"
+#include "Noise/OctaveKernel.h"
+
+namespace
+{
+	/** Restores an unlimited budget when a test ends */
+	struct BudgetGuard
+	{
+		~BudgetGuard() { MemoryTracker::Get().SetBudget(0); }
+	};
+}
+
+TEST(MemoryTrackerTest, JobTracksPeakAndHandsOverResults)
+{
+	MemoryTracker& tracker = MemoryTracker::Get();
+	const int64_t before = tracker.GetCurrentBytes();
+
+	void* result = nullptr;
+	{
+		MemoryJobScope job("Test job", 0);
+		MemoryJob* outer = MemoryTracker::GetCurrentJob();
+		ASSERT_NE(outer, nullptr);
+
+		void* scratch = tracker.Allocate(1000);
+		{
+			// A nested scope joins the running job
+			MemoryJobScope nested("Nested", 0);
+			EXPECT_EQ(MemoryTracker::GetCurrentJob(), outer);
+			result = tracker.Allocate(500, true);
+		}
+		EXPECT_EQ(tracker.GetCurrentBytes(), before + 1500);
+
+		{
+			TrackedVector<float> values(100);
+			EXPECT_EQ(tracker.GetCurrentBytes(), before + 1500 + 400);
+		}
+		tracker.Free(scratch);
+		EXPECT_EQ(job.GetPeakBytes(), 1900);
+	}
+
+	// The result left the job with its owner and stays counted until it is released
+	EXPECT_EQ(tracker.GetCurrentBytes(), before + 500);
+	EXPECT_EQ(MemoryTracker::GetCurrentJob(), nullptr);
+	tracker.Free(result);
+	EXPECT_EQ(tracker.GetCurrentBytes(), before);
+
+	const std::vector<MemoryJobReport> jobs = tracker.GetRecentJobs();
+	ASSERT_FALSE(jobs.empty());
+	EXPECT_EQ(jobs.back().name, "Test job");
+	EXPECT_EQ(jobs.back().peakBytes, 1900);
+}
+
+TEST(MemoryTrackerTest, EstimateCoversTurbulencePeak)
+{
+	NoiseProperties props{};
+	props.seed = 11;
+	props.roughness = 0.5f;
+	props.turbulence = 0.5f;
+	props.turbulence_res = 4;
+	props.turbulence_roughness = 0.5f;
+
+	NoiseExecution exec;
+	exec.threadCount = 2;
+	const int res = 256;
+	NG::FBMNoise2D(res, &props, nullptr, exec);
+
+	const MemoryJobReport report = MemoryTracker::Get().GetRecentJobs().back();
+	EXPECT_EQ(report.name, "FBMNoise2D");
+	EXPECT_EQ(report.reservedBytes, NG::EstimateFBMNoise2DBytes(res, &props));
+
+	// The image, its warp copy and both 128^2 fields are live at once
+	EXPECT_GE(report.peakBytes, (int64_t)(2 * res * res + 2 * 128 * 128) * (int64_t)sizeof(float));
+	EXPECT_LE(report.peakBytes, (int64_t)report.reservedBytes);
+}
+
+TEST(MemoryTrackerTest, OctavesStoreNoLattice)
+{
+	NoiseProperties props{};
+	props.seed = 3;
+	props.roughness = 0.5f;
+
+	const int res = 512;
+	NG::FBMNoise2D(res, &props, nullptr);
+
+	// Lattice rows are hashed per band, stored lattices would add 4/3 of the image
+	const MemoryJobReport report = MemoryTracker::Get().GetRecentJobs().back();
+	EXPECT_EQ(report.name, "FBMNoise2D");
+	EXPECT_LE(report.peakBytes, (int64_t)report.reservedBytes);
+	EXPECT_LT(report.reservedBytes, (uint64_t)res * res * sizeof(float) + NG::EstimateOctaveStackBytes(res, &props, NG::LatticeStorage::Stored));
+}
+
+TEST(MemoryTrackerTest, RegionEstimateCoversAWideWarp)
+{
+	NoiseProperties props{};
+	props.seed = 5;
+	props.roughness = 0.5f;
+	props.turbulence = 48.0f;
+	props.turbulence_res = 4;
+	props.turbulence_roughness = 0.5f;
+	props.turbulence_expshift = -3.0f;
+
+	// The exponent pushes the field to +-1: targets up to 192 pixels away from a 64^2 window,
+	// far outside the tiles next to it
+	const int res = 256, width = 64, height = 64;
+	const uint64_t estimate = NG::EstimateRegionBytes(res, &props, width, height);
+	std::vector<float> out((size_t)width * height);
+
+	MemoryJobScope job("Region", estimate);
+	ASSERT_TRUE(NG::GenerateRegion(res, &props, 1000, -300, width, height, out.data(), width));
+	EXPECT_GT(job.GetPeakBytes(), (int64_t)((width + 128) * (height + 128) * sizeof(float)));
+	EXPECT_LE(job.GetPeakBytes(), (int64_t)estimate);
+}
+
+TEST(MemoryTrackerTest, BudgetErrorsAndQueueing)
+{
+	BudgetGuard guard;
+	MemoryTracker& tracker = MemoryTracker::Get();
+
+	// Larger than the whole budget: refused under both policies
+	tracker.SetBudget(1 << 20, MemoryBudgetPolicy::Queue);
+	EXPECT_THROW(MemoryJobScope("Huge", 2 << 20), MemoryBudgetError);
+
+	NoiseProperties props{};
+	props.roughness = 0.5f;
+	EXPECT_THROW(NG::FBMNoise2D(1024, &props, nullptr), MemoryBudgetError);
+
+	// Does not fit next to a running job: refused, or admitted once the job ends
+	std::atomic<bool> bAdmitted{ false };
+	std::thread waiting;
+	{
+		MemoryJobScope running("Running", 600 << 10);
+
+		tracker.SetBudget(1 << 20, MemoryBudgetPolicy::Refuse);
+		std::thread refused([&]
+			{
+				EXPECT_THROW(MemoryJobScope("Refused", 600 << 10), MemoryBudgetError);
+			});
+		refused.join();
+
+		tracker.SetBudget(1 << 20, MemoryBudgetPolicy::Queue);
+		waiting = std::thread([&]
+			{
+				MemoryJobScope queued("Queued", 600 << 10);
+				bAdmitted = true;
+			});
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		EXPECT_FALSE(bAdmitted);
+		EXPECT_EQ(tracker.GetReservedBytes(), 600u << 10);
+	}
+	waiting.join();
+	EXPECT_TRUE(bAdmitted);
+	EXPECT_EQ(tracker.GetReservedBytes(), 0u);
+}
+
+TEST(MemoryTrackerTest, ReclaimersFreeCachedMemoryForAJob)
+{
+	BudgetGuard guard;
+	MemoryTracker& tracker = MemoryTracker::Get();
+
+	// A cache outside of jobs, released on request
+	auto cached = std::make_unique<TrackedVector<char>>(512 << 10);
+	uint64_t requested = 0;
+	const uint64_t id = tracker.AddReclaimer([&] (uint64_t bytes)
+		{
+			requested = bytes;
+			const uint64_t released = cached ? cached->size() : 0;
+			cached.reset();
+			return released;
+		});
+
+	// Fits next to the cache: nothing is reclaimed
+	tracker.SetBudget(tracker.GetCurrentBytes() + (512 << 10), MemoryBudgetPolicy::Refuse);
+	{
+		MemoryJobScope small("Small", 256 << 10);
+	}
+	EXPECT_TRUE(cached);
+
+	{
+		MemoryJobScope large("Large", 768 << 10);
+		EXPECT_FALSE(cached);
+		EXPECT_GE(requested, 256u << 10);
+	}
+
+	tracker.RemoveReclaimer(id);
+	EXPECT_EQ(tracker.Reclaim(1 << 20), 0u);
+}
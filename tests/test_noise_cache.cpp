@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include "Noise/NoiseCache.h"
+#include "Noise/NoiseGenerator.h"
+#include "Memory/MemoryTracker.h"
+
+namespace
+{
+	NoiseProperties MakeProps()
+	{
+		NoiseProperties props = {};
+		props.seed = 1234;
+		props.roughness = 0.5f;
+		props.low_freq_skip = 1;
+		props.high_freq_skip = 1;
+		return props;
+	}
+
+	NoiseImage MakeImage(int res, float value)
+	{
+		NoiseImage image(res, res);
+		for(size_t i = 0; i < image.GetCount(); i++)
+			image[i] = value + (float)i;
+		return image;
+	}
+}
+
+TEST(NoiseCacheTest, KeyCoversExactlyTheInputsGeneratorsUse)
+{
+	const NoiseProperties props = MakeProps();
+	const NoiseCacheKey key = NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props);
+	EXPECT_EQ(key, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props));
+	EXPECT_EQ(key.hash, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props).hash);
+	EXPECT_EQ(key.ToHex().size(), 16u);
+
+	NoiseProperties changed = props;
+	changed.seed++;
+	EXPECT_NE(key, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, changed));
+	EXPECT_NE(key, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 128, props));
+	EXPECT_NE(key, NoiseCache::MakeKey(NoiseAlgorithm::Worley, 64, props));
+
+	changed = props;
+	changed.marbling = 0.25f;
+	EXPECT_NE(key, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, changed));
+
+	// Ignored inputs: the GUI resolution index, -0 and turbulence settings without turbulence
+	changed = props;
+	changed.res = 7;
+	changed.marbling = -0.0f;
+	changed.turbulence_res = 5;
+	changed.turbulence_offset_x = 0.5f;
+	EXPECT_EQ(key, NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, changed));
+
+	changed.turbulence = 2.0f;
+	NoiseProperties moved = changed;
+	moved.turbulence_offset_x = 0.25f;
+	EXPECT_NE(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, changed), NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, moved));
+
+	// Worley has no roughness, FBM no feature
+	changed = props;
+	changed.roughness = 0.9f;
+	EXPECT_EQ(NoiseCache::MakeKey(NoiseAlgorithm::Worley, 64, props), NoiseCache::MakeKey(NoiseAlgorithm::Worley, 64, changed));
+	EXPECT_NE(NoiseCache::MakeKey(NoiseAlgorithm::Worley, 64, props, NG::WorleyFeature::F1),
+		NoiseCache::MakeKey(NoiseAlgorithm::Worley, 64, props, NG::WorleyFeature::F2));
+	EXPECT_EQ(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props, NG::WorleyFeature::F1),
+		NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props, NG::WorleyFeature::F2));
+}
+
+TEST(NoiseCacheTest, RepeatedRequestIsServedFromMemory)
+{
+	NoiseCache cache;
+	const NoiseProperties props = MakeProps();
+	const NoiseCacheKey key = NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props);
+
+	int generated = 0;
+	auto generate = [&] ()
+		{
+			generated++;
+			return NG::FBMNoise2D(64, &props, nullptr);
+		};
+
+	auto first = cache.FindOrGenerate(key, generate);
+	auto second = cache.FindOrGenerate(key, generate);
+	ASSERT_TRUE(first);
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(generated, 1);
+	EXPECT_EQ(cache.GetHitCount(), 1u);
+	EXPECT_EQ(cache.GetMissCount(), 1u);
+	EXPECT_EQ(cache.GetBytes(), first->GetBytes());
+
+	NoiseImage fresh = NG::FBMNoise2D(64, &props, nullptr);
+	EXPECT_EQ(memcmp(fresh.Data(), first->Data(), fresh.GetBytes()), 0);
+
+	// Canceled generations are not cached
+	NoiseProperties other = props;
+	other.seed = 99;
+	EXPECT_FALSE(cache.FindOrGenerate(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, other), [] () { return NoiseImage(); }));
+	EXPECT_EQ(cache.GetEntryCount(), 1u);
+}
+
+TEST(NoiseCacheTest, EvictsLeastRecentlyUsedOverCapacity)
+{
+	const uint64_t imageBytes = 32 * 32 * sizeof(float);
+	NoiseCache cache(2 * imageBytes);
+
+	NoiseProperties props = MakeProps();
+	NoiseCacheKey keys[3];
+	for(int i = 0; i < 3; i++)
+	{
+		props.seed = i;
+		keys[i] = NoiseCache::MakeKey(NoiseAlgorithm::FBM, 32, props);
+	}
+
+	cache.Insert(keys[0], MakeImage(32, 0.0f));
+	cache.Insert(keys[1], MakeImage(32, 1.0f));
+	EXPECT_TRUE(cache.Find(keys[0]));
+	cache.Insert(keys[2], MakeImage(32, 2.0f));
+
+	EXPECT_EQ(cache.GetEntryCount(), 2u);
+	EXPECT_EQ(cache.GetBytes(), 2 * imageBytes);
+	EXPECT_TRUE(cache.Find(keys[0]));
+	EXPECT_FALSE(cache.Find(keys[1]));
+	EXPECT_TRUE(cache.Find(keys[2]));
+
+	// Larger than the whole capacity: returned but not kept
+	auto large = cache.Insert(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props), MakeImage(64, 0.0f));
+	ASSERT_TRUE(large);
+	EXPECT_EQ(cache.GetEntryCount(), 2u);
+
+	cache.SetCapacity(imageBytes);
+	EXPECT_EQ(cache.GetEntryCount(), 1u);
+	cache.Clear();
+	EXPECT_EQ(cache.GetBytes(), 0u);
+}
+
+TEST(NoiseCacheTest, BudgetedJobEvictsCachedMaps)
+{
+	MemoryTracker& tracker = MemoryTracker::Get();
+	const uint64_t imageBytes = 64 * 64 * sizeof(float);
+	NoiseCache cache;
+
+	NoiseProperties props = MakeProps();
+	for(int i = 0; i < 4; i++)
+	{
+		props.seed = i;
+		cache.Insert(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props), MakeImage(64, (float)i));
+	}
+	ASSERT_EQ(cache.GetBytes(), 4 * imageBytes);
+
+	// Room for the job only once two of the four maps are gone
+	tracker.SetBudget((uint64_t)tracker.GetCurrentBytes() - 2 * imageBytes + (64 << 10), MemoryBudgetPolicy::Refuse);
+	{
+		MemoryJobScope job("Job", 64 << 10);
+		EXPECT_EQ(cache.GetEntryCount(), 2u);
+	}
+	tracker.SetBudget(0);
+
+	// The most recently inserted maps are kept
+	props.seed = 3;
+	EXPECT_TRUE(cache.Find(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props)));
+	props.seed = 0;
+	EXPECT_FALSE(cache.Find(NoiseCache::MakeKey(NoiseAlgorithm::FBM, 64, props)));
+}
+
+TEST(NoiseCacheTest, DiskTierSurvivesANewCache)
+{
+	const std::filesystem::path folder = std::filesystem::temp_directory_path() / "ng_test_cache";
+	std::filesystem::remove_all(folder);
+
+	const NoiseCacheKey key = NoiseCache::MakeKey(NoiseAlgorithm::Worley, 32, MakeProps());
+	{
+		NoiseCache cache;
+		cache.SetDirectory(folder.string());
+		ASSERT_TRUE(cache.Insert(key, MakeImage(32, 5.0f)));
+		EXPECT_TRUE(std::filesystem::exists(folder / (key.ToHex() + NoiseCache::Extension)));
+	}
+
+	NoiseCache cache(0);
+	cache.SetDirectory(folder.string());
+	auto loaded = cache.Find(key);
+	ASSERT_TRUE(loaded);
+	EXPECT_EQ(cache.GetDiskHitCount(), 1u);
+	EXPECT_EQ(cache.GetHitCount(), 0u);
+	ASSERT_EQ(loaded->GetWidth(), 32);
+	ASSERT_EQ(loaded->GetHeight(), 32);
+	NoiseImage expected = MakeImage(32, 5.0f);
+	EXPECT_EQ(memcmp(expected.Data(), loaded->Data(), expected.GetBytes()), 0);
+
+	// A different key never reads the entry, even under a colliding file name
+	NoiseCacheKey other = NoiseCache::MakeKey(NoiseAlgorithm::FBM, 32, MakeProps());
+	std::filesystem::copy_file(folder / (key.ToHex() + NoiseCache::Extension), folder / (other.ToHex() + NoiseCache::Extension));
+	EXPECT_FALSE(cache.Find(other));
+	EXPECT_EQ(cache.GetMissCount(), 1u);
+
+	std::filesystem::remove_all(folder);
+}
@@ -1,6 +1,19 @@
 #include <gtest/gtest.h>
 #include <functional>
+#include <cstring>
 #include "Noise/NoiseGenerator.h" 
+#include "Noise/OctaveKernel.h"
+#include "Noise/NoiseStream.h"
+#include "Noise/NoiseRegion.h"
+#include "Noise/NoiseQuery.h"
+#include "Noise/NoisePipeline.h"
+#include "Memory/MemoryTracker.h"
+#include "Noise/NoiseMath.h"
+#include "Utils/RandomGenerator.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <thread>
 
 using namespace NG;
 
@@ -8,16 +21,14 @@ TEST(StupidNoiseTest, StupidNoise2D_BasicOutput)
 {
 	const int res = 16;
 	const int freq = 4;
-	float* result = StupidNoise2D(res, freq, nullptr, 1.0f, 12345);
-	ASSERT_NE(result, nullptr);
+	NoiseImage result = StupidNoise2D(res, freq, {}, 1.0f, 12345);
+	ASSERT_TRUE(result);
 
 	for(int i = 0; i < res * res; ++i)
 	{
 		EXPECT_GE(result[i], 0.0f);
 		EXPECT_LE(result[i], 1.0f);
 	}
-
-	free(result);
 }
 
 TEST(FBMNoiseTest, BasicGeneration)
@@ -31,16 +42,14 @@ TEST(FBMNoiseTest, BasicGeneration)
 	props.turbulence = 0.0f;
 	props.marbling = 0.0f;
 
-	float* result = FBMNoise2D(res, &props, nullptr);
-	ASSERT_NE(result, nullptr);
+	NoiseImage result = FBMNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(result);
 
 	for(int i = 0; i < res * res; ++i)
 	{
 		EXPECT_GE(result[i], 0.0f);
 		EXPECT_LE(result[i], 1.0f);
 	}
-
-	free(result);
 }
 
 TEST(FBMNoiseTest, CancelByProgress)
@@ -60,8 +69,8 @@ TEST(FBMNoiseTest, CancelByProgress)
 		return false;
 		};
 
-	float* result = FBMNoise2D(res, &props, cancelAtStart);
-	EXPECT_EQ(result, nullptr);
+	NoiseImage result = FBMNoise2D(res, &props, cancelAtStart);
+	EXPECT_TRUE(result.IsEmpty());
 	EXPECT_TRUE(called);
 }
 
@@ -75,22 +84,713 @@ TEST(WorleyNoiseTest, GeneratesSuccessfully)
 	props.turbulence = 0.0f;
 	props.marbling = 0.0f;
 
-	float* data = WorleyNoise2D(res, &props, nullptr);
-	ASSERT_NE(data, nullptr);
+	NoiseImage data = WorleyNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(data);
 
 	for(int i = 0; i < res * res; ++i)
 	{
 		EXPECT_GE(data[i], 0.0f);
 		EXPECT_LE(data[i], 1.0f);
 	}
-
-	free(data);
 }
 
 TEST(StupidNoiseTest, ZeroFrequencyThrows)
 {
 	EXPECT_THROW(
 		{
-		StupidNoise2D(16, 0, nullptr, 1.0f, 123);
+		StupidNoise2D(16, 0, {}, 1.0f, 123);
 		}, std::invalid_argument);
-}
\ No newline at end of file
+}
+TEST(FBMNoiseTest, ParallelMatchesSerial)
+{
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 1234;
+	props.roughness = 0.6f;
+	props.marbling = 2.0f;
+	props.turbulence = 12.0f;
+	props.turbulence_res = 2;
+	props.turbulence_roughness = 0.5f;
+	props.turbulence_expshift = 0.5f;
+	props.turbulence_offset_x = 0.1f;
+
+	NoiseExecution parallel;
+	parallel.threadCount = 4;
+
+	NoiseImage serial = FBMNoise2D(res, &props, nullptr);
+	NoiseImage threaded = FBMNoise2D(res, &props, nullptr, parallel);
+	ASSERT_TRUE(serial);
+	ASSERT_TRUE(threaded);
+
+	EXPECT_EQ(memcmp(serial.Data(), threaded.Data(), res * res * sizeof(float)), 0);
+}
+
+TEST(FBMNoiseTest, ParallelCancelByProgress)
+{
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 42;
+	props.roughness = 0.5f;
+
+	NoiseExecution parallel;
+	parallel.threadCount = 4;
+
+	// Helper threads may finish every band before the caller reports, so the octave pass is only
+	// guaranteed one call (its final 1.0). The second call therefore always lands in a place
+	// that must stop the generation, and no call may follow it.
+	int calls = 0;
+	NoiseImage result = FBMNoise2D(res, &props, [&] (float) { return ++calls < 2; }, parallel);
+	EXPECT_TRUE(result.IsEmpty());
+	EXPECT_EQ(calls, 2);
+}
+
+TEST(OctaveKernelTest, FusedMatchesPerOctavePasses)
+{
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 99;
+	props.roughness = 0.7f;
+	props.low_freq_skip = 1;
+	props.high_freq_skip = 1;
+
+	std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props);
+	ASSERT_FALSE(layers.empty());
+
+	NoiseImage reference;
+	for(const OctaveLayer& layer : layers)
+		reference = StupidNoise2D(res, layer.freq, std::move(reference), layer.scale, layer.seed);
+
+	std::vector<float> fused(res * res, -1.0f);
+	EvaluateOctaves2D(layers, res, 0, 0, res, res, fused.data(), res);
+
+	EXPECT_EQ(memcmp(reference.Data(), fused.data(), res * res * sizeof(float)), 0);
+}
+
+TEST(OctaveKernelTest, SubRectangleMatchesFullImage)
+{
+	const int res = 128;
+	NoiseProperties props{};
+	props.seed = 5;
+	props.roughness = 0.5f;
+
+	std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props);
+
+	std::vector<float> full(res * res);
+	EvaluateOctaves2D(layers, res, 0, 0, res, res, full.data(), res);
+
+	const int x0 = 37, y0 = 11, x1 = 101, y1 = 90;
+	std::vector<float> part((x1 - x0) * (y1 - y0));
+	EvaluateOctaves2D(layers, res, x0, y0, x1, y1, part.data(), x1 - x0);
+
+	for(int y = y0; y < y1; ++y)
+		for(int x = x0; x < x1; ++x)
+			ASSERT_EQ(part[(x - x0) + (y - y0) * (x1 - x0)], full[x + y * res]);
+}
+
+TEST(WorleyGridTest, MatchesBruteForce)
+{
+	RandomGenerator rng(99);
+	std::vector<std::pair<float, float>> points;
+	for(int i = 0; i < 300; ++i)
+		points.emplace_back(rng.NextFloat(), rng.NextFloat());
+	points.emplace_back(1.0f, 1.0f);
+	points.emplace_back(0.0f, 1.0f);
+
+	WorleyGrid grid;
+	grid.Build(points);
+	ASSERT_EQ(grid.GetPointCount(), (int)points.size());
+
+	const int res = 97;
+	for(int y = 0; y < res; ++y)
+	{
+		for(int x = 0; x < res; ++x)
+		{
+			const float fx = (float)x / res;
+			const float fy = (float)y / res;
+
+			std::vector<float> distances;
+			for(const auto& [px, py] : points)
+				distances.push_back(Distance(fx, fy, px, py));
+			std::partial_sort(distances.begin(), distances.begin() + 2, distances.end());
+
+			float f1, f2;
+			grid.Query(fx, fy, f1, f2);
+			ASSERT_EQ(f1, distances[0]) << "at " << x << ", " << y;
+			ASSERT_EQ(f2, distances[1]) << "at " << x << ", " << y;
+		}
+	}
+}
+
+TEST(WorleyGridTest, JitteredHasOnePointPerCell)
+{
+	WorleyGrid grid;
+	grid.BuildJittered(8, 5);
+	EXPECT_EQ(grid.GetCellsPerAxis(), 8);
+	EXPECT_EQ(grid.GetPointCount(), 64);
+
+	float f1, f2;
+	grid.Query(0.5f, 0.5f, f1, f2);
+	EXPECT_LE(f1, f2);
+	// The nearest point can never be further than the cell diagonal
+	EXPECT_LT(f1, 2.0f * sqrtf(2.0f) / 8.0f);
+}
+
+TEST(WorleyNoiseTest, FeaturesAreNormalized)
+{
+	const int res = 32;
+	NoiseProperties props{};
+	props.seed = 11;
+
+	for(WorleyFeature feature : { WorleyFeature::F1, WorleyFeature::F2, WorleyFeature::F2MinusF1 })
+	{
+		NoiseImage data = WorleyNoise2D(res, &props, nullptr, feature);
+		ASSERT_TRUE(data);
+
+		const auto [lo, hi] = std::minmax_element(data.Data(), data.Data() + res * res);
+		EXPECT_FLOAT_EQ(*lo, 0.0f);
+		EXPECT_FLOAT_EQ(*hi, 1.0f);
+	}
+}
+
+TEST(WorleyNoiseTest, ConcurrentCallsAreDeterministic)
+{
+	const int res = 48;
+	NoiseProperties props{};
+	props.seed = 21;
+	props.low_freq_skip = 2;
+
+	NoiseImage reference = WorleyNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(reference);
+
+	// Interleaved generations with other seeds must not disturb each other's points
+	std::vector<NoiseImage> results(4);
+	std::vector<std::thread> workers;
+	for(size_t i = 0; i < results.size(); ++i)
+	{
+		workers.emplace_back([&, i]
+			{
+				NoiseProperties local = props;
+				if(i % 2) local.seed = props.seed + (long)i;
+				results[i] = WorleyNoise2D(res, &local, nullptr);
+			});
+	}
+	for(std::thread& worker : workers)
+		worker.join();
+
+	for(size_t i = 0; i < results.size(); i += 2)
+	{
+		ASSERT_TRUE(results[i]);
+		EXPECT_EQ(memcmp(reference.Data(), results[i].Data(), res * res * sizeof(float)), 0);
+	}
+}
+
+TEST(OctaveKernelTest, OnDemandLatticeMatchesStored)
+{
+	const int res = 128;
+	NoiseProperties props{};
+	props.seed = 17;
+	props.roughness = 0.6f;
+
+	std::vector<OctaveLayer> stored = BuildOctaveStack(res, &props, {}, LatticeStorage::Stored);
+	std::vector<OctaveLayer> onDemand = BuildOctaveStack(res, &props);
+	ASSERT_FALSE(stored.back().IsOnDemand());
+	ASSERT_TRUE(onDemand.back().IsOnDemand());
+
+	std::vector<float> a(res * res), b(res * res);
+	EvaluateOctaves2D(stored, res, 0, 0, res, res, a.data(), res);
+	EvaluateOctaves2D(onDemand, res, 0, 0, res, res, b.data(), res);
+	EXPECT_EQ(memcmp(a.data(), b.data(), a.size() * sizeof(float)), 0);
+}
+
+TEST(OctaveKernelTest, UnboundedChunksJoinSeamlessly)
+{
+	const int res = 128;
+	NoiseProperties props{};
+	props.seed = 23;
+	props.roughness = 0.6f;
+	props.domain = NoiseDomain::Unbounded;
+
+	std::vector<OctaveLayer> layers = BuildOctaveStack(res, &props, {}, LatticeStorage::Stored);
+	ASSERT_TRUE(layers.back().IsOnDemand());
+	EXPECT_EQ(EstimateOctaveStackBytes(res, &props, LatticeStorage::Stored), 0u);
+
+	// World rectangle around the origin, far wider than res
+	const int64_t x0 = -300, y0 = -70, x1 = 333, y1 = 90;
+	const int width = (int)(x1 - x0);
+	std::vector<float> whole((size_t)width * (y1 - y0));
+	EvaluateOctaves2D(layers, res, x0, y0, x1, y1, whole.data(), width);
+
+	// Uneven chunks, straddling the origin and the kernel's tile edges
+	const int64_t xs[] = { x0, -129, -1, 0, 255, 300, x1 };
+	const int64_t ys[] = { y0, -17, 5, 37, y1 };
+	for(size_t cy = 0; cy + 1 < std::size(ys); ++cy)
+	{
+		for(size_t cx = 0; cx + 1 < std::size(xs); ++cx)
+		{
+			const int chunkWidth = (int)(xs[cx + 1] - xs[cx]);
+			std::vector<float> chunk((size_t)chunkWidth * (ys[cy + 1] - ys[cy]));
+			EvaluateOctaves2D(layers, res, xs[cx], ys[cy], xs[cx + 1], ys[cy + 1], chunk.data(), chunkWidth);
+
+			for(int64_t y = ys[cy]; y < ys[cy + 1]; ++y)
+				for(int64_t x = xs[cx]; x < xs[cx + 1]; ++x)
+					ASSERT_EQ(chunk[(x - xs[cx]) + (y - ys[cy]) * chunkWidth], whole[(x - x0) + (y - y0) * width]) << "at " << x << ", " << y;
+		}
+	}
+
+	// No period: one image further along the world is different noise
+	int repeats = 0;
+	for(int x = 0; x < 32; ++x)
+		repeats += whole[(x - x0) + (0 - y0) * width] == whole[(x + res - x0) + (0 - y0) * width];
+	EXPECT_LT(repeats, 4);
+}
+
+namespace
+{
+	/** Streams props and checks the strips reassemble into exactly the FBMNoise2D image */
+	void ExpectStreamMatchesFBM(int res, const NoiseProperties& props, const NoiseStreamOptions& options)
+	{
+		NoiseImage reference = FBMNoise2D(res, &props, nullptr);
+		ASSERT_TRUE(reference);
+
+		std::vector<float> streamed(res * res, -1.0f);
+		int nextRow = 0;
+		const bool bCompleted = FBMNoise2DStream(res, &props, options, [&] (int y0, int rows, int width, const float* strip)
+			{
+				EXPECT_EQ(y0, nextRow);
+				EXPECT_EQ(width, res);
+				EXPECT_LE(rows, options.stripRows);
+				memcpy(streamed.data() + (size_t)y0 * res, strip, (size_t)rows * width * sizeof(float));
+				nextRow = y0 + rows;
+				return true;
+			});
+
+		EXPECT_TRUE(bCompleted);
+		EXPECT_EQ(nextRow, res);
+		EXPECT_EQ(memcmp(reference.Data(), streamed.data(), res * res * sizeof(float)), 0);
+	}
+}
+
+TEST(NoiseStreamTest, StripsMatchFBMNoise2D)
+{
+	NoiseProperties props{};
+	props.seed = 8;
+	props.roughness = 0.5f;
+	props.marbling = 1.5f;
+
+	NoiseStreamOptions options;
+	options.stripRows = 13;
+	ExpectStreamMatchesFBM(100, props, options);
+}
+
+TEST(NoiseStreamTest, TurbulenceMatchesFBMNoise2D)
+{
+	NoiseProperties props{};
+	props.seed = 4;
+	props.roughness = 0.55f;
+	props.turbulence = 40.0f;
+	props.turbulence_res = 2;
+	props.turbulence_roughness = 0.5f;
+	props.turbulence_offset_y = 0.3f;
+
+	// Small strips make the warp reach far outside them, past the source rows kept between strips
+	NoiseStreamOptions options;
+	options.stripRows = 3;
+	options.exec.threadCount = 0;
+	ExpectStreamMatchesFBM(96, props, options);
+
+	// A short warp: every strip finds most of its source rows in the window
+	props.turbulence = 2.0f;
+	options.stripRows = 8;
+	ExpectStreamMatchesFBM(96, props, options);
+}
+
+TEST(NoiseStreamTest, KnownRangeSkipsFirstPassAndSinkCancels)
+{
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 2;
+	props.roughness = 0.5f;
+
+	NoiseStreamOptions options;
+	options.stripRows = 16;
+	options.bKnownRange = true;
+	options.rangeMin = -1.0f;
+	options.rangeMax = 3.0f;
+
+	int strips = 0;
+	float lastProgress = 0.0f;
+	EXPECT_TRUE(FBMNoise2DStream(res, &props, options, [&] (int, int, int, const float*) { return ++strips > 0; },
+		[&] (float progress) { lastProgress = progress; return true; }));
+	EXPECT_EQ(strips, res / options.stripRows);
+	EXPECT_FLOAT_EQ(lastProgress, 1.0f);
+
+	EXPECT_FALSE(FBMNoise2DStream(res, &props, options, [] (int, int, int, const float*) { return false; }));
+}
+
+TEST(NoiseStreamTest, UnboundedMatchesFBMNoise2D)
+{
+	const int res = 64;
+	NoiseProperties props{};
+	props.seed = 31;
+	props.roughness = 0.5f;
+	props.low_freq_skip = 1;
+	props.domain = NoiseDomain::Unbounded;
+
+	// Fixed range: every value stays in [0, 1] without being stretched to it
+	NoiseImage image = FBMNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(image);
+	const auto [lo, hi] = std::minmax_element(image.Data(), image.Data() + image.GetCount());
+	EXPECT_GE(*lo, 0.0f);
+	EXPECT_LE(*hi, 1.0f);
+	EXPECT_LT(*hi - *lo, 1.0f);
+
+	props.marbling = 0.75f;
+	props.turbulence = 20.0f;
+	props.turbulence_res = 1;
+	props.turbulence_roughness = 0.5f;
+	NoiseStreamOptions options;
+	options.stripRows = 10;
+	ExpectStreamMatchesFBM(res, props, options);
+}
+
+namespace
+{
+	NoiseProperties MakeRegionProperties(NoiseDomain domain)
+	{
+		NoiseProperties props{};
+		props.seed = 77;
+		props.roughness = 0.55f;
+		props.marbling = 0.5f;
+		props.turbulence = 40.0f;
+		props.turbulence_res = 1;
+		props.turbulence_roughness = 0.5f;
+		props.turbulence_expshift = 0.5f;
+		props.turbulence_offset_x = 0.2f;
+		props.domain = domain;
+		return props;
+	}
+}
+
+TEST(NoiseRegionTest, ChunksMatchOneLargeWindow)
+{
+	const int res = 64;
+	const NoiseProperties props = MakeRegionProperties(NoiseDomain::Unbounded);
+
+	const int64_t x0 = -150, y0 = -90;
+	const int width = 320, height = 170;
+	std::vector<float> whole((size_t)width * height);
+	NoiseExecution parallel;
+	parallel.threadCount = 0;
+	ASSERT_TRUE(GenerateRegion(res, &props, x0, y0, width, height, whole.data(), width, parallel));
+
+	const auto [lo, hi] = std::minmax_element(whole.begin(), whole.end());
+	EXPECT_GE(*lo, 0.0f);
+	EXPECT_LE(*hi, 1.0f);
+
+	// Chunks written into a larger buffer, like tiles of a streamed terrain
+	const int chunk = 50;
+	const int stride = width + 7;
+	std::vector<float> chunked((size_t)stride * height, -1.0f);
+	for(int cy = 0; cy < height; cy += chunk)
+	{
+		for(int cx = 0; cx < width; cx += chunk)
+		{
+			ASSERT_TRUE(GenerateRegion(res, &props, x0 + cx, y0 + cy, std::min(chunk, width - cx), std::min(chunk, height - cy),
+				chunked.data() + (size_t)cy * stride + cx, stride));
+		}
+	}
+
+	for(int y = 0; y < height; ++y)
+		for(int x = 0; x < width; ++x)
+			ASSERT_EQ(chunked[(size_t)y * stride + x], whole[(size_t)y * width + x]) << "at " << x0 + x << ", " << y0 + y;
+
+	// FBMNoise2D is the window at the origin
+	NoiseImage image = FBMNoise2D(res, &props, nullptr);
+	ASSERT_TRUE(image);
+	for(int y = 0; y < res; ++y)
+		for(int x = 0; x < res; ++x)
+			ASSERT_EQ(image[(size_t)y * res + x], whole[(size_t)(y - y0) * width + (x - x0)]);
+}
+
+TEST(NoiseRegionTest, TiledWindowsRepeatEveryRes)
+{
+	const int res = 32;
+	const NoiseProperties props = MakeRegionProperties(NoiseDomain::Tiled);
+
+	const int width = 45, height = 20;
+	std::vector<float> a((size_t)width * height), b((size_t)width * height);
+	ASSERT_TRUE(GenerateRegion(res, &props, 5, 7, width, height, a.data(), width));
+	ASSERT_TRUE(GenerateRegion(res, &props, 5 + 3 * res, 7 - 2 * res, width, height, b.data(), width));
+	EXPECT_EQ(memcmp(a.data(), b.data(), a.size() * sizeof(float)), 0);
+
+	EXPECT_THROW(GenerateRegion(res, &props, 0, 0, 10, 10, a.data(), 5), std::invalid_argument);
+	EXPECT_TRUE(GenerateRegion(res, &props, 0, 0, 0, 10, nullptr, 0));
+}
+
+TEST(NoiseQueryTest, PointsMatchRegionPixels)
+{
+	const int res = 128;
+	for(NoiseDomain domain : { NoiseDomain::Unbounded, NoiseDomain::Tiled })
+	{
+		NoiseProperties props{};
+		props.seed = 19;
+		props.roughness = 0.6f;
+		props.high_freq_skip = 1;
+		props.marbling = 0.3f;
+		props.domain = domain;
+
+		const int64_t x0 = -70, y0 = -40;
+		const int width = 200, height = 90;
+		std::vector<float> region((size_t)width * height);
+		ASSERT_TRUE(GenerateRegion(res, &props, x0, y0, width, height, region.data(), width));
+
+		// Scattered integer points, a count that leaves a scalar remainder
+		std::vector<float> xs, ys;
+		RandomGenerator rng(3);
+		for(int i = 0; i < 1003; ++i)
+		{
+			xs.push_back((float)(x0 + (int)(rng.NextFloat() * width)));
+			ys.push_back((float)(y0 + (int)(rng.NextFloat() * height)));
+		}
+
+		const NoiseQuery query(res, props);
+		std::vector<float> values(xs.size());
+		query.Sample2D(xs.data(), ys.data(), xs.size(), values.data());
+
+		for(size_t i = 0; i < xs.size(); ++i)
+		{
+			const size_t pixel = (size_t)((int64_t)ys[i] - y0) * width + (size_t)((int64_t)xs[i] - x0);
+			ASSERT_EQ(values[i], region[pixel]) << "at " << xs[i] << ", " << ys[i];
+		}
+	}
+}
+
+TEST(NoiseQueryTest, RejectsPropertiesItCannotMatch)
+{
+	NoiseProperties props{};
+	props.roughness = 0.5f;
+	props.domain = NoiseDomain::Tiled;
+	EXPECT_NO_THROW(NoiseQuery(64, props));
+	EXPECT_THROW(NoiseQuery(0, props), std::invalid_argument);
+	EXPECT_THROW(NoiseQuery(96, props), std::invalid_argument);
+
+	props.domain = NoiseDomain::Unbounded;
+	EXPECT_NO_THROW(NoiseQuery(96, props));
+	props.turbulence = 10.0f;
+	EXPECT_THROW(NoiseQuery(64, props), std::invalid_argument);
+}
+
+TEST(NoiseQueryTest, SimdLevelsAgree)
+{
+	NoiseProperties props{};
+	props.seed = 8;
+	props.roughness = 0.5f;
+	props.domain = NoiseDomain::Unbounded;
+	const NoiseQuery query(256, props);
+
+	std::vector<float> xs, ys, zs;
+	RandomGenerator rng(11);
+	for(int i = 0; i < 77; ++i)
+	{
+		xs.push_back(rng.NextFloat() * 2000.0f - 1000.0f);
+		ys.push_back(rng.NextFloat() * 2000.0f - 1000.0f);
+		zs.push_back(rng.NextFloat() * 300.0f);
+	}
+
+	std::vector<float> reference2D(xs.size()), reference3D(xs.size());
+	SetSimdLevel(SimdLevel::Scalar);
+	query.Sample2D(xs.data(), ys.data(), xs.size(), reference2D.data());
+	query.Sample3D(xs.data(), ys.data(), zs.data(), xs.size(), reference3D.data());
+	SetSimdLevel(GetSupportedSimdLevel());
+
+	std::vector<float> values2D(xs.size()), values3D(xs.size());
+	query.Sample2D(xs.data(), ys.data(), xs.size(), values2D.data());
+	query.Sample3D(xs.data(), ys.data(), zs.data(), xs.size(), values3D.data());
+	EXPECT_EQ(memcmp(reference2D.data(), values2D.data(), xs.size() * sizeof(float)), 0);
+	EXPECT_EQ(memcmp(reference3D.data(), values3D.data(), xs.size() * sizeof(float)), 0);
+
+	for(float value : values3D)
+	{
+		EXPECT_GE(value, 0.0f);
+		EXPECT_LE(value, 1.0f);
+	}
+}
+
+namespace
+{
+	void ExpectPipelineMatchesFBM(NoisePipeline& pipeline, int res, const NoiseProperties& props)
+	{
+		NoiseExecution parallel;
+		parallel.threadCount = 0;
+		NoiseImage expected = FBMNoise2D(res, &props, nullptr);
+		NoiseImage actual = pipeline.Run(res, props, nullptr, parallel);
+		ASSERT_TRUE(expected);
+		ASSERT_TRUE(actual);
+		EXPECT_EQ(memcmp(expected.Data(), actual.Data(), expected.GetBytes()), 0);
+	}
+}
+
+TEST(NoisePipelineTest, EditsOnlyRerunDownstreamStages)
+{
+	using Stage = NoisePipeline::Stage;
+	const int res = 64;
+	NoiseProperties props = MakeRegionProperties(NoiseDomain::Tiled);
+	props.low_freq_skip = 1;
+
+	NoisePipeline pipeline;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Octaves), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Turbulence), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Warp), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Range), 1u);
+
+	// Marbling is applied to the returned image only
+	props.marbling = 2.5f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.marbling = 0.0f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Octaves), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Warp), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Range), 1u);
+
+	// Warp settings keep the octave sum and the fields
+	props.turbulence_offset_y = -0.3f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.turbulence_expshift = 0.0f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Octaves), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Turbulence), 1u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Warp), 3u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Range), 3u);
+
+	// Field settings keep the octave sum, octave settings keep the fields
+	props.turbulence_roughness = 0.7f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.roughness = 0.4f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Octaves), 2u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Turbulence), 2u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Warp), 5u);
+
+	// Without turbulence the sum is normalized directly, turning it back on reuses the warp
+	props.turbulence = 0.0f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.turbulence = 40.0f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Warp), 5u);
+	EXPECT_EQ(pipeline.GetRunCount(Stage::Range), 7u);
+
+	// A canceled run leaves nothing stale behind
+	props.seed++;
+	EXPECT_FALSE(pipeline.Run(res, props, [] (float fraction) { return fraction < 0.2f; }));
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+
+	EXPECT_GT(pipeline.GetCachedBytes(), 0u);
+	pipeline.Reset();
+	EXPECT_EQ(pipeline.GetCachedBytes(), 0u);
+	ExpectPipelineMatchesFBM(pipeline, 32, props);
+}
+
+TEST(NoisePipelineTest, LayerCacheRecombinesOctavesOnRoughnessEdits)
+{
+	const int res = 64;
+	NoiseProperties props = MakeRegionProperties(NoiseDomain::Tiled);
+	props.low_freq_skip = 1;
+	props.high_freq_skip = 1;
+
+	auto layers = std::make_shared<OctaveLayerCache>();
+	NoisePipeline pipeline;
+	pipeline.SetLayerCache(layers);
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	const uint64_t octaves = layers->GetLayerCount();
+	EXPECT_EQ(layers->GetMissCount(), octaves);
+	EXPECT_EQ(layers->GetBytes(), octaves * res * res * sizeof(float));
+
+	// Roughness and narrower skips only weight the cached layers differently
+	props.roughness = 0.8f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.high_freq_skip = 2;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(NoisePipeline::Stage::Octaves), 3u);
+	EXPECT_EQ(layers->GetMissCount(), octaves);
+	EXPECT_EQ(layers->GetLayerCount(), octaves);
+
+	// A newly enabled octave is the only one evaluated
+	props.low_freq_skip = 0;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(layers->GetMissCount(), octaves + 1);
+
+	// Float16 layers round every octave, the sum stays within a small fraction of the range
+	layers->SetPrecision(OctaveLayerCache::Precision::Float16);
+	EXPECT_EQ(layers->GetLayerCount(), 0u);
+	NoiseImage expected = FBMNoise2D(res, &props, nullptr);
+	NoiseImage half = pipeline.Run(res, props);
+	ASSERT_TRUE(half);
+	for(size_t i = 0; i < half.GetCount(); i++)
+		ASSERT_NEAR(half[i], expected[i], 2e-3f);
+	EXPECT_EQ(layers->GetBytes(), layers->GetLayerCount() * res * res * sizeof(uint16_t));
+
+	// Cached or not, Float16 sums are the same
+	props.roughness = 0.5f;
+	NoiseImage recombined = pipeline.Run(res, props);
+	layers->Clear();
+	pipeline.Reset();
+	NoiseImage fresh = pipeline.Run(res, props);
+	ASSERT_TRUE(recombined);
+	ASSERT_TRUE(fresh);
+	EXPECT_EQ(memcmp(recombined.Data(), fresh.Data(), fresh.GetBytes()), 0);
+
+	// Pressure on the memory tracker evicts layers
+	const uint64_t cached = layers->GetBytes();
+	EXPECT_GE(MemoryTracker::Get().Reclaim(cached / 2), cached / 2);
+	EXPECT_LT(layers->GetBytes(), cached);
+}
+
+TEST(NoisePipelineTest, LayerCacheNeverEvictsTheStackItSums)
+{
+	const int res = 64;
+	NoiseProperties props = MakeRegionProperties(NoiseDomain::Tiled);
+
+	auto layers = std::make_shared<OctaveLayerCache>();
+	NoisePipeline pipeline;
+	pipeline.SetLayerCache(layers);
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	const uint64_t octaves = layers->GetLayerCount();
+	const uint64_t stackBytes = layers->GetBytes();
+
+	// Room for exactly one stack: a second seed replaces the first one, edits of it hit every layer
+	layers->SetCapacity(stackBytes);
+	props.seed += 1;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.roughness = 0.7f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(layers->GetLayerCount(), octaves);
+	EXPECT_EQ(layers->GetMissCount(), 2 * octaves);
+	EXPECT_EQ(layers->GetHitCount(), octaves);
+
+	// A stack that does not fit is summed directly, nothing is stored or evicted
+	layers->SetCapacity(stackBytes - 1);
+	layers->Clear();
+	props.roughness = 0.6f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(layers->GetLayerCount(), 0u);
+	EXPECT_EQ(layers->GetMissCount(), 2 * octaves);
+}
+
+TEST(NoisePipelineTest, UnboundedCachesRegionBeforeMarbling)
+{
+	const int res = 64;
+	NoiseProperties props = MakeRegionProperties(NoiseDomain::Unbounded);
+
+	NoisePipeline pipeline;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.marbling = 3.0f;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	EXPECT_EQ(pipeline.GetRunCount(NoisePipeline::Stage::Region), 1u);
+
+	// No enabled octaves: zeros, never marbled
+	props.low_freq_skip = 20;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+	props.domain = NoiseDomain::Tiled;
+	ExpectPipelineMatchesFBM(pipeline, res, props);
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "Memory/BufferPool.h"
+#include "Memory/MemoryTracker.h"
+#include "Noise/NoiseGenerator.h"
+#include "Noise/NoiseImage.h"
+
+TEST(BufferPoolTest, BucketsHaveAtMostQuarterSlack)
+{
+	EXPECT_EQ(BufferPool::GetBucketBytes(1), BufferPool::MinBucketBytes);
+	EXPECT_EQ(BufferPool::GetBucketBytes(4096), 4096u);
+	EXPECT_EQ(BufferPool::GetBucketBytes(4097), 5120u);
+	EXPECT_EQ(BufferPool::GetBucketBytes(1 << 20), 1u << 20);
+	EXPECT_EQ(BufferPool::GetBucketBytes(3 << 20), 3u << 20);
+	EXPECT_EQ(BufferPool::GetBucketBytes(4000000), 4194304u);
+
+	for(size_t bytes = 5000; bytes < (64u << 20); bytes = bytes * 3 / 2 + 7)
+	{
+		const size_t bucket = BufferPool::GetBucketBytes(bytes);
+		EXPECT_GE(bucket, bytes);
+		EXPECT_LE(bucket, bytes + bytes / 4);
+		EXPECT_EQ(bucket % BufferPool::Alignment, 0u);
+	}
+}
+
+TEST(NoiseImageTest, BufferIsAlignedTrackedAndRecycled)
+{
+	MemoryTracker& tracker = MemoryTracker::Get();
+	BufferPool& pool = BufferPool::Get();
+	const int64_t before = tracker.GetCurrentBytes();
+
+	const float* first = nullptr;
+	{
+		NoiseImage image(100, 30, 1, true);
+		ASSERT_TRUE(image);
+		EXPECT_EQ(image.GetCount(), 3000u);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(image.Data()) % BufferPool::Alignment, 0u);
+		EXPECT_EQ(image[2999], 0.0f);
+		EXPECT_EQ(tracker.GetCurrentBytes(), before + (int64_t)BufferPool::GetBucketBytes(image.GetBytes()));
+		first = image.Data();
+		image[0] = 5.0f;
+	}
+	EXPECT_EQ(tracker.GetCurrentBytes(), before);
+
+	// Same size class: the idle block comes back, zero filled again on request
+	const uint64_t hits = pool.GetHitCount();
+	NoiseImage again(120, 25, 1, true);
+	EXPECT_EQ(again.Data(), first);
+	EXPECT_EQ(again[0], 0.0f);
+	EXPECT_EQ(pool.GetHitCount(), hits + 1);
+}
+
+TEST(NoiseImageTest, MoveAndClone)
+{
+	NoiseImage image(8, 4, 2);
+	ASSERT_TRUE(image);
+	for(size_t i = 0; i < image.GetCount(); ++i)
+		image[i] = (float)i;
+
+	NoiseImage moved = std::move(image);
+	EXPECT_TRUE(image.IsEmpty());
+	EXPECT_EQ(image.GetCount(), 0u);
+	EXPECT_EQ(moved.GetDepth(), 2);
+
+	const NoiseImage copy = moved.Clone();
+	ASSERT_TRUE(copy);
+	EXPECT_NE(copy.Data(), moved.Data());
+	EXPECT_EQ(memcmp(copy.Data(), moved.Data(), moved.GetBytes()), 0);
+
+	moved.Reset();
+	EXPECT_FALSE(moved);
+	EXPECT_TRUE(NoiseImage(0, 16).IsEmpty());
+}
+
+TEST(NoiseImageTest, RegenerationDoesNotAllocate)
+{
+	NoiseProperties props{};
+	props.seed = 5;
+	props.roughness = 0.5f;
+	props.turbulence = 0.5f;
+	props.turbulence_res = 2;
+	props.turbulence_roughness = 0.5f;
+
+	// Like the GUI: the previous result is held while the next one is generated
+	NoiseImage current = NG::FBMNoise2D(128, &props, nullptr);
+	ASSERT_TRUE(current);
+	const std::vector<float> first(current.Data(), current.Data() + current.GetCount());
+	current = NG::FBMNoise2D(128, &props, nullptr);
+
+	const uint64_t misses = BufferPool::Get().GetMissCount();
+	for(int i = 0; i < 3; ++i)
+	{
+		current = NG::FBMNoise2D(128, &props, nullptr);
+		ASSERT_TRUE(current);
+	}
+
+	// The image, its warp copy and both turbulence fields all came from released blocks
+	EXPECT_EQ(BufferPool::Get().GetMissCount(), misses);
+	EXPECT_EQ(memcmp(first.data(), current.Data(), current.GetBytes()), 0);
+}
+
+TEST(BufferPoolTest, CapacityLimitsIdleBlocks)
+{
+	BufferPool& pool = BufferPool::Get();
+	pool.Trim();
+	EXPECT_EQ(pool.GetPooledBytes(), 0u);
+
+	NoiseImage(256, 256);
+	EXPECT_EQ(pool.GetPooledBytes(), 256u * 256u * sizeof(float));
+
+	pool.SetCapacity(0);
+	EXPECT_EQ(pool.GetPooledBytes(), 0u);
+	NoiseImage(256, 256);
+	EXPECT_EQ(pool.GetPooledBytes(), 0u);
+
+	pool.SetCapacity(BufferPool::DefaultCapacity);
+}
+
+TEST(BufferPoolTest, HugePageModes)
+{
+	HugePageMode mode = HugePageMode::Off;
+	EXPECT_TRUE(BufferPool::ParseHugePageMode("explicit", mode));
+	EXPECT_EQ(mode, HugePageMode::Explicit);
+	EXPECT_FALSE(BufferPool::ParseHugePageMode("2mb", mode));
+	EXPECT_STREQ(BufferPool::GetHugePageModeName(HugePageMode::Advise), "advise");
+
+	BufferPool& pool = BufferPool::Get();
+	for(HugePageMode hugePages : { HugePageMode::Advise, HugePageMode::Explicit })
+	{
+		pool.SetHugePageMode(hugePages);
+		const uint64_t before = pool.GetHugePageBytes();
+		{
+			// 9 MB: above HugePageMinBytes
+			NoiseImage image(1536, 1536, 1, true);
+			ASSERT_TRUE(image);
+			EXPECT_EQ(reinterpret_cast<uintptr_t>(image.Data()) % BufferPool::Alignment, 0u);
+			EXPECT_EQ(image[image.GetCount() - 1], 0.0f);
+			image[0] = 1.0f;
+#if defined(__linux__)
+			EXPECT_EQ(pool.GetHugePageBytes(), before + BufferPool::GetBucketBytes(image.GetBytes()));
+#endif
+		}
+
+		// Small buffers stay on regular pages
+		NoiseImage small(64, 64);
+		EXPECT_LE(pool.GetHugePageBytes() - before, (uint64_t)BufferPool::GetBucketBytes(1536u * 1536u * sizeof(float)));
+	}
+
+	// Switching the mode frees the idle blocks of the old one
+	pool.SetHugePageMode(HugePageMode::Off);
+	EXPECT_EQ(pool.GetHugePageBytes(), 0u);
+	EXPECT_EQ(pool.GetPooledBytes(), 0u);
+}
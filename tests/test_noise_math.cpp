@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
 #include "Noise/NoiseMath.h"
+#include "Utils/HalfFloat.h"
+#include "Utils/HashRandom.h"
+#include <cmath>
 #include <algorithm>
+#include <vector>
 
 // Distance test
 TEST(NoiseMathTest, ZeroDistance)
@@ -53,6 +57,38 @@ TEST(NoiseMathTest, CalcIndex3D_Basic)
 	EXPECT_EQ(NG::CalcIndex3D(0, 0, -1, 4), 3 * 16);
 }
 
+TEST(NoiseMathTest, CalcIndex_PowerOfTwoMatchesGeneric)
+{
+	for(int res : { 1, 2, 8, 64 })
+	{
+		ASSERT_TRUE(NG::IsPowerOfTwo(res));
+		for(int x = -3 * res; x < 3 * res; ++x)
+		{
+			ASSERT_EQ(NG::CalcIndex1D<true>(x, res), NG::CalcIndex1D(x, res));
+			ASSERT_EQ(NG::CalcIndex2D<true>(x, 1 - x, res), NG::CalcIndex2D(x, 1 - x, res));
+			ASSERT_EQ(NG::CalcIndex3D<true>(x, -x, x + 2, res), NG::CalcIndex3D(x, -x, x + 2, res));
+		}
+	}
+
+	EXPECT_FALSE(NG::IsPowerOfTwo(0));
+	EXPECT_FALSE(NG::IsPowerOfTwo(12));
+}
+
+TEST(NoiseMathTest, PaddedLattice_BorderWraps)
+{
+	const int freq = 6;
+	NG::PaddedLattice2D lattice;
+	lattice.Resize(freq);
+	for(int y = 0; y < freq; ++y)
+		for(int x = 0; x < freq; ++x)
+			lattice.Row(y)[x] = (float)(x + y * freq);
+	lattice.WrapBorders();
+
+	for(int y = -1; y <= freq + 1; ++y)
+		for(int x = -1; x <= freq + 1; ++x)
+			ASSERT_EQ(lattice.Row(y)[x], (float)NG::CalcIndex2D(x, y, freq)) << x << ", " << y;
+}
+
 TEST(NoiseMathTest, Interpolate1D_Linear)
 {
 	float data[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
@@ -180,4 +216,131 @@ TEST(PerfTest, Interpolate3D_Speed)
 		float res = NG::Interpolate3D(data, 0.3f, 0.4f, 0.5f);
 		(void)res;
 	}
-}
\ No newline at end of file
+}
+
+TEST(NoiseMathTest, BSplineWeights_MatchInterpolate1D)
+{
+	float data[4] = { 0.3f, 0.9f, 0.1f, 0.7f };
+
+	for(float xf : { 0.0f, 0.125f, 0.5f, 0.77f, 0.999f })
+	{
+		float w[4];
+		NG::BSplineWeights(xf, w);
+		float weighted = (data[0] * w[0] + data[1] * w[1] + data[2] * w[2] + data[3] * w[3]) / 6.0f;
+		EXPECT_EQ(weighted, NG::Interpolate1D(data, xf));
+	}
+}
+
+TEST(NoiseMathTest, SeparableBSpline_MatchesInterpolate2D)
+{
+	const int freq = 4;
+	const int res = 19;
+	float lattice[freq * freq];
+	for(int i = 0; i < freq * freq; ++i) lattice[i] = static_cast<float>((i * 31) % 17) / 17.0f;
+
+	NG::BSplineColumns axis;
+	axis.Build(0, res, freq, res);
+
+	for(NG::SimdLevel level : { NG::SimdLevel::Scalar, NG::SimdLevel::SSE2, NG::SimdLevel::AVX2 })
+	{
+		std::vector<float> alongX(freq * res);
+		for(int row = 0; row < freq; ++row)
+			NG::InterpolateBSplineX(level, lattice + row * freq, axis, 0, res, alongX.data() + row * res);
+
+		for(int y = 0; y < res; ++y)
+		{
+			const float* rows[4];
+			float wy[4];
+			for(int k = 0; k < 4; ++k)
+			{
+				rows[k] = alongX.data() + axis.taps[k * res + y] * res;
+				wy[k] = axis.weights[k * res + y];
+			}
+
+			std::vector<float> out(res);
+			NG::InterpolateBSplineY(level, rows, wy, res, out.data());
+
+			for(int x = 0; x < res; ++x)
+			{
+				const int x3 = (x * freq) / res - 1;
+				const int y3 = (y * freq) / res - 1;
+				float tmp[16];
+				for(int y2 = 0; y2 < 4; ++y2)
+					for(int x2 = 0; x2 < 4; ++x2)
+						tmp[x2 + y2 * 4] = lattice[NG::CalcIndex2D(x2 + x3, y2 + y3, freq)];
+
+				float xf = (float)(x * freq) / res;
+				float yf = (float)(y * freq) / res;
+				xf -= floorf(xf);
+				yf -= floorf(yf);
+
+				ASSERT_EQ(out[x], NG::Interpolate2D(tmp, xf, yf)) << "level " << static_cast<int>(level);
+			}
+		}
+	}
+}
+
+TEST(NoiseMathTest, AccumulateScaled_AllLevelsMatchScalar)
+{
+	// 37 values: vector bodies and scalar tails; halves of small, subnormal, large and out of range values
+	const int count = 37;
+	std::vector<float> values(count);
+	for(int i = 0; i < count; ++i)
+		values[i] = (i % 2 ? -1.0f : 1.0f) * std::ldexp(1.0f + i / 7.0f, i - 30);
+	values[3] = 70000.0f;
+
+	std::vector<uint16_t> halves(count);
+	for(int i = 0; i < count; ++i)
+		halves[i] = HalfFloat::FromFloat(values[i]);
+
+	for(NG::SimdLevel level : { NG::SimdLevel::Scalar, NG::SimdLevel::SSE2, NG::SimdLevel::AVX2 })
+	{
+		std::vector<uint16_t> converted(count);
+		NG::ConvertToHalf(level, values.data(), count, converted.data());
+		EXPECT_EQ(converted, halves) << "level " << static_cast<int>(level);
+
+		std::vector<float> acc(count, 0.25f), accHalf(count, 0.25f);
+		NG::AccumulateScaled(level, values.data(), count, 0.3f, acc.data());
+		NG::AccumulateScaledHalf(level, halves.data(), count, 0.3f, accHalf.data());
+		for(int i = 0; i < count; ++i)
+		{
+			ASSERT_EQ(acc[i], 0.25f + values[i] * 0.3f) << "level " << static_cast<int>(level);
+			ASSERT_EQ(accHalf[i], 0.25f + HalfFloat::ToFloat(halves[i]) * 0.3f) << "level " << static_cast<int>(level);
+		}
+	}
+}
+
+// Hash RNG tests
+TEST(HashRandomTest, FillRowMatchesPointValues)
+{
+	std::vector<float> row(257);
+	HashRandom::FillRow(42u, 7u, (int)row.size(), row.data());
+	for(int x = 0; x < (int)row.size(); ++x)
+		ASSERT_EQ(row[x], HashRandom::Float(42u, x, 7u));
+
+	HashRandom::FillRow(42u, 7u, 3u, (int)row.size(), row.data());
+	for(int x = 0; x < (int)row.size(); ++x)
+		ASSERT_EQ(row[x], HashRandom::Float(42u, x, 7u, 3u));
+}
+
+TEST(HashRandomTest, ValuesAreUniformInUnitRange)
+{
+	const int count = 1 << 16;
+	double sum = 0.0;
+	int buckets[16] = {};
+	for(int i = 0; i < count; ++i)
+	{
+		const float v = HashRandom::Float(1234u, i);
+		ASSERT_GE(v, 0.0f);
+		ASSERT_LT(v, 1.0f);
+		sum += v;
+		buckets[static_cast<int>(v * 16.0f)]++;
+	}
+
+	EXPECT_NEAR(sum / count, 0.5, 0.01);
+	for(int bucket : buckets)
+		EXPECT_NEAR(bucket, count / 16, count / 160);
+
+	EXPECT_NE(HashRandom::Float(1u, 0u, 0u), HashRandom::Float(2u, 0u, 0u));
+	EXPECT_NE(HashRandom::Float(1u, 1u, 0u), HashRandom::Float(1u, 0u, 1u));
+}
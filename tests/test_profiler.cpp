@@ -0,0 +1,118 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "Noise/NoiseGenerator.h"
+#include "Profiling/Profiler.h"
+#include "Profiling/TraceRecorder.h"
+
+namespace
+{
+	const ProfileStageStats* FindStage(const std::vector<ProfileStageStats>& stages, const std::string& name)
+	{
+		auto found = std::find_if(stages.begin(), stages.end(),
+			[&] (const ProfileStageStats& stage) { return stage.name == name; });
+		return found == stages.end() ? nullptr : &*found;
+	}
+}
+
+TEST(ProfilerTest, NestedStagesRecordPathsAndPropagateBytes)
+{
+	Profiler::Get().Reset();
+	{
+		ScopedStageTimer outer("Outer", 100);
+		{
+			ScopedStageTimer inner("Inner");
+			ScopedStageTimer::AddAllocatedBytes(3 * 1024 * 1024);
+		}
+		ScopedStageTimer::AddAllocatedBytes(1024 * 1024);
+	}
+	Profiler::Get().AddCounter("Events", 2);
+	Profiler::Get().AddCounter("Events", 3);
+
+	const std::vector<ProfileStageStats> stages = Profiler::Get().GetStages();
+	const ProfileStageStats* outer = FindStage(stages, "Outer");
+	const ProfileStageStats* inner = FindStage(stages, "Outer/Inner");
+	ASSERT_NE(outer, nullptr);
+	ASSERT_NE(inner, nullptr);
+	EXPECT_EQ(outer->calls, 1u);
+	EXPECT_FLOAT_EQ(inner->megabytesAllocated[inner->Latest()], 3.0f);
+	EXPECT_FLOAT_EQ(outer->megabytesAllocated[outer->Latest()], 4.0f);
+	EXPECT_EQ(Profiler::Get().GetCounters().at("Events"), 5);
+
+	Profiler::Get().Reset();
+	EXPECT_TRUE(Profiler::Get().GetStages().empty());
+}
+
+TEST(ProfilerTest, HistoryWrapsAfterHistoryLengthCalls)
+{
+	Profiler::Get().Reset();
+	for(int i = 0; i < ProfileStageStats::HistoryLength + 5; ++i)
+		Profiler::Get().RecordStage("Ring", static_cast<double>(i), 0, 0);
+
+	const ProfileStageStats* ring = FindStage(Profiler::Get().GetStages(), "Ring");
+	ASSERT_NE(ring, nullptr);
+	EXPECT_EQ(ring->historyCount, ProfileStageStats::HistoryLength);
+	EXPECT_EQ(ring->historyOffset, 5);
+	EXPECT_FLOAT_EQ(ring->milliseconds[ring->Latest()], static_cast<float>(ProfileStageStats::HistoryLength + 4));
+	Profiler::Get().Reset();
+}
+
+TEST(ProfilerTest, GeneratorReportsItsStages)
+{
+	if(!Profiler::bEnabled)
+		GTEST_SKIP() << "NOISE_ENABLE_PROFILING is off";
+
+	Profiler::Get().Reset();
+	NoiseProperties props{};
+	props.seed = 7;
+	props.roughness = 0.5f;
+	NG::FBMNoise2D(64, &props, nullptr);
+
+	const std::vector<ProfileStageStats> stages = Profiler::Get().GetStages();
+	ASSERT_NE(FindStage(stages, "FBMNoise2D"), nullptr);
+	EXPECT_NE(FindStage(stages, "FBMNoise2D/Octaves"), nullptr);
+	EXPECT_NE(FindStage(stages, "FBMNoise2D/Normalize"), nullptr);
+	EXPECT_EQ(Profiler::Get().GetCounters().at("FBMNoise2D calls"), 1);
+	Profiler::Get().Reset();
+}
+
+TEST(TraceRecorderTest, WritesStagesAndBandsAsChromeTrace)
+{
+	if(!Profiler::bEnabled)
+		GTEST_SKIP() << "NOISE_ENABLE_PROFILING is off";
+
+	TraceRecorder& recorder = TraceRecorder::Get();
+	recorder.Start();
+	{
+		NG_TRACE_SCOPE("Test \"quoted\"");
+		NoiseProperties props{};
+		props.seed = 7;
+		props.roughness = 0.5f;
+		NoiseExecution exec;
+		exec.threadCount = 2;
+		NG::FBMNoise2D(64, &props, nullptr, exec);
+	}
+	recorder.Stop();
+
+	const size_t eventCount = recorder.GetEventCount();
+	EXPECT_GT(eventCount, 0u);
+	const NoiseProperties idleProps{};
+	NG::FBMNoise2D(16, &idleProps, nullptr);
+	EXPECT_EQ(recorder.GetEventCount(), eventCount);
+
+	const std::string path = (std::filesystem::temp_directory_path() / "ng_test_trace.json").string();
+	ASSERT_TRUE(recorder.WriteChromeTrace(path));
+
+	std::ifstream file(path);
+	const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+	EXPECT_NE(json.find("\"name\":\"FBMNoise2D\",\"cat\":\"stage\",\"ph\":\"X\""), std::string::npos);
+	EXPECT_NE(json.find("\"name\":\"FBMNoise2D/Octaves band\",\"cat\":\"band\""), std::string::npos);
+	EXPECT_NE(json.find("Test \\\"quoted\\\""), std::string::npos);
+	EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+
+	file.close();
+	std::filesystem::remove(path);
+}